@@ -28,6 +28,10 @@ void loop()
 
 void initHueBridge()
 {
+  // restore the lights as they were before a restart, also those added
+  // later on, uses the huestate partition of partitions.csv
+  hueBridge.persistState();
+
   // setup device name for Amazon Echo
   hueBridge.addDevice("nuclear reactor");
   hueBridge.onSetState(handle_SetState);
@@ -0,0 +1,223 @@
+#include "DeviceRegistry.h"
+#include <string.h>
+#include <stdio.h>
+
+DeviceRegistry::DeviceRegistry()
+{
+    memset(_index, 0, sizeof(_index));
+    memset(_generation, 0, sizeof(_generation));
+    for (int i = 0; i < HUE_MAX_DEVICES; i++)
+    {
+        _published[i].sequence.store(0);
+        _published[i].words[0].store(0);
+        _published[i].words[1].store(0);
+        _published[i].words[2].store(0);
+    }
+}
+
+unsigned char DeviceRegistry::add(const char * name, unsigned char id)
+{
+    size_t length = strlen(name);
+    if (_count >= HUE_MAX_DEVICES || length > 0xFF || _names.size() + length + 1 > 0xFFFF)
+    {
+        return HUE_INVALID_DEVICE;
+    }
+
+    if (id == HUE_INVALID_DEVICE)
+    {
+        // reuse the first removed slot
+        id = 0;
+        while (id < _devices.size() && _devices[id].used)
+        {
+            id++;
+        }
+    }
+    else if (id >= HUE_MAX_DEVICES || contains(id))
+    {
+        return HUE_INVALID_DEVICE;
+    }
+    while (id >= _devices.size())
+    {
+        _devices.push_back(device_t());
+    }
+
+    device_t& device = _devices[id];
+    memset(&device, 0, sizeof(device_t));
+    device.nameHash = hash(name);
+    device.nameOffset = _names.size();
+    device.nameLength = length;
+    device.used = true;
+    _names.insert(_names.end(), name, name + length + 1);
+
+    insertIndex(id);
+    _count++;
+    return id;
+}
+
+bool DeviceRegistry::remove(unsigned char id)
+{
+    if (!contains(id))
+    {
+        return false;
+    }
+
+    // close the gap in the string pool and move the names behind it
+    uint16_t offset = _devices[id].nameOffset;
+    uint16_t length = _devices[id].nameLength + 1;
+    _names.erase(_names.begin() + offset, _names.begin() + offset + length);
+    for (unsigned char i = 0; i < _devices.size(); i++)
+    {
+        if (_devices[i].used && _devices[i].nameOffset > offset)
+        {
+            _devices[i].nameOffset -= length;
+        }
+    }
+
+    _devices[id].used = false;
+    _generation[id]++;
+    while (!_devices.empty() && !_devices.back().used)
+    {
+        _devices.pop_back();
+    }
+    _count--;
+    rebuildIndex();
+    return true;
+}
+
+void DeviceRegistry::store(unsigned char id, const device_t & state)
+{
+    device_t& device = _devices[id];
+    device.state = state.state;
+    device.bri = state.bri;
+    device.ct = state.ct;
+    device.hue = state.hue;
+    device.sat = state.sat;
+    device.mode = state.mode;
+    device.x = state.x;
+    device.y = state.y;
+
+    // the words are release stores, a reader that sees one of them also
+    // sees the odd sequence stored before it
+    published_state_t& published = _published[id];
+    uint32_t sequence = published.sequence.load(std::memory_order_relaxed);
+    published.sequence.store(sequence + 1, std::memory_order_relaxed);
+    published.words[0].store((uint32_t)state.hue | ((uint32_t)(uint16_t)state.ct << 16), std::memory_order_release);
+    published.words[1].store((uint32_t)state.bri | ((uint32_t)state.sat << 8) | ((uint32_t)state.state << 16) | ((uint32_t)(uint8_t)state.mode << 24), std::memory_order_release);
+    published.words[2].store((uint32_t)state.x | ((uint32_t)state.y << 16), std::memory_order_release);
+    published.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+/*
+    Reads the published words until no write overlapped the read. The words
+    are acquire loads, so the second load of the sequence can not move ahead
+    of them, which is what the seqlock needs without a fence. The name
+    fields are copied from the device, they do not change while serving.
+*/
+device_t DeviceRegistry::snapshot(unsigned char id) const
+{
+    const device_t& stored = _devices[id];
+    device_t device;
+    memset(&device, 0, sizeof(device));
+    device.nameHash = stored.nameHash;
+    device.nameOffset = stored.nameOffset;
+    device.nameLength = stored.nameLength;
+    device.used = stored.used;
+
+    const published_state_t& published = _published[id];
+    uint32_t before, after, words[3];
+    do
+    {
+        before = published.sequence.load(std::memory_order_acquire);
+        words[0] = published.words[0].load(std::memory_order_acquire);
+        words[1] = published.words[1].load(std::memory_order_acquire);
+        words[2] = published.words[2].load(std::memory_order_acquire);
+        after = published.sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+
+    device.hue = words[0] & 0xFFFF;
+    device.ct = (int16_t)(words[0] >> 16);
+    device.bri = words[1] & 0xFF;
+    device.sat = (words[1] >> 8) & 0xFF;
+    device.state = (words[1] >> 16) & 0xFF;
+    device.mode = (char)(words[1] >> 24);
+    device.x = words[2] & 0xFFFF;
+    device.y = words[2] >> 16;
+    return device;
+}
+
+unsigned char DeviceRegistry::find(const char * name) const
+{
+    uint32_t h = hash(name);
+    for (unsigned int i = 0; i < sizeof(_index); i++)
+    {
+        uint8_t slot = _index[(h + i) % sizeof(_index)];
+        if (slot == 0)
+        {
+            break;
+        }
+        const device_t& device = _devices[slot - 1];
+        if (device.nameHash == h && strcmp(&_names[device.nameOffset], name) == 0)
+        {
+            return slot - 1;
+        }
+    }
+    return HUE_INVALID_DEVICE;
+}
+
+/*
+    uniqueid in the format the Hue bridge uses, the MAC address followed by
+    the generation of the slot and the id of the light: F0:08:D1:D2:CB:4C:00:00-00
+
+    The generation of a slot goes up when its light is removed, so a light
+    added into the slot of a removed one does not take over its uniqueid and
+    Alexa does not treat it as the removed light. A slot that was never freed
+    has generation 0, which is the uniqueid lights always had.
+*/
+void DeviceRegistry::uniqueId(unsigned char id, char * buffer, size_t size) const
+{
+    snprintf(buffer, size, "%02X:%02X:%02X:%02X:%02X:%02X:00:%02X-%02X",
+        _mac[0], _mac[1], _mac[2], _mac[3], _mac[4], _mac[5], _generation[id], id);
+}
+
+void DeviceRegistry::setMacAddress(const uint8_t * mac)
+{
+    memcpy(_mac, mac, sizeof(_mac));
+}
+
+uint32_t DeviceRegistry::hash(const char * name)
+{
+    uint32_t h = 2166136261UL;
+    while (*name)
+    {
+        h ^= (uint8_t)*name++;
+        h *= 16777619UL;
+    }
+    return h;
+}
+
+void DeviceRegistry::insertIndex(unsigned char id)
+{
+    uint32_t h = _devices[id].nameHash;
+    for (unsigned int i = 0; i < sizeof(_index); i++)
+    {
+        uint8_t& slot = _index[(h + i) % sizeof(_index)];
+        if (slot == 0)
+        {
+            slot = id + 1;
+            return;
+        }
+    }
+}
+
+// open addressing has no cheap delete, the table is small enough to rebuild
+void DeviceRegistry::rebuildIndex()
+{
+    memset(_index, 0, sizeof(_index));
+    for (unsigned char i = 0; i < _devices.size(); i++)
+    {
+        if (_devices[i].used)
+        {
+            insertIndex(i);
+        }
+    }
+}
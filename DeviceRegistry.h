@@ -0,0 +1,99 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <stdint.h>
+#include <stddef.h>
+
+// The Hue API does not allow more than 63 lights on one bridge
+#define HUE_MAX_DEVICES         63
+#define HUE_INVALID_DEVICE      0xFF
+
+/*
+    State of one light, packed into 20 bytes. The name lives in the
+    registry's string pool and the uniqueid is derived from the MAC address
+    and the id whenever it is needed.
+*/
+typedef struct {
+    uint32_t nameHash;      // FNV-1a of the name, used for lookups by name
+    uint16_t nameOffset;    // start of the name in the string pool
+    uint8_t nameLength;
+    bool used;              // false once the device has been removed
+    uint16_t hue;
+    int16_t ct;
+    uint8_t bri;
+    uint8_t sat;
+    bool state;
+    char mode;
+    uint16_t x;             // CIE xy in ten-thousandths, see HueColor.h
+    uint16_t y;
+} device_t;
+
+// state of a light published for other threads, see DeviceRegistry::snapshot
+typedef struct {
+    std::atomic<uint32_t> sequence;     // odd while the state is being written
+    std::atomic<uint32_t> words[3];     // hue, ct / bri, sat, state, mode / x, y
+} published_state_t;
+
+/*
+    Registry of the emulated lights. The id of a light is its slot, so lookups
+    by id are an index, and lookups by name go through a small open addressing
+    table keyed on the name hash. Removed slots are reused by the next add,
+    under a new uniqueid.
+
+    Cost per device is the 20 byte device_t, the name plus its terminator in
+    the pool, the generation byte of its slot and one byte in the hash table,
+    which is sized for 63 devices (128 bytes). The serialized json that
+    HueBridge caches per light comes on top of that (about 350 bytes plus the
+    name).
+
+    The state of each light is also published through a seqlock so that
+    other threads or the other core can take a consistent snapshot() without
+    a lock while it is being changed. store() is the only writer of the
+    state, the callers serialize their calls to it. Lights are added and
+    removed before the bridge starts serving, the rest of the device_t does
+    not change afterwards.
+*/
+class DeviceRegistry
+{
+    public:
+        DeviceRegistry();
+
+        // adds the light into the first free slot, or into slot id when it is free
+        unsigned char add(const char * name, unsigned char id = HUE_INVALID_DEVICE);
+        bool remove(unsigned char id);
+        unsigned char find(const char * name) const;
+
+        bool contains(unsigned char id) const { return id < _devices.size() && _devices[id].used; }
+        device_t& operator[](unsigned char id) { return _devices[id]; }
+        const device_t& operator[](unsigned char id) const { return _devices[id]; }
+
+        // sets the state fields of a light, calls must not overlap
+        void store(unsigned char id, const device_t & state);
+        // copy of a light with its latest stored state, from any thread, never blocks
+        device_t snapshot(unsigned char id) const;
+
+        const char * name(unsigned char id) const { return &_names[_devices[id].nameOffset]; }
+        void uniqueId(unsigned char id, char * buffer, size_t size) const;
+        // lights removed from a slot, kept by the journal across restarts
+        uint8_t generation(unsigned char id) const { return _generation[id]; }
+        void setGeneration(unsigned char id, uint8_t generation) { _generation[id] = generation; }
+        void setMacAddress(const uint8_t * mac);
+
+        // ids run from 0 to size() - 1, check contains() for removed slots
+        unsigned char size() const { return _devices.size(); }
+        unsigned char count() const { return _count; }
+
+    private:
+        std::vector<device_t> _devices;
+        std::vector<char> _names;           // string pool, names are stored with their terminator
+        published_state_t _published[HUE_MAX_DEVICES];
+        uint8_t _index[128];                // slot + 1 of the device per hash bucket, 0 when empty
+        uint8_t _generation[HUE_MAX_DEVICES];   // lights removed from each slot, part of the uniqueid
+        uint8_t _mac[6] = {0};
+        unsigned char _count = 0;
+
+        static uint32_t hash(const char * name);
+        void rebuildIndex();
+        void insertIndex(unsigned char id);
+};
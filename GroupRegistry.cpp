@@ -0,0 +1,74 @@
+#include "GroupRegistry.h"
+
+unsigned char GroupRegistry::addGroup(const char * name, uint64_t lights)
+{
+    if (_groups.size() >= HUE_MAX_GROUPS)
+    {
+        return HUE_INVALID_DEVICE;
+    }
+
+    group_t group;
+    group.name = name;
+    group.lights = lights;
+    group.used = true;
+    _groups.push_back(group);
+    return _groups.size();
+}
+
+bool GroupRegistry::removeGroup(unsigned char id)
+{
+    if (!containsGroup(id))
+    {
+        return false;
+    }
+
+    _groups[id - 1].used = false;
+    _groups[id - 1].name = "";
+    _groups[id - 1].lights = 0;
+    // a scene does not outlive its group
+    for (size_t i = 0; i < _scenes.size(); i++)
+    {
+        if (_scenes[i].used && _scenes[i].group == id)
+        {
+            _scenes[i].used = false;
+            _scenes[i].lights.clear();
+        }
+    }
+    return true;
+}
+
+unsigned char GroupRegistry::addScene(const char * name, unsigned char group, const std::vector<scene_light_t> & lights)
+{
+    if (_scenes.size() >= HUE_MAX_SCENES || (group != 0 && !containsGroup(group)))
+    {
+        return HUE_INVALID_DEVICE;
+    }
+
+    scene_t scene;
+    scene.name = name;
+    scene.group = group;
+    scene.lights = lights;
+    scene.used = true;
+    _scenes.push_back(scene);
+    return _scenes.size();
+}
+
+void GroupRegistry::removeLight(unsigned char id)
+{
+    for (size_t i = 0; i < _groups.size(); i++)
+    {
+        _groups[i].lights &= ~(1ULL << id);
+    }
+    for (size_t i = 0; i < _scenes.size(); i++)
+    {
+        std::vector<scene_light_t> & lights = _scenes[i].lights;
+        for (size_t j = 0; j < lights.size(); j++)
+        {
+            if (lights[j].id == id)
+            {
+                lights.erase(lights.begin() + j);
+                break;
+            }
+        }
+    }
+}
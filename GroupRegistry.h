@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+#include "WString.h"
+#include "DeviceRegistry.h"
+
+#define HUE_MAX_GROUPS          16
+#define HUE_MAX_SCENES          16
+
+// light state that a scene restores
+typedef struct {
+    uint8_t id;
+    bool state;
+    uint8_t bri;
+    uint8_t sat;
+    uint16_t hue;
+    int16_t ct;
+    char mode;
+    uint16_t x;
+    uint16_t y;
+} scene_light_t;
+
+typedef struct {
+    String name;
+    uint64_t lights;        // bit n is set when light n belongs to the group
+    bool used;              // false once the group has been removed
+} group_t;
+
+typedef struct {
+    String name;
+    unsigned char group;
+    std::vector<scene_light_t> lights;
+    bool used;
+} scene_t;
+
+/*
+    Groups and scenes of the bridge. Group and scene ids start at 1 as in the
+    Hue API, group 0 (all lights) is not stored here. A group is a bit mask of
+    light ids, so applying an action to it is a walk over the set bits.
+*/
+class GroupRegistry
+{
+    public:
+        unsigned char addGroup(const char * name, uint64_t lights);
+        bool removeGroup(unsigned char id);
+        bool containsGroup(unsigned char id) const { return id >= 1 && id <= _groups.size() && _groups[id - 1].used; }
+        const group_t& group(unsigned char id) const { return _groups[id - 1]; }
+        unsigned char groupCount() const { return _groups.size(); }
+
+        unsigned char addScene(const char * name, unsigned char group, const std::vector<scene_light_t> & lights);
+        bool containsScene(unsigned char id) const { return id >= 1 && id <= _scenes.size() && _scenes[id - 1].used; }
+        const scene_t& scene(unsigned char id) const { return _scenes[id - 1]; }
+        unsigned char sceneCount() const { return _scenes.size(); }
+
+        // drops a removed light from every group and scene
+        void removeLight(unsigned char id);
+
+    private:
+        std::vector<group_t> _groups;       // removed groups stay as unused slots so ids do not move
+        std::vector<scene_t> _scenes;
+};
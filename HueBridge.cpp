@@ -1,59 +1,315 @@
 #include "HueBridge.h"
 #include <vector>
-#include <WiFi.h>
-#include <WebServer.h>
 #include "templates.h"
 #include "SimpleJson.h"
+#include "HuePages.h"
+
+bool HueBridge::persistState(const char * location)
+{
+    if (!_journal.begin(location))
+    {
+        return false;
+    }
+
+    // the lights of the last run come back under the ids and uniqueids they
+    // had, also those the sketch does not add itself
+    for (unsigned char id = 0; id < HUE_MAX_DEVICES; id++)
+    {
+        lights.setGeneration(id, _journal.generation(id));
+        const char * name = _journal.name(id);
+        if (name != NULL && lights.add(name, id) == id)
+        {
+            initDevice(id);
+        }
+    }
+    return true;
+}
 
 unsigned char HueBridge::addDevice(const char *device_name)
 {
-    device_t device;
-    unsigned int device_id = lights.size();
+    unsigned char device_id = lights.find(device_name);
+    if (device_id != HUE_INVALID_DEVICE)
+    {
+        return device_id;
+    }
+
+    device_id = lights.add(device_name);
+    if (device_id == HUE_INVALID_DEVICE)
+    {
+        LOG_HUE(HUE_LOG_WARN, "Device '%s' could not be added", device_name);
+        return device_id;
+    }
+    initDevice(device_id);
+    return device_id;
+}
+
+void HueBridge::initDevice(unsigned char device_id)
+{
+    // the uniqueid of every light is derived from the MAC address
+    uint8_t mac[6];
+    WiFi.macAddress(mac);
+    lights.setMacAddress(mac);
 
     // init properties
-    device.name = strdup(device_name);
+    const char * device_name = lights.name(device_id);
+    device_t device = lights[device_id];
     device.state = false;
     device.bri = 254;
     device.hue = 0;
     device.sat = 0;
     device.ct = 153;   // must be 153 - 500
     device.mode = 'x'; // possible balues 'hs', 'xy', 'ct'
+    device.x = HUE_XY_WHITE_X;
+    device.y = HUE_XY_WHITE_Y;
+    if (_journal.restore(device_id, device_name, &device))
+    {
+        LOG_HUE(HUE_LOG_INFO, "Device '%s' restored: %s, bri %d", device_name, device.state ? "on" : "off", device.bri);
+    }
+    lights.store(device_id, device);
 
-    // create the uniqueid
-    String mac = WiFi.macAddress();
-
-    snprintf(device.uniqueid, 27, "%s:%s-%02X", mac.c_str(), "00:00", device_id);
+    updateDeviceCache(device_id);
+    LOG_HUE(HUE_LOG_INFO, "Device '%s' added as #%d", device_name, device_id);
+}
 
-    // Attach
-    lights.push_back(device);
-    DEBUG_MSG_HUE("Device '%s' added as #%d\n", device_name, device_id);
-    return device_id;
+bool HueBridge::removeDevice(unsigned char id)
+{
+    if (!lights.contains(id))
+    {
+        return false;
+    }
+    uint32_t nameHash = lights[id].nameHash;
+    lights.remove(id);
+    _journal.forget(id, nameHash, lights.generation(id));
+
+    groups.removeLight(id);
+    deviceCacheStale.fetch_and(~(1ULL << id));
+    deviceCache.resize(lights.size());
+    if (id < deviceCache.size())
+    {
+        deviceCache[id] = "";
+    }
+    lightListDirty = true;
+    LOG_HUE(HUE_LOG_INFO, "Device #%d removed", id);
+    return true;
 }
 
 void HueBridge::start()
 {
-
-    webServer.on("/description.xml", HTTP_GET, [this]() { handle_GetDescription(); });
-    webServer.on("/api", HTTP_POST, [this]() { handle_PostDeviceType(); });
-    webServer.on("/api/{}/lights", HTTP_GET, [this]() { handle_GetState(); });
-    webServer.on("/api/{}/lights/{}", HTTP_GET, [this]() { handle_GetState(); });
-    webServer.on("/api/{}/lights/{}/state", HTTP_PUT, [this]() { handle_PutState(); });
-    webServer.on("/", HTTP_GET, [this]() { handle_root(); });
-    webServer.on("/debug/clip.html", HTTP_GET, [this]() { handle_clip(); });
-
-    webServer.onNotFound( [this]() { handle_CORSPreflight(); });
+    hueLog.begin();
+    _stateQueue.start(_threaded ? HUE_CALLBACK_CORE : -1);
+    _started = true;
+
+    webServer.on("/description.xml", HTTP_GET, route("GET /description.xml", [this]() { handle_GetDescription(); }));
+    webServer.on("/", HTTP_GET, route("GET /", [this]() { handle_root(); }));
+    webServer.on("/debug/clip.html", HTTP_GET, route("GET /debug/clip.html", [this]() { handle_clip(); }));
+#ifdef HUE_METRICS
+    webServer.on("/debug/metrics", HTTP_GET, [this]() { handle_Metrics(); });
+#endif
+#if defined(HUE_ASYNC_SERVER) || defined(HUE_HOST)
+    // WebServer serves one connection at a time, a stream would block it
+    webServer.on("/eventstream", HTTP_GET, route("GET /eventstream", [this]() { handle_EventStream(); }));
+#endif
+
+    // the Hue API is dispatched by hueRoute, see handle_Api
+    _apiHandlers[HUE_ROUTE_CREATE_USER] = route("POST /api", [this]() { handle_PostDeviceType(); });
+    _apiHandlers[HUE_ROUTE_DATASTORE] = route("GET /api/{}", [this]() { handle_GetDatastore(); });
+    _apiHandlers[HUE_ROUTE_CONFIG] = route("GET /api/{}/config", [this]() { handle_GetConfig(); });
+    _apiHandlers[HUE_ROUTE_LIGHTS] = route("GET /api/{}/lights", [this]() { handle_GetState(0); });
+    _apiHandlers[HUE_ROUTE_LIGHT] = route("GET /api/{}/lights/{}", [this]() { handle_GetState(_path.id); });
+    _apiHandlers[HUE_ROUTE_LIGHT_STATE] = route("PUT /api/{}/lights/{}/state", [this]() { handle_PutState(_path.id); });
+    _apiHandlers[HUE_ROUTE_GROUPS] = route("GET /api/{}/groups", [this]() { handle_GetGroups(); });
+    _apiHandlers[HUE_ROUTE_GROUP] = route("GET /api/{}/groups/{}", [this]() { handle_GetGroup(_path.id); });
+    _apiHandlers[HUE_ROUTE_GROUP_ACTION] = route("PUT /api/{}/groups/{}/action", [this]() { handle_PutGroupAction(_path.id); });
+    _apiHandlers[HUE_ROUTE_SCENES] = route("GET /api/{}/scenes", [this]() { handle_GetScenes(); });
+    _otherHandler = route("other", [this]() { handle_CORSPreflight(); });
+    webServer.onNotFound([this]() { handle_Api(); });
+
+    // WebServer only keeps the request headers it is asked for
+    const char * headers[] = { "If-None-Match", "Accept-Encoding" };
+    webServer.collectHeaders(headers, 2);
 
     webServer.enableCORS();
     webServer.begin();
-    DEBUG_MSG_HUE("HTTP server started");
+    LOG_HUE(HUE_LOG_INFO, "HTTP server started on port %d", _port);
 
-    upnp.init();
+    upnp.init(_port);
+}
+
+// wraps a handler so its latency, response size and heap use are recorded under name
+std::function<void(void)> HueBridge::route(const char * name, std::function<void(void)> handler)
+{
+#ifdef HUE_METRICS
+    int id = hueMetrics.addRoute(name);
+    return [id, handler]() {
+        hueMetrics.begin();
+        handler();
+        hueMetrics.end(id);
+    };
+#else
+    return handler;
+#endif
+}
+
+void HueBridge::send(int code, const char * content_type, const String & content)
+{
+    webServer.send(code, content_type, content);
+    HUE_METRIC(hueMetrics.addBytes(content.length()));
+}
+
+// true when Accept-Encoding lists gzip or * without q=0
+static bool acceptsGzip(const char * accept)
+{
+    while (*accept != 0)
+    {
+        while (*accept == ' ' || *accept == ',')
+        {
+            accept++;
+        }
+        size_t length = strcspn(accept, ",; ");
+        bool gzip = (length == 4 && strncasecmp(accept, "gzip", 4) == 0) || (length == 1 && *accept == '*');
+        const char * end = accept + strcspn(accept, ",");
+        const char * q = strstr(accept, "q=");
+        if (gzip && (q == NULL || q > end || atof(q + 2) > 0))
+        {
+            return true;
+        }
+        accept = end;
+    }
+    return false;
+}
+
+/*
+    The pages are kept gzipped in flash (HuePages.h) and go out from there as
+    they are, nothing is copied or inflated. There is no uncompressed copy,
+    a client that does not accept gzip (curl without --compressed, HTTP/1.0
+    clients) gets a 406 rather than bytes it can not read. The ETag changes
+    with the page, a browser that has it revalidates with If-None-Match and
+    gets a 304 without body.
+*/
+void HueBridge::sendPage(const unsigned char * page, size_t length, PGM_P etag)
+{
+    if (!acceptsGzip(webServer.header("Accept-Encoding").c_str()))
+    {
+        send(406, "text/plain", "gzip only, send Accept-Encoding: gzip");
+        return;
+    }
+
+    webServer.sendHeader("Vary", "Accept-Encoding");
+    webServer.sendHeader("ETag", etag);
+    webServer.sendHeader("Cache-Control", "no-cache");
+    String match = webServer.header("If-None-Match");
+    if (match.length() > 0 && (match == "*" || strstr(match.c_str(), etag) != NULL))
+    {
+        webServer.send(304);
+        return;
+    }
+
+    webServer.sendHeader("Content-Encoding", "gzip");
+    webServer.send_P(200, "text/html", (PGM_P)page, length);
+    HUE_METRIC(hueMetrics.addBytes(length));
 }
 
 void HueBridge::handle()
 {
     webServer.handleClient();
     upnp.handle();
+    _journal.flush();
+}
+
+void HueBridge::onStateChanges(TStateChangesCallback fn)
+{
+    _stateQueue.begin(fn);
+    if (_started)
+    {
+        _stateQueue.start(_threaded ? HUE_CALLBACK_CORE : -1);
+    }
+}
+
+#if defined(ARDUINO_ARCH_ESP32)
+void HueBridge::serviceTask(void * bridge)
+{
+    HueBridge * self = (HueBridge *)bridge;
+    while (self->_serving)
+    {
+        self->handle();
+        vTaskDelay(HUE_SERVICE_INTERVAL / portTICK_PERIOD_MS > 0 ? HUE_SERVICE_INTERVAL / portTICK_PERIOD_MS : 1);
+    }
+    self->_serviceDone = true;
+    vTaskDelete(NULL);
+}
+#endif
+
+/*
+    Runs handle() in a task of its own so the sketch's loop() is free for
+    other work and the network does not wait on it. On the ESP32 the task is
+    pinned to HUE_NETWORK_CORE and the onStateChanges worker to
+    HUE_CALLBACK_CORE, on Linux both are plain threads.
+
+    The web server, SSDP and the json caches are only touched by the service
+    task. The state of the lights can be changed with setState and read with
+    getState from any task: writers are serialized by _stateLock, readers take
+    a seqlock snapshot (DeviceRegistry::snapshot) and never wait, and the
+    cached json of a changed light is rebuilt by the service task on the
+    next poll. Lights, groups and scenes have to be added before.
+*/
+void HueBridge::startTask()
+{
+    _threaded = true;
+    start();
+    _serving = true;
+#if defined(ARDUINO_ARCH_ESP32)
+    _serviceDone = false;
+    xTaskCreatePinnedToCore(serviceTask, "hueBridge", HUE_SERVICE_TASK_STACK, this, HUE_SERVICE_TASK_PRIORITY, NULL, HUE_NETWORK_CORE);
+#else
+    _serviceThread = std::thread([this]() {
+        while (_serving)
+        {
+            handle();
+            delay(HUE_SERVICE_INTERVAL);
+        }
+    });
+#endif
+}
+
+void HueBridge::stop()
+{
+    if (_serving)
+    {
+        _serving = false;
+    #if defined(ARDUINO_ARCH_ESP32)
+        while (!_serviceDone)
+        {
+            delay(HUE_SERVICE_INTERVAL);
+        }
+    #else
+        _serviceThread.join();
+    #endif
+    }
+    upnp.stop();
+    webServer.stop();
+    _stateQueue.stop();
+    _journal.flush(true);
+    LOG_HUE(HUE_LOG_INFO, "HTTP server stopped");
+}
+
+/*
+    Every request that is not one of the few fixed pages lands here. The path
+    is parsed once by hueRoute and the handler of its route is called with the
+    parsed segments in _path. uri() returns a copy, it is kept in _uri for as
+    long as the user and sub segments of _path point into it.
+*/
+void HueBridge::handle_Api()
+{
+    _uri = webServer.uri();
+    HueRoute id = hueRoute(webServer.method(), _uri.c_str(), &_path);
+    if (id != HUE_ROUTE_NONE && _apiHandlers[id])
+    {
+        _apiHandlers[id]();
+    }
+    else
+    {
+        _otherHandler();
+    }
 }
 
 /*
@@ -86,26 +342,25 @@ void HueBridge::handle()
 */
 void HueBridge::handle_GetDescription()
 {
-    DEBUG_MSG_HUE("\nHandling handle_GetDescription (GET %s) request from %s\n", webServer.uri().c_str(), webServer.client().remoteIP().toString().c_str());
+    DEBUG_MSG_HUE("Handling handle_GetDescription (GET %s) request from %s\n", webServer.uri().c_str(), webServer.client().remoteIP().toString().c_str());
 
     IPAddress ip = WiFi.localIP();
-    String mac = WiFi.macAddress();
-    mac.replace(":", "");
-    mac.toLowerCase();
+    char mac[13];
+    platformBridgeId(mac, sizeof(mac));
 
-    char response[strlen_P(HUE_DESCRIPTION_TEMPLATE) + 64];
+    char response[HUE_DESCRIPTION_SIZE];
     snprintf_P(
         response, sizeof(response),
         HUE_DESCRIPTION_TEMPLATE,
-        ip[0], ip[1], ip[2], ip[3], // URLBase
-        ip[0], ip[1], ip[2], ip[3], // friendlyName
-        mac.c_str(),                         // serialNumber
-        mac.c_str()                          // UDN
+        ip[0], ip[1], ip[2], ip[3], _port, // URLBase
+        ip[0], ip[1], ip[2], ip[3], _port, // friendlyName
+        mac,                               // serialNumber
+        mac                                // UDN
     );
 
-    webServer.send(200, "text/xml", response);
+    send(200, "text/xml", response);
 
-    DEBUG_MSG_HUE(response);
+    DEBUG_MSG_HUE("%s", response);
 }
 
 /* 
@@ -132,17 +387,407 @@ void HueBridge::handle_PostDeviceType()
     DEBUG_MSG_HUE("Handling handle_PostDeviceType (POST %s) request from %s\n", webServer.uri().c_str(), webServer.client().remoteIP().toString().c_str());
 
     String body = webServer.arg("plain");
-    DEBUG_MSG_HUE(body.c_str());
+    DEBUG_MSG_HUE("%s", body.c_str());
 
-    char buffer[strlen_P(HUE_USER_JSON_TEMPLATE) + 10];
+    char buffer[HUE_USER_JSON_SIZE];
     snprintf_P(
         buffer, sizeof(buffer),
         HUE_USER_JSON_TEMPLATE,
         "userid");
 
     // Handling devicetype request
-    webServer.send(200, "application/json", buffer);
-    DEBUG_MSG_HUE(buffer);
+    send(200, "application/json", buffer);
+    DEBUG_MSG_HUE("%s", buffer);
+}
+
+/*
+    GET /api/userid
+
+    The whole datastore, the lights, groups, scenes and config with the other resources empty
+
+    {"lights":{...},"groups":{...},"config":{...},"schedules":{},"scenes":{...},"rules":{},"sensors":{},"resourcelinks":{}}
+*/
+void HueBridge::handle_GetDatastore()
+{
+    DEBUG_MSG_HUE("Handling handle_GetDatastore (GET %s) request from %s\n", webServer.uri().c_str(), webServer.client().remoteIP().toString().c_str());
+
+    String config = configJson();
+    String groupList = groupsJson();
+    String sceneList = scenesJson();
+    const String& lightList = lightListJson();
+    String response;
+    response.reserve(lightList.length() + groupList.length() + config.length() + sceneList.length() + 96);
+    response += "{\"lights\":";
+    response += lightList;
+    response += ",\"groups\":";
+    response += groupList;
+    response += ",\"config\":";
+    response += config;
+    response += ",\"schedules\":{},\"scenes\":";
+    response += sceneList;
+    response += ",\"rules\":{},\"sensors\":{},\"resourcelinks\":{}}";
+    send(200, "application/json", response);
+}
+
+/*
+    GET /api/userid/config
+
+    Sample response
+
+    {"name":"Philips hue","datastoreversion":"98","swversion":"1941132080","apiversion":"1.41.0",
+     "mac":"f0:08:d1:d2:cb:4c","bridgeid":"F008D1FFFED2CB4C","factorynew":false,"replacesbridgeid":null,
+     "modelid":"BSB002","ipaddress":"192.168.86.47","netmask":"255.255.255.0","dhcp":true,
+     "linkbutton":true,"portalservices":false,"zigbeechannel":15}
+*/
+void HueBridge::handle_GetConfig()
+{
+    DEBUG_MSG_HUE("Handling handle_GetConfig (GET %s) request from %s\n", webServer.uri().c_str(), webServer.client().remoteIP().toString().c_str());
+
+    send(200, "application/json", configJson());
+}
+
+String HueBridge::configJson()
+{
+    IPAddress ip = WiFi.localIP();
+    uint8_t mac[6];
+    WiFi.macAddress(mac);
+
+    // the bridge id is the MAC with FFFE in the middle
+    char bridgeId[17];
+    snprintf(bridgeId, sizeof(bridgeId), "%02X%02X%02XFFFE%02X%02X%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+
+    char buffer[HUE_CONFIG_JSON_SIZE];
+    snprintf_P(
+        buffer, sizeof(buffer),
+        HUE_CONFIG_JSON_TEMPLATE,
+        mac[0], mac[1], mac[2], mac[3], mac[4], mac[5],
+        bridgeId,
+        ip[0], ip[1], ip[2], ip[3]);
+    return String(buffer);
+}
+
+unsigned char HueBridge::addGroup(const char * name, const unsigned char * ids, size_t count)
+{
+    uint64_t mask = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (lights.contains(ids[i]))
+        {
+            mask |= 1ULL << ids[i];
+        }
+    }
+
+    unsigned char group = groups.addGroup(name, mask);
+    if (group == HUE_INVALID_DEVICE)
+    {
+        LOG_HUE(HUE_LOG_WARN, "Group '%s' could not be added", name);
+        return group;
+    }
+    LOG_HUE(HUE_LOG_INFO, "Group '%s' added as #%d", name, group);
+    return group;
+}
+
+unsigned char HueBridge::addScene(const char * name, unsigned char group)
+{
+    std::vector<scene_light_t> states;
+    uint64_t mask = groupLights(group);
+    for (unsigned char id = 0; id < lights.size(); id++)
+    {
+        if (mask & (1ULL << id))
+        {
+            device_t device = lights.snapshot(id);
+            scene_light_t state = { id, device.state, device.bri, device.sat, device.hue, device.ct, device.mode, device.x, device.y };
+            states.push_back(state);
+        }
+    }
+
+    unsigned char scene = groups.addScene(name, group, states);
+    if (scene == HUE_INVALID_DEVICE)
+    {
+        LOG_HUE(HUE_LOG_WARN, "Scene '%s' could not be added", name);
+        return scene;
+    }
+    LOG_HUE(HUE_LOG_INFO, "Scene '%s' of group #%d added as #%d", name, group, scene);
+    return scene;
+}
+
+// lights of a group as a bit mask, group 0 is every light
+uint64_t HueBridge::groupLights(unsigned char group) const
+{
+    if (group != 0)
+    {
+        return groups.containsGroup(group) ? groups.group(group).lights : 0;
+    }
+
+    uint64_t mask = 0;
+    for (unsigned char id = 0; id < lights.size(); id++)
+    {
+        if (lights.contains(id))
+        {
+            mask |= 1ULL << id;
+        }
+    }
+    return mask;
+}
+
+/*
+    Applies one state to every light of the group. The lights are updated and
+    the callback is called for each of them, but it takes a single request
+    instead of one PUT /lights/{id}/state per light.
+*/
+void HueBridge::setGroupState(unsigned char group, bool state, unsigned char bri, short ct, unsigned int hue, unsigned char sat, char mode, uint16_t x, uint16_t y)
+{
+    uint64_t mask = groupLights(group);
+    for (unsigned char id = 0; id < lights.size(); id++)
+    {
+        if (mask & (1ULL << id))
+        {
+            setState(id, state, bri, ct, hue, sat, mode, x, y);
+        }
+    }
+}
+
+bool HueBridge::recallScene(unsigned char scene)
+{
+    if (!groups.containsScene(scene))
+    {
+        return false;
+    }
+
+    const std::vector<scene_light_t>& states = groups.scene(scene).lights;
+    for (size_t i = 0; i < states.size(); i++)
+    {
+        const scene_light_t& state = states[i];
+        setState(state.id, state.state, state.bri, state.ct, state.hue, state.sat, state.mode, state.x, state.y);
+    }
+    return true;
+}
+
+/*
+    {"name":"Living room","lights":["1","2"],"type":"LightGroup",
+     "state":{"all_on":false,"any_on":true},
+     "action":{"on":true,"bri":254,"hue":0,"sat":0,"xy":[0.3127,0.3290],"ct":153,"colormode":"ct"}}
+
+    The action is the state of the first light in the group.
+*/
+String HueBridge::groupJson(unsigned char group)
+{
+    uint64_t mask = groupLights(group);
+    String json = "{\"name\":\"";
+    jsonAppendString(json, group == 0 ? "Group 0" : groups.group(group).name.c_str());
+    json += "\",\"lights\":[";
+
+    int first = -1;
+    bool allOn = true, anyOn = false;
+    char buffer[192];
+    for (unsigned char id = 0; id < lights.size(); id++)
+    {
+        if (mask & (1ULL << id))
+        {
+            snprintf(buffer, sizeof(buffer), "%s\"%d\"", first < 0 ? "" : ",", id + 1);
+            json += buffer;
+            first = first < 0 ? id : first;
+            bool on = lights.snapshot(id).state;
+            allOn = allOn && on;
+            anyOn = anyOn || on;
+        }
+    }
+
+    device_t action;
+    memset(&action, 0, sizeof(action));
+    if (first >= 0)
+    {
+        action = lights.snapshot(first);
+    }
+    snprintf(buffer, sizeof(buffer), "],\"type\":\"LightGroup\",\"state\":{\"all_on\":%s,\"any_on\":%s},"
+        "\"action\":{\"on\":%s,\"bri\":%d,\"hue\":%d,\"sat\":%d,\"xy\":[%d.%04d,%d.%04d],\"ct\":%d,\"colormode\":\"%s\"}}",
+        first >= 0 && allOn ? "true" : "false", anyOn ? "true" : "false",
+        action.state ? "true" : "false", action.bri, action.hue, action.sat,
+        action.x / HUE_XY_SCALE, action.x % HUE_XY_SCALE, action.y / HUE_XY_SCALE, action.y % HUE_XY_SCALE, action.ct,
+        action.mode == 'h' ? "hs" : action.mode == 'c' ? "ct" : "xy");
+    json += buffer;
+    return json;
+}
+
+String HueBridge::groupsJson()
+{
+    String json = "{";
+    char key[10];
+    for (unsigned char group = 1; group <= groups.groupCount(); group++)
+    {
+        if (groups.containsGroup(group))
+        {
+            snprintf(key, sizeof(key), "%s\"%d\":", json.length() > 1 ? "," : "", group);
+            json += key;
+            json += groupJson(group);
+        }
+    }
+    json += "}";
+    return json;
+}
+
+/*
+    {"1":{"name":"Relax","type":"GroupScene","group":"1","lights":["1","2"],"recycle":false,"locked":false}}
+*/
+String HueBridge::scenesJson()
+{
+    String json = "{";
+    char buffer[64];
+    for (unsigned char scene = 1; scene <= groups.sceneCount(); scene++)
+    {
+        if (!groups.containsScene(scene))
+            continue;
+
+        const scene_t& entry = groups.scene(scene);
+        snprintf(buffer, sizeof(buffer), "%s\"%d\":{\"name\":\"", json.length() > 1 ? "," : "", scene);
+        json += buffer;
+        jsonAppendString(json, entry.name.c_str());
+        snprintf(buffer, sizeof(buffer), "\",\"type\":\"GroupScene\",\"group\":\"%d\",\"lights\":[", entry.group);
+        json += buffer;
+        for (size_t i = 0; i < entry.lights.size(); i++)
+        {
+            snprintf(buffer, sizeof(buffer), "%s\"%d\"", i > 0 ? "," : "", entry.lights[i].id + 1);
+            json += buffer;
+        }
+        json += "],\"recycle\":false,\"locked\":false}";
+    }
+    json += "}";
+    return json;
+}
+
+/*
+    GET /api/userid/groups
+
+    Every group except group 0, keyed by id
+*/
+void HueBridge::handle_GetGroups()
+{
+    DEBUG_MSG_HUE("Handling handle_GetGroups (GET %s) request from %s\n", webServer.uri().c_str(), webServer.client().remoteIP().toString().c_str());
+
+    send(200, "application/json", groupsJson());
+}
+
+/*
+    GET /api/userid/groups/1
+
+    A single group, group 0 holds every light
+*/
+void HueBridge::handle_GetGroup(int id)
+{
+    DEBUG_MSG_HUE("Handling handle_GetGroup (GET %s) request from %s\n", webServer.uri().c_str(), webServer.client().remoteIP().toString().c_str());
+
+    if (id != 0 && (id > HUE_MAX_GROUPS || !groups.containsGroup(id)))
+    {
+        sendError(3, "resource not available");
+        return;
+    }
+    send(200, "application/json", groupJson(id));
+}
+
+/*
+    PUT /api/userid/groups/1/action HTTP/1.1
+
+    Takes the same bodies as PUT /lights/{id}/state and applies them to every
+    light of the group, so a room or "all lights" command from Alexa is one
+    request instead of one per light. Lights keep their on state when the
+    body has no "on". A scene of the group is recalled with
+
+        {"scene":"1"}
+
+    Sample response
+
+        [{"success":{"/groups/1/action/on":true}},{"success":{"/groups/1/action/bri":128}}]
+*/
+void HueBridge::handle_PutGroupAction(int id)
+{
+    DEBUG_MSG_HUE("Handling handle_PutGroupAction (PUT %s) request from %s\n", webServer.uri().c_str(), webServer.client().remoteIP().toString().c_str());
+
+    String body = webServer.arg("plain");
+    DEBUG_MSG_HUE("%s", body.c_str());
+
+    if (body.length() == 0)
+    {
+        sendError(5, "invalid/missing parameters in body");
+        return;
+    }
+    if (id != 0 && (id > HUE_MAX_GROUPS || !groups.containsGroup(id)))
+    {
+        sendError(3, "resource not available");
+        return;
+    }
+
+    light_command_t command;
+    hueParseCommand(body.c_str(), &command);
+
+    char address[32];
+    snprintf(address, sizeof(address), "/groups/%d/action", id);
+    if (command.scene >= 0)
+    {
+        if (command.scene > HUE_MAX_SCENES || !groups.containsScene(command.scene) || groups.scene(command.scene).group != id)
+        {
+            sendError(7, "invalid value for parameter, scene");
+            return;
+        }
+        recallScene(command.scene);
+
+        char response[80];
+        snprintf(response, sizeof(response), "[{\"success\":{\"%s/scene\":\"%d\"}}]", address, command.scene);
+        send(200, "application/json", response);
+        DEBUG_MSG_HUE("%s", response);
+        return;
+    }
+
+    uint64_t mask = groupLights(id);
+    char mode = hueCommandMode(command);
+    int first = -1;
+    for (unsigned char light = 0; light < lights.size(); light++)
+    {
+        if (mask & (1ULL << light))
+        {
+            setState(light, command.hasOn ? command.on : lights.snapshot(light).state, command.bri, command.ct, command.hue, command.sat, mode, command.x, command.y);
+            first = first < 0 ? light : first;
+        }
+    }
+
+    device_t result;
+    memset(&result, 0, sizeof(result));
+    if (first >= 0)
+    {
+        result = lights.snapshot(first);
+    }
+    else
+    {
+        result.state = command.on;
+        result.bri = command.bri;
+        result.ct = command.ct;
+        result.hue = command.hue;
+        result.sat = command.sat;
+    }
+    String rep = hueSuccessJson(address, command, result);
+    send(200, "application/json", rep);
+    DEBUG_MSG_HUE("%s", rep.c_str());
+}
+
+/*
+    GET /api/userid/scenes
+*/
+void HueBridge::handle_GetScenes()
+{
+    DEBUG_MSG_HUE("Handling handle_GetScenes (GET %s) request from %s\n", webServer.uri().c_str(), webServer.client().remoteIP().toString().c_str());
+
+    send(200, "application/json", scenesJson());
+}
+
+void HueBridge::sendError(int type, const char * description)
+{
+    char response[HUE_ERROR_SIZE];
+    snprintf_P(
+        response, sizeof(response),
+        HUE_ERROR_TEMPLATE,
+        type,
+        webServer.uri().c_str(),
+        description);
+    send(400, "application/json", response);
 }
 
 /*
@@ -202,52 +847,181 @@ void HueBridge::handle_PostDeviceType()
         }        
 
 */
-void HueBridge::handle_GetState()
+void HueBridge::handle_GetState(int id)
 {
-    DEBUG_MSG_HUE("\nHandling handle_GetState (GET %s) request from %s\n", webServer.uri().c_str(), webServer.client().remoteIP().toString().c_str());
+    DEBUG_MSG_HUE("Handling handle_GetState (GET %s) request from %s\n", webServer.uri().c_str(), webServer.client().remoteIP().toString().c_str());
 
-    int pos = webServer.uri().indexOf("lights");
+    // polls are served from the cached json, it is only rebuilt when a light changes
+    refreshDeviceCaches();
+    if (0 == id && lights.count() >= _streamMinDevices)   // Client is requesting all devices
+    {
+        streamLightList();
+    }
+    else if (0 == id)
+    {
+        send(200, "application/json", lightListJson());
+        DEBUG_MSG_HUE("%s", lightListJson().c_str());
+    }
+    else if (id <= HUE_MAX_DEVICES && lights.contains(id - 1))   // Client is requesting a single device
+    {
+        send(200, "application/json", deviceCache[id - 1]);
+        DEBUG_MSG_HUE("%s", deviceCache[id - 1].c_str());
+    }
+    else
+    {
+        send(200, "application/json", "{}");
+    }
+}
 
-    unsigned char id = webServer.uri().substring(pos + 7).toInt();
+// rebuilds the cached json of the lights that changed since the last request
+void HueBridge::refreshDeviceCaches()
+{
+    uint64_t stale = deviceCacheStale.exchange(0);
+    for (unsigned char id = 0; stale != 0 && id < lights.size(); id++)
+    {
+        if (stale & (1ULL << id))
+        {
+            updateDeviceCache(id);
+        }
+    }
+}
 
-    String response;
-     
-    if (0 == id)   // Client is requesting all devices
+/*
+    Regenerate the cached json of a single light. The combined light list is
+    only marked stale here and rebuilt from the cached entries on the next poll.
+*/
+void HueBridge::updateDeviceCache(unsigned char id)
+{
+    if (!lights.contains(id))
+        return;
+
+    if (deviceCache.size() < lights.size())
+    {
+        deviceCache.resize(lights.size());
+    }
+    deviceCache[id] = deviceJson(id);
+    lightListDirty = true;
+}
+
+// key that precedes the json of a light in the light list: "1": or ,"2":
+static int lightListKey(char *buffer, size_t size, unsigned char id, bool first)
+{
+    return snprintf(buffer, size, "%s\"%d\":", first ? "" : ",", id + 1);
+}
+
+const String& HueBridge::lightListJson()
+{
+    refreshDeviceCaches();
+    if (lightListDirty)
     {
-        response += "{";
+        // {"1":{...},"2":{...}}
+        size_t length = 2;
         for (unsigned char i = 0; i < lights.size(); i++)
         {
-            if (i > 0)
-            {
-                response += ",";
-            }
-            response += "\"" + String(i + 1) + "\":" + deviceJson(i);
+            length += deviceCache[i].length() + 8;
+        }
+
+        lightListCache = "";
+        lightListCache.reserve(length);
+        lightListCache += "{";
+        bool first = true;
+        for (unsigned char i = 0; i < lights.size(); i++)
+        {
+            if (!lights.contains(i))
+                continue;
+
+            char key[10];
+            lightListKey(key, sizeof(key), i, first);
+            lightListCache += key;
+            lightListCache += deviceCache[i];
+            first = false;
+        }
+        lightListCache += "}";
+        lightListDirty = false;
+    }
+    return lightListCache;
+}
+
+/*
+    Send the light list device by device instead of building it in one String.
+    The Content-Length is added up from the cached entries up front, and the
+    pieces are gathered in one fixed scratch buffer so the socket is written in
+    a few large chunks. The bytes sent are identical to lightListJson(), but the
+    memory needed does not grow with the number of devices.
+*/
+void HueBridge::streamLightList()
+{
+    char key[10];
+    size_t length = 2;
+    bool first = true;
+    for (unsigned char i = 0; i < lights.size(); i++)
+    {
+        if (lights.contains(i))
+        {
+            length += lightListKey(key, sizeof(key), i, first) + deviceCache[i].length();
+            first = false;
         }
-        response += "}";
     }
-    else   // Client is requesting a single device
+
+    webServer.setContentLength(length);
+    webServer.send(200, "application/json", "");
+
+    char scratch[HUE_STREAM_BUFFER_SIZE];
+    size_t used = 0;
+    auto append = [&](const char *data, size_t len) {
+        if (used + len > sizeof(scratch))
+        {
+            webServer.sendContent(scratch, used);
+            used = 0;
+        }
+        if (len > sizeof(scratch))
+        {
+            webServer.sendContent(data, len);
+        }
+        else
+        {
+            memcpy(scratch + used, data, len);
+            used += len;
+        }
+    };
+
+    append("{", 1);
+    first = true;
+    for (unsigned char i = 0; i < lights.size(); i++)
     {
-        response = deviceJson(id - 1);
+        if (lights.contains(i))
+        {
+            append(key, lightListKey(key, sizeof(key), i, first));
+            append(deviceCache[i].c_str(), deviceCache[i].length());
+            first = false;
+        }
     }
+    append("}", 1);
+    webServer.sendContent(scratch, used);
+    HUE_METRIC(hueMetrics.addBytes(length));
 
-    webServer.send(200, "application/json", (char *)response.c_str());
-    DEBUG_MSG_HUE(response.c_str());
+    DEBUG_MSG_HUE("Streamed light list of %d devices, %d bytes\n", lights.count(), (int)length);
 }
 
 String HueBridge::deviceJson(unsigned char id)
 {
-    if (id >= lights.size())
+    if (!lights.contains(id))
         return "{}";
 
-    device_t device = lights[id];
-    char buffer[strlen_P(HUE_DEVICE_JSON_TEMPLATE) + 76];
+    device_t device = lights.snapshot(id);
+    char uniqueid[28];
+    lights.uniqueId(id, uniqueid, sizeof(uniqueid));
+
+    char buffer[HUE_DEVICE_JSON_SIZE];
     snprintf_P(
         buffer, sizeof(buffer),
         HUE_DEVICE_JSON_TEMPLATE,
-        device.name,
-        device.uniqueid,
+        lights.name(id),
+        uniqueid,
         device.state ? "true" : "false",
         device.bri,
+        device.x / HUE_XY_SCALE, device.x % HUE_XY_SCALE,
+        device.y / HUE_XY_SCALE, device.y % HUE_XY_SCALE,
         device.hue,
         device.sat,
         device.ct,
@@ -276,8 +1050,8 @@ String HueBridge::deviceJson(unsigned char id)
     4. Set the color of a light by hue and saturation 
         {"on":true,"hue":9102,"sat":254} "Set light to gold"
 
-    5. Set the color of a light by XY coordinates. Not handling this mode as I have 
-       not seen Alexa send this command.
+    5. Set the color of a light by XY coordinates, the apps send this
+        {"on":true,"xy":[0.6750,0.3220]} red
 
 
     Values that are sent from Alexa App
@@ -306,129 +1080,138 @@ String HueBridge::deviceJson(unsigned char id)
         - Lavender      {"on":true, "hue" : 46421, "sat" : 127 }
    
 */
-void HueBridge::handle_PutState()
+void HueBridge::handle_PutState(int id)
 {
-    DEBUG_MSG_HUE("\nHandling handle_PutState (PUT %s) request from %s\n", webServer.uri().c_str(), webServer.client().remoteIP().toString().c_str());
-
-    unsigned char id = 0;
-
-    int pos = webServer.uri().indexOf("lights");
-    if (pos >= 0){
-        id = webServer.uri().substring(pos + 7).toInt();
-    }
+    DEBUG_MSG_HUE("Handling handle_PutState (PUT %s) request from %s\n", webServer.uri().c_str(), webServer.client().remoteIP().toString().c_str());
 
     String body = webServer.arg("plain");
-    DEBUG_MSG_HUE(body.c_str());
+    DEBUG_MSG_HUE("%s", body.c_str());
 
     if (body.length() == 0){
-        char response[strlen_P(HUE_ERROR_TEMPLATE) + webServer.uri().length() + 40];
-        snprintf_P(
-            response, sizeof(response),
-            HUE_ERROR_TEMPLATE,
-            5,
-            webServer.uri().c_str(),
-            "invalid/missing parameters in body");        
-        webServer.send(400, "application/json", response);
-    }
-    else if (id == 0 || id > lights.size()){
-        char response[strlen_P(HUE_ERROR_TEMPLATE) + webServer.uri().length() + 30];
-        snprintf_P(
-            response, sizeof(response),
-            HUE_ERROR_TEMPLATE,
-            3,
-            webServer.uri().c_str(),
-            "resource not available");        
-        webServer.send(400, "application/json", response);
+        sendError(5, "invalid/missing parameters in body");
+    }
+    else if (id <= 0 || id > HUE_MAX_DEVICES || !lights.contains(id - 1)){
+        sendError(3, "resource not available");
     }
     else{
         --id;
-        SimpleJson json;
-        json.parse(body);
+        // the few bodies an Echo sends are recognized without the tokenizer
+        // and answered without building the reply piece by piece, see HueCommand.h
+        light_command_t command;
+        bool alexa = hueParseAlexaCommand(body.c_str(), &command);
+        if (!alexa)
+        {
+            hueParseCommand(body.c_str(), &command);
+        }
+        HUE_METRIC(alexa ? hueMetrics.fastCommands++ : hueMetrics.parsedCommands++);
 
-        unsigned char bri = json.hasPropery("bri") ? json["bri"].getInt() : 0;
-        short ct = json.hasPropery("ct") ? json["ct"].getInt() : 0;
-        unsigned int hue = json.hasPropery("hue") ? json["hue"].getInt() : 0;
-        unsigned char sat = json.hasPropery("sat") ? json["sat"].getInt() : 0;
+        setState(id, command.on, command.bri, command.ct, command.hue, command.sat, hueCommandMode(command), command.x, command.y);
 
-        //xy beats ct beats hue, sat
-        char mode = json.hasPropery("xy") ? 'x' : json.hasPropery("ct") ? 'c' : 'h';
-        setState(id, json["on"].getBool(), bri, ct, hue, sat, mode);
+        if (alexa)
+        {
+            char reply[HUE_ALEXA_REPLY_SIZE];
+            hueAlexaSuccessJson(reply, sizeof(reply), id + 1, command, lights.snapshot(id));
+            send(200, "application/json", reply);
+            DEBUG_MSG_HUE("%s", reply);
+            return;
+        }
+        char address[32];
+        snprintf(address, sizeof(address), "/lights/%d/state", id + 1);
+        String rep = hueSuccessJson(address, command, lights.snapshot(id));
+        send(200, "application/json", rep);
+        DEBUG_MSG_HUE("%s", rep.c_str());
+    }
+}
+
+void HueBridge::setState(unsigned char id, bool state, unsigned char bri, short ct, unsigned int hue, unsigned char sat, char mode, uint16_t x, uint16_t y)
+{
+    if (!lights.contains(id))
+        return;
 
-        char buffer[50];
-        String rep = "[";
-        snprintf(buffer, sizeof(buffer), "{\"success\":{\"/lights/%d/state/on\":%s}}", id + 1, lights[id].state ? "true" : "false");
-        rep += buffer;
-        if (json.hasPropery("bri"))
+    device_t device;
+    {
+        std::lock_guard<std::mutex> lock(_stateLock);
+        device = lights.snapshot(id);
+        device_t before = device;
+        device.state = state;
+        device.bri = bri != 0 ? bri : device.bri;
+        device.ct = ct != 0 ? ct : device.ct;
+        device.hue = hue;
+        device.sat = sat;
+        device.mode = mode;
+        if (mode == 'x')
         {
-            snprintf(buffer, sizeof(buffer), ",{\"success\":{\"/lights/%d/state/bri\":%d}}", id + 1, lights[id].bri);
-            rep += buffer;
+            if (y != 0)
+            {
+                device.x = x;
+                device.y = y;
+            }
+            hueColorXyToHueSat(device.x, device.y, &device.hue, &device.sat);
         }
-        if (json.hasPropery("hue"))
+        else if (mode == 'c')
         {
-            snprintf(buffer, sizeof(buffer), ",{\"success\":{\"/lights/%d/state/hue\":%d}}", id + 1, lights[id].hue);
-            rep += buffer;
+            hueColorCtToXy(device.ct, &device.x, &device.y);
         }
-        if (json.hasPropery("sat"))
+        else
         {
-            snprintf(buffer, sizeof(buffer), ",{\"success\":{\"/lights/%d/state/sat\":%d}}", id + 1, lights[id].sat);
-            rep += buffer;
+            hueColorHueSatToXy(device.hue, device.sat, &device.x, &device.y);
         }
-        if (json.hasPropery("ct"))
+        lights.store(id, device);
+        _journal.record(id, device);
+
+        // published under the lock so the events are in the order of the changes
+        if (_events.subscribed())
         {
-            snprintf(buffer, sizeof(buffer), ",{\"success\":{\"/lights/%d/state/ct\":%d}}", id + 1, lights[id].ct);
-            rep += buffer;
+            char event[HUE_EVENT_MAX_LENGTH - 32];
+            size_t length = eventJson(event, sizeof(event), id, before, device);
+            if (length > 0)
+            {
+                _events.publish(event, length);
+            }
         }
-        rep += "]";
-        webServer.send(200, "application/json", rep.c_str());
-        DEBUG_MSG_HUE(rep.c_str());
+    }
+    // the json is rebuilt by whoever serves the next poll
+    deviceCacheStale.fetch_or(1ULL << id);
+
+    if (_stateQueue.enabled())
+    {
+        _stateQueue.push(id, device);
+    }
+    if (_setCallback)
+    {
+        _setCallback(id, device.state, device.bri, device.ct, device.hue, device.sat, device.mode);
     }
 }
 
-void HueBridge::setState(unsigned char id, bool state, unsigned char bri, short ct, unsigned int hue, unsigned char sat, char mode)
+bool HueBridge::getState(unsigned char id, device_t * device) const
 {
-    if (id < lights.size()){
-        lights[id].state = state;
-        lights[id].bri = bri != 0 ? bri : lights[id].bri;
-        lights[id].ct = ct != 0 ? ct : lights[id].ct;
-        lights[id].hue = hue;
-        lights[id].sat = sat;
-        lights[id].mode = mode;
+    if (!lights.contains(id))
+        return false;
 
-        if (_setCallback)
-        {
-            _setCallback(id, lights[id].state, lights[id].bri, lights[id].ct, lights[id].hue, lights[id].sat, lights[id].mode);
-        }
-    }
+    *device = lights.snapshot(id);
+    return true;
 }
 
 void HueBridge::handle_root()
 {
-    DEBUG_MSG_HUE("\nHandling handle_root (GET %s) request from %s\n", webServer.uri().c_str(), webServer.client().remoteIP().toString().c_str());
-    char response[strlen_P(INDEX_PAGE)];
-    snprintf_P(
-        response, sizeof(response),
-        INDEX_PAGE);
-    webServer.send(200, "text/html", response);
+    DEBUG_MSG_HUE("Handling handle_root (GET %s) request from %s\n", webServer.uri().c_str(), webServer.client().remoteIP().toString().c_str());
+    sendPage(INDEX_PAGE, sizeof(INDEX_PAGE), INDEX_PAGE_ETAG);
 }
 
 void HueBridge::handle_clip()
 {
-    DEBUG_MSG_HUE("\nHandling handle_clip (GET %s) request from %s\n", webServer.uri().c_str(), webServer.client().remoteIP().toString().c_str());
-    char response[strlen_P(CLIP_PAGE)];
-    snprintf_P(
-        response, sizeof(response),
-        CLIP_PAGE);
-    webServer.send(200, "text/html", response);
+    DEBUG_MSG_HUE("Handling handle_clip (GET %s) request from %s\n", webServer.uri().c_str(), webServer.client().remoteIP().toString().c_str());
+    sendPage(CLIP_PAGE, sizeof(CLIP_PAGE), CLIP_PAGE_ETAG);
 }
 
 void HueBridge::handle_CORSPreflight(){
 
     if ( webServer.method() == HTTP_OPTIONS ){
-        DEBUG_MSG_HUE("\nHandling handle_CORSPreflight (OPTIONS %s) request from %s\n", webServer.uri().c_str(), webServer.client().remoteIP().toString().c_str());
+        DEBUG_MSG_HUE("Handling handle_CORSPreflight (OPTIONS %s) request from %s\n", webServer.uri().c_str(), webServer.client().remoteIP().toString().c_str());
 
         webServer.sendHeader("Access-Control-Allow-Methods", "PUT, GET, OPTIONS");
         webServer.sendHeader("Access-Control-Allow-Headers", "Content-Type");
-        webServer.send(204);
+        send(204);
     }
     else{
         handle_NotFound();
@@ -463,18 +1246,94 @@ void HueBridge::handle_NotFound()
         break;
     }
 
-    DEBUG_MSG_HUE("\nhandle_NotFound (%s %s) request from %s\n", method, webServer.uri().c_str(), webServer.client().remoteIP().toString().c_str());
+    DEBUG_MSG_HUE("handle_NotFound (%s %s) request from %s\n", method.c_str(), webServer.uri().c_str(), webServer.client().remoteIP().toString().c_str());
 
-    char response[strlen_P(HUE_ERROR_TEMPLATE) + webServer.uri().length() + 30];
+    char response[HUE_ERROR_SIZE];
     snprintf_P(
         response, sizeof(response),
         HUE_ERROR_TEMPLATE,
         4,
         webServer.uri().c_str(),
-        "method, " + method + ", not available");
+        ("method, " + method + ", not available").c_str());
 
 
-    webServer.send(404, F("application/json"), response);
-    DEBUG_MSG_HUE(response);
+    send(404, "application/json", response);
+    DEBUG_MSG_HUE("%s", response);
 }
 
+/*
+    GET /eventstream
+
+    Server-Sent Events with the part of the state of a light that changed,
+    one event per light and change, in the fields of GET /api/{u}/lights/{id}:
+
+    id: 7
+    data: {"id":"1","state":{"on":true,"bri":200}}
+
+    id: 8
+    data: {"id":"2","state":{"xy":[0.4573,0.4100],"hue":8402,"sat":140,"colormode":"xy"}}
+
+    A client reads the lights once and then applies the events, instead of
+    polling. Only HUE_EVENT_MAX_SUBSCRIBERS streams are served at once, more
+    get a 503.
+*/
+void HueBridge::handle_EventStream()
+{
+#if defined(HUE_ASYNC_SERVER) || defined(HUE_HOST)
+    if (!webServer.sendEvents(&_events))
+    {
+        send(503, "text/plain", "Too many event streams");
+        return;
+    }
+    LOG_HUE(HUE_LOG_INFO, "Event stream opened by %s", webServer.client().remoteIP().toString().c_str());
+#endif
+}
+
+// the fields that differ between before and after, 0 when none does
+size_t HueBridge::eventJson(char * buffer, size_t size, unsigned char id, const device_t & before, const device_t & after)
+{
+    size_t used = snprintf(buffer, size, "{\"id\":\"%d\",\"state\":{", id + 1);
+    size_t start = used;
+    auto append = [&](const char * fmt, ...) {
+        if (used < size)
+        {
+            va_list args;
+            va_start(args, fmt);
+            used += vsnprintf(buffer + used, size - used, fmt, args);
+            va_end(args);
+        }
+    };
+    if (after.state != before.state)
+        append("%s\"on\":%s", used > start ? "," : "", after.state ? "true" : "false");
+    if (after.bri != before.bri)
+        append("%s\"bri\":%d", used > start ? "," : "", after.bri);
+    if (after.x != before.x || after.y != before.y)
+        append("%s\"xy\":[%d.%04d,%d.%04d]", used > start ? "," : "",
+            after.x / HUE_XY_SCALE, after.x % HUE_XY_SCALE, after.y / HUE_XY_SCALE, after.y % HUE_XY_SCALE);
+    if (after.hue != before.hue)
+        append("%s\"hue\":%d", used > start ? "," : "", after.hue);
+    if (after.sat != before.sat)
+        append("%s\"sat\":%d", used > start ? "," : "", after.sat);
+    if (after.ct != before.ct)
+        append("%s\"ct\":%d", used > start ? "," : "", after.ct);
+    if (after.mode != before.mode)
+        append("%s\"colormode\":\"%s\"", used > start ? "," : "", after.mode == 'h' ? "hs" : after.mode == 'c' ? "ct" : "xy");
+    if (used == start)
+    {
+        return 0;
+    }
+    append("}}");
+    return used < size ? used : 0;
+}
+
+#ifdef HUE_METRICS
+/*
+    GET /debug/metrics
+
+    Request counters, latency histograms and heap use per route, see HueMetrics::json
+*/
+void HueBridge::handle_Metrics()
+{
+    webServer.send(200, "application/json", hueMetrics.json());
+}
+#endif
@@ -1,60 +1,178 @@
 #pragma once
 
 #include <vector>
-#include <WebServer.h>
+#include <atomic>
+#include <mutex>
+#include "Platform.h"
 #include "UPnP.h"
+#include "DeviceRegistry.h"
+#include "HueRouter.h"
+#include "GroupRegistry.h"
+#include "StateQueue.h"
+#include "StateJournal.h"
+#include "HueCommand.h"
+#include "HueEvents.h"
+#include "HueColor.h"
+#include "HueMetrics.h"
+#include "HueLog.h"
 
-#define DEBUG_HUE                Serial
-#ifdef DEBUG_HUE
-    #if defined(ARDUINO_ARCH_ESP32)
-        #define DEBUG_MSG_HUE(fmt, ...) { DEBUG_HUE.printf_P((PGM_P) PSTR(fmt), ## __VA_ARGS__); }
-    #else
-        #error Platform not supported
-    #endif
+// Define HUE_ASYNC_SERVER to serve HTTP with the non-blocking HueHttpServer
+// instead of the WebServer library, the host build always uses it
+//#define HUE_ASYNC_SERVER
+#if defined(HUE_ASYNC_SERVER) || defined(HUE_HOST)
+    #include "HueHttpServer.h"
+    typedef HueHttpServer HueWebServer;
 #else
-    #define DEBUG_MSG_HUE(...)
+    #include <WebServer.h>
+    typedef WebServer HueWebServer;
+#endif
+
+#ifndef HUE_LOG_LEVEL_BRIDGE
+    #define HUE_LOG_LEVEL_BRIDGE    HUE_LOG_LEVEL
 #endif
+#define LOG_HUE(level, fmt, ...)    HUE_LOG(HUE_LOG_LEVEL_BRIDGE, level, "hue", fmt, ## __VA_ARGS__)
+#define DEBUG_MSG_HUE(fmt, ...)     LOG_HUE(HUE_LOG_DEBUG, fmt, ## __VA_ARGS__)
 
+// Light lists with at least this many devices are streamed to the client
+// through a fixed scratch buffer instead of being served from one String
+#ifndef HUE_STREAM_MIN_DEVICES
+    #define HUE_STREAM_MIN_DEVICES   8
+#endif
+#define HUE_STREAM_BUFFER_SIZE       512
 
-typedef struct {
-    char * name;
-    bool state;
-    unsigned char bri;
-    char uniqueid[28];
-    short ct;
-    unsigned int hue;
-    unsigned char sat;
-    char mode; 
+// Cores used by startTask() on the ESP32: HTTP and SSDP run next to the WiFi
+// stack, the onStateChanges worker next to the Arduino loop()
+#define HUE_NETWORK_CORE             0
+#define HUE_CALLBACK_CORE            1
+#define HUE_SERVICE_TASK_STACK       8192
+#define HUE_SERVICE_TASK_PRIORITY    1
+#define HUE_SERVICE_INTERVAL         1       // ms the service task sleeps between passes
 
-} device_t;
+#if defined(ARDUINO_ARCH_ESP32)
+    #include <freertos/FreeRTOS.h>
+    #include <freertos/task.h>
+#else
+    #include <thread>
+#endif
 
 typedef std::function<void(unsigned char, bool, unsigned char, short, unsigned int, unsigned char, char)> TSetStateCallback;
 
 class HueBridge
 {
     public:
+        HueBridge(unsigned int port = UPnP_TCP_PORT) : webServer(port) { _port = port; }
+
+        // keeps the lights and their state in a journal (StateJournal) so they survive
+        // a restart, the lights of the last run are added again right away, call
+        // before addDevice, false when there is no storage at location
+        bool persistState(const char * location = HUE_JOURNAL_LOCATION);
+        // adds a light, returns the id it already has when one with the name exists
         unsigned char addDevice(const char * device_name);
+        bool removeDevice(unsigned char id);
+        unsigned char findDevice(const char * device_name) const { return lights.find(device_name); }
         void start();
         void handle();
+        // starts the bridge and serves HTTP and SSDP from a task of its own
+        // (pinned to HUE_NETWORK_CORE), handle() is not called then
+        void startTask();
+        // announces ssdp:byebye and closes the servers
+        void stop();
+        // light lists of at least count lights are streamed, HUE_STREAM_MIN_DEVICES
+        // by default, more than HUE_MAX_DEVICES never streams
+        void setStreamMinDevices(size_t count) { _streamMinDevices = count; }
+    #if defined(HUE_ASYNC_SERVER) || defined(HUE_HOST)
+        // idle ms an HTTP connection is kept open for the next request, 0 closes
+        // it after every response (WebServer always does)
+        void setKeepAlive(unsigned long timeout) { webServer.setKeepAlive(timeout); }
+    #endif
 
+        // called from the request handler, once per light that changes
         void onSetState(TSetStateCallback fn) { _setCallback = fn; }
-        void setState(unsigned char id, bool state, unsigned char bri, short ct, unsigned int hue, unsigned char sat, char mode);
+        // called from a worker task with the lights that changed since the last call,
+        // a light that changed several times in between is passed once with its latest state
+        void onStateChanges(TStateChangesCallback fn);
+        // setState and getState can be called from any task once the bridge serves
+        // from its own task, getState never waits for a setState in progress.
+        // x and y are the color in ten-thousandths for mode 'x', y = 0 keeps the
+        // current one. The modes the light is not in are converted from the one
+        // it is in (HueColor.h), so hue/sat follow xy and xy follows hue/sat or ct.
+        void setState(unsigned char id, bool state, unsigned char bri, short ct, unsigned int hue, unsigned char sat, char mode, uint16_t x = 0, uint16_t y = 0);
+        bool getState(unsigned char id, device_t * device) const;
+
+        // groups take the ids returned by addDevice, group 0 is all lights
+        unsigned char addGroup(const char * name, const unsigned char * ids, size_t count);
+        bool removeGroup(unsigned char group) { return groups.removeGroup(group); }
+        void setGroupState(unsigned char group, bool state, unsigned char bri, short ct, unsigned int hue, unsigned char sat, char mode, uint16_t x = 0, uint16_t y = 0);
+
+        // a scene stores the current state of the lights in the group
+        unsigned char addScene(const char * name, unsigned char group);
+        bool recallScene(unsigned char scene);
 
     private:
         void handle_GetDescription();
+        void handle_Api();
         void handle_PostDeviceType();
-        void handle_GetState(); 
+        void handle_GetDatastore();
+        void handle_GetConfig();
+        String configJson();
+        void handle_GetGroups();
+        void handle_GetGroup(int id);
+        void handle_PutGroupAction(int id);
+        void handle_GetScenes();
+        uint64_t groupLights(unsigned char group) const;
+        String groupJson(unsigned char group);
+        String groupsJson();
+        String scenesJson();
+        void sendError(int type, const char * description);
+        void handle_GetState(int id);
+        void initDevice(unsigned char id);
         String deviceJson(unsigned char id);
-        void handle_PutState();
+        void updateDeviceCache(unsigned char id);
+        void refreshDeviceCaches();
+        const String& lightListJson();
+        void streamLightList();
+        void handle_PutState(int id);
         void handle_root();
         void handle_clip();
         void handle_CORSPreflight();
         void handle_NotFound();
+        void handle_Metrics();
+        void handle_EventStream();
+        static size_t eventJson(char * buffer, size_t size, unsigned char id, const device_t & before, const device_t & after);
+        std::function<void(void)> route(const char * name, std::function<void(void)> handler);
+        void send(int code, const char * content_type = NULL, const String & content = String(""));
+        void sendPage(const unsigned char * page, size_t length, PGM_P etag);
         
 
-        std::vector<device_t> lights;
+        DeviceRegistry lights;
+        GroupRegistry groups;
+        std::vector<String> deviceCache;     // serialized deviceJson() of each light
+        std::atomic<uint64_t> deviceCacheStale{0};   // lights changed since their json was cached
+        String lightListCache;               // serialized GET /api/{}/lights response
+        bool lightListDirty = true;
+        size_t _streamMinDevices = HUE_STREAM_MIN_DEVICES;
         UPnP upnp; 
-        WebServer webServer; 
+        unsigned int _port;
+        HueWebServer webServer; 
+        std::function<void(void)> _apiHandlers[HUE_ROUTE_COUNT];
+        std::function<void(void)> _otherHandler;
+        String _uri;                         // uri of the request being handled, _path points into it
+        hue_path_t _path;                    // Hue API path of the request being handled
         TSetStateCallback _setCallback = NULL;
+        StateQueue _stateQueue;
+        StateJournal _journal;
+        HueEvents _events;                   // state changes for GET /eventstream
+        std::mutex _stateLock;               // serializes setState, the readers use snapshots
+
+        // service task of startTask()
+        bool _started = false;
+        bool _threaded = false;
+        std::atomic<bool> _serving{false};
+    #if defined(ARDUINO_ARCH_ESP32)
+        std::atomic<bool> _serviceDone{false};
+        static void serviceTask(void * bridge);
+    #else
+        std::thread _serviceThread;
+    #endif
         String uuid = "";
 };
\ No newline at end of file
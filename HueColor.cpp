@@ -0,0 +1,300 @@
+#include "HueColor.h"
+#include <Arduino.h>
+#include <string.h>
+
+#define ONE                 65536       // 1.0 in the Q16 values used below
+
+/*
+    sRGB transfer curve, 1.055 * L^(1/2.4) - 0.055 above L = 0.0031308 and
+    12.92 * L below, sampled at L = i / 256 and scaled to 65535. Values in
+    between are interpolated, which is within a quarter of an 8 bit step.
+*/
+PROGMEM static const uint16_t GAMMA_ENCODE[257] = {
+    0, 3255, 5552, 7237, 8618, 9809, 10867, 11827, 12710, 13531, 14300, 15025,
+    15713, 16368, 16995, 17595, 18173, 18730, 19269, 19790, 20295, 20786, 21263, 21728,
+    22181, 22624, 23056, 23478, 23892, 24297, 24694, 25083, 25465, 25840, 26209, 26571,
+    26927, 27278, 27623, 27963, 28298, 28627, 28953, 29273, 29590, 29902, 30210, 30515,
+    30815, 31112, 31406, 31696, 31983, 32266, 32547, 32824, 33099, 33370, 33639, 33906,
+    34169, 34430, 34689, 34945, 35199, 35450, 35699, 35947, 36191, 36434, 36675, 36914,
+    37151, 37385, 37619, 37850, 38079, 38307, 38533, 38757, 38980, 39201, 39420, 39638,
+    39854, 40069, 40282, 40494, 40705, 40914, 41122, 41328, 41533, 41737, 41939, 42141,
+    42341, 42539, 42737, 42934, 43129, 43323, 43516, 43708, 43899, 44089, 44277, 44465,
+    44652, 44837, 45022, 45206, 45388, 45570, 45751, 45931, 46110, 46288, 46465, 46642,
+    46817, 46992, 47166, 47339, 47511, 47682, 47853, 48023, 48192, 48360, 48527, 48694,
+    48860, 49025, 49190, 49354, 49517, 49679, 49841, 50002, 50162, 50322, 50481, 50639,
+    50797, 50954, 51111, 51266, 51422, 51576, 51730, 51884, 52036, 52189, 52340, 52491,
+    52642, 52792, 52941, 53090, 53238, 53386, 53533, 53680, 53826, 53972, 54117, 54262,
+    54406, 54549, 54693, 54835, 54977, 55119, 55260, 55401, 55541, 55681, 55820, 55959,
+    56098, 56236, 56373, 56510, 56647, 56783, 56919, 57054, 57189, 57324, 57458, 57592,
+    57725, 57858, 57990, 58122, 58254, 58385, 58516, 58647, 58777, 58907, 59036, 59165,
+    59294, 59422, 59550, 59678, 59805, 59932, 60058, 60184, 60310, 60435, 60561, 60685,
+    60810, 60934, 61058, 61181, 61304, 61427, 61549, 61671, 61793, 61915, 62036, 62157,
+    62277, 62398, 62518, 62637, 62757, 62876, 62994, 63113, 63231, 63349, 63466, 63584,
+    63701, 63817, 63934, 64050, 64166, 64281, 64397, 64512, 64626, 64741, 64855, 64969,
+    65083, 65196, 65309, 65422, 65535,
+};
+
+// inverse of GAMMA_ENCODE, linear light of the sRGB value i / 256
+PROGMEM static const uint16_t GAMMA_DECODE[257] = {
+    0, 20, 40, 59, 79, 99, 119, 139, 159, 178, 198, 218,
+    240, 263, 286, 312, 338, 365, 394, 424, 456, 489, 523, 558,
+    595, 633, 673, 714, 756, 800, 845, 892, 940, 990, 1041, 1094,
+    1148, 1204, 1262, 1320, 1381, 1443, 1507, 1572, 1639, 1707, 1778, 1849,
+    1923, 1998, 2075, 2154, 2234, 2316, 2400, 2485, 2572, 2661, 2752, 2845,
+    2939, 3035, 3133, 3233, 3334, 3438, 3543, 3650, 3759, 3870, 3982, 4097,
+    4214, 4332, 4452, 4575, 4699, 4825, 4953, 5083, 5215, 5349, 5485, 5623,
+    5763, 5906, 6050, 6196, 6344, 6494, 6646, 6800, 6957, 7115, 7276, 7438,
+    7603, 7770, 7939, 8110, 8283, 8458, 8636, 8816, 8997, 9181, 9367, 9556,
+    9746, 9939, 10134, 10331, 10530, 10732, 10936, 11142, 11350, 11561, 11773, 11988,
+    12206, 12425, 12647, 12872, 13098, 13327, 13558, 13791, 14027, 14265, 14506, 14749,
+    14994, 15241, 15491, 15743, 15998, 16255, 16514, 16776, 17041, 17307, 17576, 17848,
+    18122, 18398, 18677, 18958, 19242, 19528, 19816, 20108, 20401, 20697, 20996, 21297,
+    21600, 21906, 22215, 22526, 22840, 23156, 23474, 23796, 24119, 24446, 24775, 25106,
+    25440, 25777, 26116, 26458, 26802, 27149, 27499, 27851, 28206, 28563, 28923, 29286,
+    29651, 30019, 30390, 30763, 31139, 31518, 31899, 32283, 32670, 33059, 33451, 33846,
+    34243, 34644, 35046, 35452, 35860, 36271, 36685, 37102, 37521, 37943, 38368, 38795,
+    39226, 39659, 40095, 40533, 40975, 41419, 41866, 42316, 42768, 43224, 43682, 44143,
+    44607, 45073, 45543, 46015, 46491, 46969, 47450, 47934, 48420, 48910, 49402, 49897,
+    50396, 50897, 51401, 51908, 52417, 52930, 53446, 53964, 54486, 55010, 55537, 56067,
+    56601, 57137, 57676, 58218, 58763, 59311, 59862, 60415, 60972, 61532, 62095, 62661,
+    63230, 63801, 64376, 64954, 65535,
+};
+
+/*
+    x, y of the black body locus (Kim et al. cubic spline approximation of
+    the Planckian locus) from 152 to 504 mired in steps of 8, interpolated
+    in between.
+*/
+#define CT_TABLE_START      152
+#define CT_TABLE_SHIFT      3
+#define CT_MIN              153
+#define CT_MAX              500
+
+PROGMEM static const uint16_t CT_XY[45][2] = {
+    { 3123, 3225 }, { 3176, 3276 }, { 3229, 3326 }, { 3283, 3375 }, { 3338, 3423 }, { 3394, 3470 },
+    { 3450, 3516 }, { 3506, 3560 }, { 3563, 3603 }, { 3620, 3644 }, { 3677, 3684 }, { 3734, 3722 },
+    { 3790, 3758 }, { 3848, 3794 }, { 3904, 3827 }, { 3959, 3859 }, { 4014, 3888 }, { 4069, 3916 },
+    { 4123, 3942 }, { 4176, 3967 }, { 4229, 3989 }, { 4281, 4010 }, { 4332, 4030 }, { 4383, 4047 },
+    { 4433, 4064 }, { 4482, 4078 }, { 4531, 4092 }, { 4579, 4103 }, { 4626, 4114 }, { 4673, 4123 },
+    { 4719, 4131 }, { 4765, 4137 }, { 4809, 4142 }, { 4853, 4147 }, { 4896, 4150 }, { 4939, 4152 },
+    { 4981, 4153 }, { 5022, 4153 }, { 5062, 4152 }, { 5101, 4150 }, { 5140, 4148 }, { 5178, 4144 },
+    { 5215, 4140 }, { 5251, 4135 }, { 5287, 4130 },
+};
+
+// wide gamut D65 matrices in Q16
+static const int32_t XYZ_TO_RGB[3][3] = {
+    {  108560, -23256, -16714 },
+    {  -46347, 108488,   2369 },
+    {    3389,  -7954,  66292 },
+};
+
+static const int32_t RGB_TO_XYZ[3][3] = {
+    { 43549, 10114, 10619 },
+    { 18604, 43806,  3125 },
+    {     6,  4739, 64621 },
+};
+
+static uint32_t readTable(const uint16_t * table, uint32_t value)
+{
+    if (value >= ONE)
+    {
+        return pgm_read_word(&table[256]);
+    }
+    uint32_t index = value >> 8;
+    uint32_t fraction = value & 0xFF;
+    uint32_t low = pgm_read_word(&table[index]);
+    uint32_t high = pgm_read_word(&table[index + 1]);
+    return low + (((high - low) * fraction + 0x80) >> 8);
+}
+
+// Q16 channel (0 to 65535) to 8 bits scaled by the brightness
+static uint8_t toByte(uint32_t value, uint8_t bri)
+{
+    bri = bri > 254 ? 254 : bri;
+    return (value * bri * 255 + 65535UL * 254 / 2) / (65535UL * 254);
+}
+
+/*
+    Linear RGB of an xy color in Q16, normalized so that the largest channel
+    is ONE. X and Z are taken for Y = 1, Z is clamped at 0 for coordinates
+    outside of the diagram.
+*/
+static void xyToLinear(uint16_t x, uint16_t y, int32_t rgb[3])
+{
+    if (y == 0)
+    {
+        x = HUE_XY_WHITE_X;
+        y = HUE_XY_WHITE_Y;
+    }
+    int32_t z = HUE_XY_SCALE - (int32_t)x - (int32_t)y;
+    int64_t xyz[3] = {
+        (int64_t)x * ONE / y,
+        ONE,
+        z > 0 ? (int64_t)z * ONE / y : 0,
+    };
+
+    int64_t channels[3];
+    int64_t max = 0;
+    for (int c = 0; c < 3; c++)
+    {
+        channels[c] = xyz[0] * XYZ_TO_RGB[c][0] + xyz[1] * XYZ_TO_RGB[c][1] + xyz[2] * XYZ_TO_RGB[c][2];
+        max = channels[c] > max ? channels[c] : max;
+    }
+    for (int c = 0; c < 3; c++)
+    {
+        rgb[c] = max > 0 && channels[c] > 0 ? (int32_t)(channels[c] * ONE / max) : 0;
+    }
+}
+
+// sRGB of a hue and saturation with a full value, Q16 channels (0 to 65535)
+static void hueSatToSrgb(uint16_t hue, uint8_t sat, uint32_t rgb[3])
+{
+    uint32_t s = (sat > 254 ? 254 : sat) * 65535UL / 254;
+    uint32_t h6 = (uint32_t)hue * 6;
+    uint32_t fraction = h6 & 0xFFFF;
+    uint32_t v = 65535;
+    uint32_t p = v - s;
+    uint32_t q = v - ((s * fraction) >> 16);
+    uint32_t t = v - ((s * (ONE - fraction)) >> 16);
+    switch (h6 >> 16)
+    {
+        case 0:  rgb[0] = v; rgb[1] = t; rgb[2] = p; break;
+        case 1:  rgb[0] = q; rgb[1] = v; rgb[2] = p; break;
+        case 2:  rgb[0] = p; rgb[1] = v; rgb[2] = t; break;
+        case 3:  rgb[0] = p; rgb[1] = q; rgb[2] = v; break;
+        case 4:  rgb[0] = t; rgb[1] = p; rgb[2] = v; break;
+        default: rgb[0] = v; rgb[1] = p; rgb[2] = q; break;
+    }
+}
+
+void hueColorXyToRgb(uint16_t x, uint16_t y, uint8_t bri, hue_rgbw_t * rgb)
+{
+    int32_t linear[3];
+    xyToLinear(x, y, linear);
+    rgb->r = toByte(readTable(GAMMA_ENCODE, linear[0]), bri);
+    rgb->g = toByte(readTable(GAMMA_ENCODE, linear[1]), bri);
+    rgb->b = toByte(readTable(GAMMA_ENCODE, linear[2]), bri);
+    rgb->w = 0;
+}
+
+void hueColorHueSatToRgb(uint16_t hue, uint8_t sat, uint8_t bri, hue_rgbw_t * rgb)
+{
+    uint32_t srgb[3];
+    hueSatToSrgb(hue, sat, srgb);
+    rgb->r = toByte(srgb[0], bri);
+    rgb->g = toByte(srgb[1], bri);
+    rgb->b = toByte(srgb[2], bri);
+    rgb->w = 0;
+}
+
+void hueColorCtToRgb(int16_t ct, uint8_t bri, hue_rgbw_t * rgb)
+{
+    uint16_t x, y;
+    hueColorCtToXy(ct, &x, &y);
+    hueColorXyToRgb(x, y, bri, rgb);
+}
+
+void hueColorXyToHueSat(uint16_t x, uint16_t y, uint16_t * hue, uint8_t * sat)
+{
+    int32_t linear[3];
+    xyToLinear(x, y, linear);
+    int32_t r = readTable(GAMMA_ENCODE, linear[0]);
+    int32_t g = readTable(GAMMA_ENCODE, linear[1]);
+    int32_t b = readTable(GAMMA_ENCODE, linear[2]);
+
+    int32_t max = r > g ? (r > b ? r : b) : (g > b ? g : b);
+    int32_t min = r < g ? (r < b ? r : b) : (g < b ? g : b);
+    int32_t delta = max - min;
+    if (max == 0 || delta == 0)
+    {
+        *hue = 0;
+        *sat = 0;
+        return;
+    }
+    *sat = (delta * 254 + max / 2) / max;
+
+    // sixths of the circle, each ONE / 6 wide
+    int64_t h;
+    if (max == r)
+    {
+        h = (int64_t)(g - b) * ONE / (6 * delta);
+    }
+    else if (max == g)
+    {
+        h = ONE / 3 + (int64_t)(b - r) * ONE / (6 * delta);
+    }
+    else
+    {
+        h = 2 * ONE / 3 + (int64_t)(r - g) * ONE / (6 * delta);
+    }
+    *hue = (uint16_t)(h < 0 ? h + ONE : h);
+}
+
+void hueColorHueSatToXy(uint16_t hue, uint8_t sat, uint16_t * x, uint16_t * y)
+{
+    uint32_t srgb[3];
+    hueSatToSrgb(hue, sat, srgb);
+    int64_t linear[3];
+    for (int c = 0; c < 3; c++)
+    {
+        linear[c] = readTable(GAMMA_DECODE, srgb[c]);
+    }
+
+    int64_t xyz[3];
+    for (int c = 0; c < 3; c++)
+    {
+        xyz[c] = linear[0] * RGB_TO_XYZ[c][0] + linear[1] * RGB_TO_XYZ[c][1] + linear[2] * RGB_TO_XYZ[c][2];
+    }
+    int64_t sum = xyz[0] + xyz[1] + xyz[2];
+    if (sum <= 0)
+    {
+        *x = HUE_XY_WHITE_X;
+        *y = HUE_XY_WHITE_Y;
+        return;
+    }
+    *x = (uint16_t)((xyz[0] * HUE_XY_SCALE + sum / 2) / sum);
+    *y = (uint16_t)((xyz[1] * HUE_XY_SCALE + sum / 2) / sum);
+}
+
+void hueColorCtToXy(int16_t ct, uint16_t * x, uint16_t * y)
+{
+    ct = ct < CT_MIN ? CT_MIN : ct > CT_MAX ? CT_MAX : ct;
+    uint32_t offset = ct - CT_TABLE_START;
+    uint32_t index = offset >> CT_TABLE_SHIFT;
+    int32_t fraction = offset & ((1 << CT_TABLE_SHIFT) - 1);
+    for (int c = 0; c < 2; c++)
+    {
+        int32_t low = pgm_read_word(&CT_XY[index][c]);
+        int32_t high = pgm_read_word(&CT_XY[index + 1][c]);
+        *(c == 0 ? x : y) = (uint16_t)(low + (((high - low) * fraction + (1 << (CT_TABLE_SHIFT - 1))) >> CT_TABLE_SHIFT));
+    }
+}
+
+void hueColorRgb(const device_t & device, hue_rgbw_t * rgb)
+{
+    if (!device.state)
+    {
+        memset(rgb, 0, sizeof(hue_rgbw_t));
+    }
+    else if (device.mode == 'x')
+    {
+        hueColorXyToRgb(device.x, device.y, device.bri, rgb);
+    }
+    else if (device.mode == 'c')
+    {
+        hueColorCtToRgb(device.ct, device.bri, rgb);
+    }
+    else
+    {
+        hueColorHueSatToRgb(device.hue, device.sat, device.bri, rgb);
+    }
+}
+
+void hueColorToRgbw(hue_rgbw_t * rgb)
+{
+    uint8_t white = rgb->r < rgb->g ? (rgb->r < rgb->b ? rgb->r : rgb->b) : (rgb->g < rgb->b ? rgb->g : rgb->b);
+    rgb->r -= white;
+    rgb->g -= white;
+    rgb->b -= white;
+    rgb->w = white;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+#include "DeviceRegistry.h"
+
+// x and y of the CIE 1931 color space are kept in ten-thousandths, [0.6750,0.3220] is 6750, 3220
+#define HUE_XY_SCALE        10000
+// white point of the color space (D65), used for black and for invalid coordinates
+#define HUE_XY_WHITE_X      3127
+#define HUE_XY_WHITE_Y      3290
+
+typedef struct {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+    uint8_t w;              // only set by hueColorToRgbw
+} hue_rgbw_t;
+
+/*
+    Conversions between the color modes of the Hue API (xy, hue/sat, ct) and
+    the RGB or RGBW values a sketch drives its LEDs with. Everything is done
+    in integer fixed point with small tables for the sRGB gamma curve and the
+    black body locus, there is no float or double in here, so a conversion
+    takes a few microseconds on the ESP32 and needs no floating point
+    library.
+
+    xy and RGB are related by the wide gamut matrices of the Philips
+    developer documentation. The RGB of a color is normalized so that its
+    largest channel is full, then scaled by bri (1 to 254). hue/sat map to
+    sRGB as HSV with a full value.
+
+    host/colorbench.cpp compares every function with a double precision
+    implementation of the same formulas and times it.
+
+    hue_rgbw_t rgb;
+    hueColorRgb(device, &rgb);
+    analogWrite(RED_PIN, rgb.r);
+*/
+void hueColorXyToRgb(uint16_t x, uint16_t y, uint8_t bri, hue_rgbw_t * rgb);
+void hueColorHueSatToRgb(uint16_t hue, uint8_t sat, uint8_t bri, hue_rgbw_t * rgb);
+void hueColorCtToRgb(int16_t ct, uint8_t bri, hue_rgbw_t * rgb);
+
+void hueColorXyToHueSat(uint16_t x, uint16_t y, uint16_t * hue, uint8_t * sat);
+void hueColorHueSatToXy(uint16_t hue, uint8_t sat, uint16_t * x, uint16_t * y);
+// point of the black body locus for a color temperature in mired (153 to 500)
+void hueColorCtToXy(int16_t ct, uint16_t * x, uint16_t * y);
+
+// color of the light in its current mode, black when it is off
+void hueColorRgb(const device_t & device, hue_rgbw_t * rgb);
+// moves the white that r, g and b have in common to w
+void hueColorToRgbw(hue_rgbw_t * rgb);
@@ -0,0 +1,320 @@
+#include "HueCommand.h"
+#include "HueColor.h"
+#include "SimpleJson.h"
+
+char hueCommandMode(const light_command_t & command)
+{
+    return command.hasXy ? 'x' : command.hasCt ? 'c' : 'h';
+}
+
+void hueParseCommand(const char * body, light_command_t * command)
+{
+    memset(command, 0, sizeof(light_command_t));
+    command->scene = -1;
+
+    JsonTokenizer json(body);
+    if (json.next() != JsonTokenizer::OBJECT_START)
+    {
+        return;
+    }
+    while (json.next() == JsonTokenizer::KEY)
+    {
+        if (json.keyEquals("on"))
+        {
+            command->hasOn = true;
+            command->on = json.next() == JsonTokenizer::TRUE_TYPE;
+        }
+        else if (json.keyEquals("bri"))
+        {
+            command->hasBri = true;
+            json.next();
+            command->bri = json.getInt();
+        }
+        else if (json.keyEquals("ct"))
+        {
+            command->hasCt = true;
+            json.next();
+            command->ct = json.getInt();
+        }
+        else if (json.keyEquals("hue"))
+        {
+            command->hasHue = true;
+            json.next();
+            command->hue = json.getInt();
+        }
+        else if (json.keyEquals("sat"))
+        {
+            command->hasSat = true;
+            json.next();
+            command->sat = json.getInt();
+        }
+        else if (json.keyEquals("scene") && json.next() == JsonTokenizer::STRING)
+        {
+            // scene ids are numbers sent as strings
+            command->scene = 0;
+            for (int i = 0; i < json.tokenLength() && command->scene >= 0; i++)
+            {
+                char c = json.tokenStart()[i];
+                command->scene = (c >= '0' && c <= '9' && command->scene < 1000) ? command->scene * 10 + c - '0' : -1;
+            }
+        }
+        else if (json.keyEquals("xy"))
+        {
+            // [x, y], anything else is ignored
+            JsonTokenizer::TokenType type = json.next();
+            if (type == JsonTokenizer::ARRAY_START || type == JsonTokenizer::OBJECT_START)
+            {
+                bool valid = type == JsonTokenizer::ARRAY_START;
+                int depth = json.depth();
+                int count = 0;
+                int32_t xy[2] = {0, 0};
+                while ((type = json.next()) != JsonTokenizer::ERROR && type != JsonTokenizer::END && json.depth() >= depth)
+                {
+                    valid = valid && type == JsonTokenizer::NUMBER && count < 2;
+                    if (valid)
+                    {
+                        int32_t value = json.getFixed(4);
+                        xy[count++] = value < 0 ? 0 : value > HUE_XY_SCALE ? HUE_XY_SCALE : value;
+                    }
+                }
+                if (valid && count == 2 && xy[1] > 0)
+                {
+                    command->hasXy = true;
+                    command->x = xy[0];
+                    command->y = xy[1];
+                }
+            }
+        }
+        else
+        {
+            json.skipValue();
+        }
+    }
+}
+
+String hueSuccessJson(const char * address, const light_command_t & command, const device_t & device)
+{
+    char buffer[72];
+    String rep = "[";
+    snprintf(buffer, sizeof(buffer), "{\"success\":{\"%s/on\":%s}}", address, device.state ? "true" : "false");
+    rep += buffer;
+    if (command.hasBri)
+    {
+        snprintf(buffer, sizeof(buffer), ",{\"success\":{\"%s/bri\":%d}}", address, device.bri);
+        rep += buffer;
+    }
+    if (command.hasHue)
+    {
+        snprintf(buffer, sizeof(buffer), ",{\"success\":{\"%s/hue\":%d}}", address, device.hue);
+        rep += buffer;
+    }
+    if (command.hasSat)
+    {
+        snprintf(buffer, sizeof(buffer), ",{\"success\":{\"%s/sat\":%d}}", address, device.sat);
+        rep += buffer;
+    }
+    if (command.hasXy)
+    {
+        snprintf(buffer, sizeof(buffer), ",{\"success\":{\"%s/xy\":[%d.%04d,%d.%04d]}}", address,
+            device.x / HUE_XY_SCALE, device.x % HUE_XY_SCALE, device.y / HUE_XY_SCALE, device.y % HUE_XY_SCALE);
+        rep += buffer;
+    }
+    if (command.hasCt)
+    {
+        snprintf(buffer, sizeof(buffer), ",{\"success\":{\"%s/ct\":%d}}", address, device.ct);
+        rep += buffer;
+    }
+    rep += "]";
+    return rep;
+}
+
+// whitespace as the json tokenizer skips it
+static const char * skipSpace(const char * p)
+{
+    while (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')
+    {
+        p++;
+    }
+    return p;
+}
+
+// "key" and its colon, returns the start of the value or NULL
+static const char * matchKey(const char * p, const char * key)
+{
+    p = skipSpace(p);
+    if (*p++ != '"')
+    {
+        return NULL;
+    }
+    while (*key)
+    {
+        if (*p++ != *key++)
+        {
+            return NULL;
+        }
+    }
+    if (*p++ != '"')
+    {
+        return NULL;
+    }
+    p = skipSpace(p);
+    return *p == ':' ? skipSpace(p + 1) : NULL;
+}
+
+// an unsigned integer of one to five digits, returns the end of it or NULL
+static const char * matchInt(const char * p, int * value)
+{
+    int digits = 0;
+    *value = 0;
+    while (*p >= '0' && *p <= '9' && digits <= 5)
+    {
+        *value = *value * 10 + *p++ - '0';
+        digits++;
+    }
+    return digits > 0 && digits <= 5 ? p : NULL;
+}
+
+bool hueParseAlexaCommand(const char * body, light_command_t * command)
+{
+    memset(command, 0, sizeof(light_command_t));
+    command->scene = -1;
+
+    const char * p = skipSpace(body);
+    if (*p++ != '{' || (p = matchKey(p, "on")) == NULL)
+    {
+        return false;
+    }
+    if (strncmp(p, "true", 4) == 0)
+    {
+        command->on = true;
+        p += 4;
+    }
+    else if (strncmp(p, "false", 5) == 0)
+    {
+        p += 5;
+    }
+    else
+    {
+        return false;
+    }
+    command->hasOn = true;
+
+    p = skipSpace(p);
+    if (*p == ',')
+    {
+        int value;
+        const char * q;
+        if ((q = matchKey(p + 1, "bri")) != NULL && (q = matchInt(q, &value)) != NULL)
+        {
+            command->hasBri = true;
+            command->bri = value;
+        }
+        else if ((q = matchKey(p + 1, "ct")) != NULL && (q = matchInt(q, &value)) != NULL)
+        {
+            command->hasCt = true;
+            command->ct = value;
+        }
+        else if ((q = matchKey(p + 1, "hue")) != NULL && (q = matchInt(q, &value)) != NULL)
+        {
+            command->hasHue = true;
+            command->hue = value;
+            q = skipSpace(q);
+            if (*q != ',' || (q = matchKey(q + 1, "sat")) == NULL || (q = matchInt(q, &value)) == NULL)
+            {
+                return false;
+            }
+            command->hasSat = true;
+            command->sat = value;
+        }
+        else
+        {
+            return false;
+        }
+        p = skipSpace(q);
+    }
+    if (*p++ != '}')
+    {
+        return false;
+    }
+    return *skipSpace(p) == '\0';
+}
+
+static char * append(char * p, const char * text, size_t length)
+{
+    memcpy(p, text, length);
+    return p + length;
+}
+
+static char * appendInt(char * p, int value)
+{
+    char digits[10];
+    unsigned int magnitude = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+    int count = 0;
+    if (value < 0)
+    {
+        *p++ = '-';
+    }
+    do
+    {
+        digits[count++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude > 0);
+    while (count > 0)
+    {
+        *p++ = digits[--count];
+    }
+    return p;
+}
+
+// ,{"success":{"/lights/1/state/bri":183}} with the prefix up to the key
+static char * appendEntry(char * p, const char * prefix, size_t prefixLength, const char * key, size_t keyLength, int value)
+{
+    *p++ = ',';
+    p = append(p, prefix, prefixLength);
+    p = append(p, key, keyLength);
+    p = appendInt(p, value);
+    return append(p, "}}", 2);
+}
+
+#define APPEND(p, text)             append(p, text, sizeof(text) - 1)
+#define APPEND_ENTRY(p, key, value) appendEntry(p, prefix, prefixLength, key, sizeof(key) - 1, value)
+
+size_t hueAlexaSuccessJson(char * buffer, size_t size, int id, const light_command_t & command, const device_t & device)
+{
+    if (size < HUE_ALEXA_REPLY_SIZE || id < 0 || id > 999 || command.hasXy)
+    {
+        return 0;
+    }
+
+    // {"success":{"/lights/1/state/ is the same in every entry
+    char prefix[32];
+    char * end = APPEND(prefix, "{\"success\":{\"/lights/");
+    end = appendInt(end, id);
+    end = APPEND(end, "/state/");
+    size_t prefixLength = end - prefix;
+
+    // the entries in the order of hueSuccessJson
+    char * p = buffer;
+    *p++ = '[';
+    p = append(p, prefix, prefixLength);
+    p = device.state ? APPEND(p, "on\":true}}") : APPEND(p, "on\":false}}");
+    if (command.hasBri)
+    {
+        p = APPEND_ENTRY(p, "bri\":", device.bri);
+    }
+    if (command.hasHue)
+    {
+        p = APPEND_ENTRY(p, "hue\":", device.hue);
+    }
+    if (command.hasSat)
+    {
+        p = APPEND_ENTRY(p, "sat\":", device.sat);
+    }
+    if (command.hasCt)
+    {
+        p = APPEND_ENTRY(p, "ct\":", device.ct);
+    }
+    *p++ = ']';
+    *p = '\0';
+    return p - buffer;
+}
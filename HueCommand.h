@@ -0,0 +1,62 @@
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "DeviceRegistry.h"
+
+// properties of the body of PUT /lights/{id}/state and PUT /groups/{id}/action
+typedef struct {
+    bool on;
+    bool hasOn, hasBri, hasCt, hasHue, hasSat, hasXy;
+    unsigned char bri;
+    short ct;
+    unsigned int hue;
+    unsigned char sat;
+    uint16_t x, y;          // xy in ten-thousandths
+    int scene;              // scene to recall, -1 when there is none
+} light_command_t;
+
+// longest reply of hueAlexaSuccessJson, for a light id of up to three digits
+#define HUE_ALEXA_REPLY_SIZE    (sizeof("[{\"success\":{\"/lights/255/state/on\":false}}") \
+                                + 2 * sizeof(",{\"success\":{\"/lights/255/state/hue\":-32768}}") + 1)
+
+// color mode the command sets, xy beats ct beats hue, sat
+char hueCommandMode(const light_command_t & command);
+
+// pulls the known properties out of any body with the json tokenizer
+void hueParseCommand(const char * body, light_command_t * command);
+
+/*
+    [{"success":{"/lights/1/state/on":true}},{"success":{"/lights/1/state/bri":183}}]
+
+    One entry for each property of the command, with the value the light
+    ended up with. address is the resource the properties belong to.
+*/
+String hueSuccessJson(const char * address, const light_command_t & command, const device_t & device);
+
+/*
+    Fast path for the bodies an Echo sends to a light, which are one of
+
+        {"on":true}
+        {"on":true,"bri":183}
+        {"on":true,"ct":383}
+        {"on":true,"hue":63351,"sat":231}
+
+    with any whitespace and on true or false. The body is recognized in one
+    pass over its characters, nothing is tokenized. Anything else, other keys
+    or another order, values that are not plain integers of up to five
+    digits, returns false and is left to hueParseCommand. A body that is
+    recognized gives the same command as hueParseCommand.
+
+    The reply of such a command only ever has the entries on, bri, ct or
+    hue and sat, hueAlexaSuccessJson writes it from constant fragments with
+    the light id and the values filled in, the same bytes hueSuccessJson
+    makes for "/lights/{id}/state". It returns the length, 0 when size is
+    too small.
+
+    host/commandbench.cpp checks both against the generic functions and
+    times them.
+*/
+bool hueParseAlexaCommand(const char * body, light_command_t * command);
+size_t hueAlexaSuccessJson(char * buffer, size_t size, int id, const light_command_t & command, const device_t & device);
@@ -0,0 +1,35 @@
+#include "HueEvents.h"
+
+void HueEvents::publish(const char * data, size_t length)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    char event[HUE_EVENT_MAX_LENGTH];
+    int used = snprintf(event, sizeof(event), "id: %u\ndata: ", (unsigned int)++_id);
+    if (used < 0 || used + length + 2 > sizeof(event))
+    {
+        return;
+    }
+    memcpy(event + used, data, length);
+    memcpy(event + used + length, "\n\n", 2);
+    length += used + 2;
+
+    uint32_t head = _head;
+    for (size_t i = 0; i < length; )
+    {
+        size_t offset = (head + i) % HUE_EVENT_BUFFER_SIZE;
+        size_t chunk = length - i < HUE_EVENT_BUFFER_SIZE - offset ? length - i : HUE_EVENT_BUFFER_SIZE - offset;
+        memcpy(&_buffer[offset], event + i, chunk);
+        i += chunk;
+    }
+    _head = head + length;
+
+    HUE_METRIC(hueMetrics.eventsPublished++);
+    HUE_METRIC(hueMetrics.eventBytes += length);
+}
+
+uint32_t HueEvents::subscribe()
+{
+    _subscribers++;
+    HUE_METRIC(hueMetrics.eventSubscriptions++);
+    return _head;
+}
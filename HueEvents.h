@@ -0,0 +1,86 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+#include "HueMetrics.h"
+
+#ifndef HUE_EVENT_BUFFER_SIZE
+    #define HUE_EVENT_BUFFER_SIZE   4096    // bytes of events kept for subscribers that are behind
+#endif
+#define HUE_EVENT_MAX_LENGTH        256     // one event with its framing
+#ifndef HUE_EVENT_MAX_SUBSCRIBERS
+    #define HUE_EVENT_MAX_SUBSCRIBERS 2     // streams open at once, the other connections stay for the API
+#endif
+#define HUE_EVENT_HEARTBEAT         15000   // ms, a comment is sent on a quiet stream so proxies keep it
+
+/*
+    Broadcast ring of Server-Sent Events for GET /eventstream. An event is
+    framed once when it is published,
+
+        id: 42
+        data: {"id":"1","state":{"on":true,"bri":200}}
+
+    and every subscriber writes the same bytes to its socket straight from
+    the ring, so a change is formatted once however many streams are open
+    and nothing is copied per subscriber.
+
+    Positions are byte counts since startup, the byte at position p is at
+    p % HUE_EVENT_BUFFER_SIZE. A subscriber is a position. One that falls a
+    whole buffer behind has lost events and is closed, EventSource connects
+    again by itself and the client reads the state once more.
+
+    publish() may be called from any task, drain() from the task that
+    serves HTTP. The lock is held while a chunk is handed to a non-blocking
+    send so the bytes can not be overwritten meanwhile.
+*/
+class HueEvents
+{
+    public:
+        // adds the framing and the next id to data, a json object on one line
+        void publish(const char * data, size_t length);
+        // formatting an event is skipped while nobody listens
+        bool subscribed() const { return _subscribers > 0; }
+        int subscribers() const { return _subscribers; }
+
+        // a new subscriber starts at the next event
+        uint32_t subscribe();
+        void unsubscribe() { _subscribers--; }
+
+        // hands what the subscriber at position has not seen to write(data, length),
+        // which returns the bytes it took, fewer when the socket is full. Returns
+        // false when the subscriber has fallen too far behind.
+        template <typename F> bool drain(uint32_t * position, F write);
+        bool pending(uint32_t position) const { return position != _head; }
+
+    private:
+        char _buffer[HUE_EVENT_BUFFER_SIZE];
+        std::atomic<uint32_t> _head{0};     // position of the next byte
+        uint32_t _id = 0;
+        std::atomic<int> _subscribers{0};
+        std::mutex _lock;
+};
+
+template <typename F> bool HueEvents::drain(uint32_t * position, F write)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    uint32_t head = _head;
+    if (head - *position > HUE_EVENT_BUFFER_SIZE)
+    {
+        return false;
+    }
+    while (*position != head)
+    {
+        size_t offset = *position % HUE_EVENT_BUFFER_SIZE;
+        size_t length = head - *position;
+        length = length < HUE_EVENT_BUFFER_SIZE - offset ? length : HUE_EVENT_BUFFER_SIZE - offset;
+        size_t written = write(&_buffer[offset], length);
+        *position += written;
+        if (written < length)
+        {
+            break;
+        }
+    }
+    return true;
+}
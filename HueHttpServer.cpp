@@ -0,0 +1,763 @@
+#include "HueHttpServer.h"
+
+#include <errno.h>
+
+#if defined(ARDUINO)
+    #include <lwip/sockets.h>
+#else
+    #include <sys/socket.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <errno.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+    #define MSG_NOSIGNAL 0
+#endif
+
+static void setNonBlocking(int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+HueHttpServer::HueHttpServer(int port)
+{
+    _port = port;
+    for (int i = 0; i < HUE_HTTP_MAX_CONNECTIONS; i++)
+    {
+        _connections[i].fd = -1;
+    }
+}
+
+void HueHttpServer::begin()
+{
+    _listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (_listenFd < 0)
+    {
+        return;
+    }
+
+    int enable = 1;
+    setsockopt(_listenFd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(_port);
+
+    if (bind(_listenFd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(_listenFd, 8) < 0)
+    {
+        close(_listenFd);
+        _listenFd = -1;
+        return;
+    }
+    setNonBlocking(_listenFd);
+}
+
+void HueHttpServer::stop()
+{
+    for (int i = 0; i < HUE_HTTP_MAX_CONNECTIONS; i++)
+    {
+        if (_connections[i].fd >= 0)
+        {
+            closeConnection(&_connections[i]);
+        }
+    }
+    if (_listenFd >= 0)
+    {
+        close(_listenFd);
+        _listenFd = -1;
+    }
+}
+
+void HueHttpServer::on(const char * uri, HTTPMethod method, THandlerFunction fn)
+{
+    route_t route;
+    route.uri = uri;
+    route.method = method;
+    route.fn = fn;
+    _routes.push_back(route);
+}
+
+/*
+    One pass over every connection, doing only the work that does not block.
+*/
+void HueHttpServer::handleClient()
+{
+    if (_listenFd < 0)
+    {
+        return;
+    }
+
+    acceptConnections();
+
+    for (int i = 0; i < HUE_HTTP_MAX_CONNECTIONS; i++)
+    {
+        connection_t * conn = &_connections[i];
+        if (conn->fd < 0)
+        {
+            continue;
+        }
+
+        if (conn->state != WRITING)
+        {
+            readConnection(conn);
+        }
+        if (conn->fd >= 0)
+        {
+            serveConnection(conn);
+        }
+
+        // between requests a kept connection waits for the keep-alive timeout,
+        // a stream writes at least a heartbeat in that time
+        bool idle = conn->state == READING && conn->in.empty() && conn->requests > 0;
+        unsigned long timeout = conn->state == STREAMING ? 2 * HUE_EVENT_HEARTBEAT : idle ? _keepAliveTimeout : HUE_HTTP_TIMEOUT;
+        if (conn->fd >= 0 && millis() - conn->lastActivity > timeout)
+        {
+            HUE_METRIC(if (idle) hueMetrics.httpIdleClosed++);
+            closeConnection(conn);
+        }
+    }
+}
+
+// kept connection waiting for its next request that has been idle longest
+HueHttpServer::connection_t * HueHttpServer::idleConnection()
+{
+    connection_t * oldest = NULL;
+    for (int i = 0; i < HUE_HTTP_MAX_CONNECTIONS; i++)
+    {
+        connection_t * conn = &_connections[i];
+        if (conn->fd >= 0 && conn->state == READING && conn->in.empty() && conn->requests > 0 &&
+            (oldest == NULL || (long)(conn->lastActivity - oldest->lastActivity) < 0))
+        {
+            oldest = conn;
+        }
+    }
+    return oldest;
+}
+
+void HueHttpServer::acceptConnections()
+{
+    while (true)
+    {
+        connection_t * conn = NULL;
+        for (int i = 0; i < HUE_HTTP_MAX_CONNECTIONS && conn == NULL; i++)
+        {
+            conn = _connections[i].fd < 0 ? &_connections[i] : NULL;
+        }
+        // all slots taken, an idle kept connection gives way to a waiting client
+        if (conn == NULL && (conn = idleConnection()) == NULL)
+        {
+            return;
+        }
+
+        struct sockaddr_in addr;
+        socklen_t len = sizeof(addr);
+        int fd = accept(_listenFd, (struct sockaddr *)&addr, &len);
+        if (fd < 0)
+        {
+            return;
+        }
+        if (conn->fd >= 0)
+        {
+            HUE_METRIC(hueMetrics.httpEvicted++);
+            closeConnection(conn);
+        }
+        setNonBlocking(fd);
+        int enable = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+        conn->fd = fd;
+        conn->remoteIP = IPAddress((uint32_t)addr.sin_addr.s_addr);
+        conn->state = READING;
+        conn->lastActivity = millis();
+        conn->in.clear();
+        conn->out.clear();
+        conn->sent = 0;
+        conn->flash = NULL;
+        conn->flashLength = 0;
+        conn->consumed = 0;
+        conn->requests = 0;
+        conn->keepAlive = false;
+        conn->pipelined = false;
+        conn->events = NULL;
+        _connectionCount++;
+        HUE_METRIC(hueMetrics.httpConnections++);
+        HUE_METRIC(if ((uint32_t)_connectionCount > hueMetrics.httpOpenPeak) hueMetrics.httpOpenPeak = _connectionCount);
+    }
+}
+
+// reads what has arrived, up to one full request buffer of pipelined requests
+void HueHttpServer::readConnection(connection_t * conn)
+{
+    char buffer[512];
+    while (conn->in.size() < HUE_HTTP_MAX_REQUEST)
+    {
+        size_t room = HUE_HTTP_MAX_REQUEST - conn->in.size();
+        int len = recv(conn->fd, buffer, room < sizeof(buffer) ? room : sizeof(buffer), 0);
+        if (len == 0 || (len < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+        {
+            closeConnection(conn);   // closed by the client or failed
+            return;
+        }
+        if (len < 0)
+        {
+            break;
+        }
+        if (conn->state == STREAMING)
+        {
+            continue;   // nothing is expected from a subscriber, only its close
+        }
+        conn->in.insert(conn->in.end(), buffer, buffer + len);
+        conn->lastActivity = millis();
+    }
+}
+
+/*
+    Runs the requests that have arrived, in order, and writes their responses
+    until the socket is full or the next request is not complete yet. A
+    response is written before the request after it is parsed.
+*/
+void HueHttpServer::serveConnection(connection_t * conn)
+{
+    while (conn->fd >= 0)
+    {
+        if (conn->state == STREAMING)
+        {
+            streamConnection(conn);
+            return;
+        }
+        if (conn->state == READING)
+        {
+            if (!parseRequest(conn))
+            {
+                if (conn->state == READING)
+                {
+                    return;     // more data is needed
+                }
+            }
+            else
+            {
+                dispatch();
+            }
+        }
+        if (!writeConnection(conn))
+        {
+            return;
+        }
+        finishResponse(conn);
+    }
+}
+
+// returns true once the whole response is out
+bool HueHttpServer::writeConnection(connection_t * conn)
+{
+    while (conn->sent < conn->out.size() + conn->flashLength)
+    {
+        const char * data;
+        size_t length;
+        if (conn->sent < conn->out.size())
+        {
+            data = conn->out.data() + conn->sent;
+            length = conn->out.size() - conn->sent;
+        }
+        else
+        {
+            data = conn->flash + (conn->sent - conn->out.size());
+            length = conn->flashLength - (conn->sent - conn->out.size());
+        }
+
+        int len = ::send(conn->fd, data, length, MSG_NOSIGNAL);
+        if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            return false;   // socket buffer is full, continue on the next pass
+        }
+        if (len <= 0)
+        {
+            closeConnection(conn);
+            return false;
+        }
+        conn->sent += len;
+        conn->lastActivity = millis();
+    }
+    return true;
+}
+
+// the response is out, the connection is closed or waits for the next request
+void HueHttpServer::finishResponse(connection_t * conn)
+{
+    if (conn->events != NULL)
+    {
+        std::vector<char>().swap(conn->out);
+        conn->sent = 0;
+        conn->state = STREAMING;
+        return;
+    }
+    if (!conn->keepAlive)
+    {
+        closeConnection(conn);
+        return;
+    }
+
+    conn->in.erase(conn->in.begin(), conn->in.begin() + conn->consumed);
+    conn->consumed = 0;
+    conn->pipelined = !conn->in.empty();
+    std::vector<char>().swap(conn->out);
+    conn->sent = 0;
+    conn->flash = NULL;
+    conn->flashLength = 0;
+    conn->state = READING;
+    conn->lastActivity = millis();
+}
+
+/*
+    Writes the events a subscriber has not seen yet from the ring, and a
+    heartbeat comment when the stream has been quiet. The heartbeat only goes
+    out between events, it would break an event that is half written.
+*/
+void HueHttpServer::streamConnection(connection_t * conn)
+{
+    if (!conn->out.empty() && !writeConnection(conn))
+    {
+        return;
+    }
+    std::vector<char>().swap(conn->out);
+    conn->sent = 0;
+
+    bool failed = false;
+    bool current = conn->events->drain(&conn->position, [conn, &failed](const char * data, size_t length) -> size_t {
+        int len = ::send(conn->fd, data, length, MSG_NOSIGNAL);
+        if (len < 0)
+        {
+            failed = errno != EAGAIN && errno != EWOULDBLOCK;
+            return 0;
+        }
+        conn->lastActivity = millis();
+        return len;
+    });
+    if (!current || failed)
+    {
+        HUE_METRIC(if (!current) hueMetrics.eventOverruns++);
+        closeConnection(conn);
+        return;
+    }
+
+    if (!conn->events->pending(conn->position) && millis() - conn->lastActivity > HUE_EVENT_HEARTBEAT)
+    {
+        conn->out.assign(":\n\n", ":\n\n" + 3);
+        writeConnection(conn);
+    }
+}
+
+void HueHttpServer::closeConnection(connection_t * conn)
+{
+    if (conn->events != NULL)
+    {
+        conn->events->unsubscribe();
+        conn->events = NULL;
+    }
+    close(conn->fd);
+    conn->fd = -1;
+    // give the memory back instead of keeping it for the next connection
+    std::vector<char>().swap(conn->in);
+    std::vector<char>().swap(conn->out);
+    _connectionCount--;
+}
+
+/*
+    Checks whether a complete request has arrived and splits it into the
+    request line, headers and body. Returns false while more data is needed.
+*/
+bool HueHttpServer::parseRequest(connection_t * conn)
+{
+    const char * data = conn->in.data();
+    size_t size = conn->in.size();
+
+    size_t headerEnd = 0;
+    for (size_t i = 3; i < size; i++)
+    {
+        if (data[i - 3] == '\r' && data[i - 2] == '\n' && data[i - 1] == '\r' && data[i] == '\n')
+        {
+            headerEnd = i + 1;
+            break;
+        }
+    }
+    if (headerEnd == 0)
+    {
+        if (size >= HUE_HTTP_MAX_REQUEST)
+        {
+            sendError(conn, 413);
+        }
+        return false;
+    }
+
+    // request line: METHOD SP URI SP VERSION
+    const char * lineEnd = (const char *)memchr(data, '\r', headerEnd);
+    const char * methodEnd = (const char *)memchr(data, ' ', lineEnd - data);
+    const char * uriEnd = methodEnd ? (const char *)memchr(methodEnd + 1, ' ', lineEnd - methodEnd - 1) : NULL;
+    if (methodEnd == NULL || uriEnd == NULL)
+    {
+        sendError(conn, 400);
+        return false;
+    }
+
+    String method(data, methodEnd - data);
+    if (method == "GET") _method = HTTP_GET;
+    else if (method == "PUT") _method = HTTP_PUT;
+    else if (method == "POST") _method = HTTP_POST;
+    else if (method == "DELETE") _method = HTTP_DELETE;
+    else if (method == "OPTIONS") _method = HTTP_OPTIONS;
+    else if (method == "HEAD") _method = HTTP_HEAD;
+    else if (method == "PATCH") _method = HTTP_PATCH;
+    else
+    {
+        sendError(conn, 400);
+        return false;
+    }
+
+    _headers = lineEnd + 2;
+    _headersLength = data + headerEnd - _headers;
+
+    // digits only, a sign or a list of lengths is a bad request. The value
+    // stops growing past the limit so it can not wrap around
+    String length = header("Content-Length");
+    size_t contentLength = 0;
+    for (unsigned int i = 0; i < length.length(); i++)
+    {
+        char c = length[i];
+        if (c < '0' || c > '9')
+        {
+            sendError(conn, 400);
+            return false;
+        }
+        contentLength = contentLength <= HUE_HTTP_MAX_REQUEST ? contentLength * 10 + (c - '0') : contentLength;
+    }
+    if (contentLength > HUE_HTTP_MAX_REQUEST - headerEnd)
+    {
+        sendError(conn, 413);
+        return false;
+    }
+    if (size < headerEnd + contentLength)
+    {
+        return false;
+    }
+
+    // HTTP/1.1 keeps the connection unless the client closes it, 1.0 only when asked to
+    String connection = header("Connection");
+    bool http11 = lineEnd - uriEnd - 1 == 8 && memcmp(uriEnd + 1, "HTTP/1.1", 8) == 0;
+    conn->keepAlive = _keepAliveTimeout > 0 && conn->requests + 1 < _keepAliveRequests &&
+        (http11 ? !hasToken(connection, "close") : hasToken(connection, "keep-alive"));
+
+    HUE_METRIC(hueMetrics.httpRequests++);
+    HUE_METRIC(if (conn->requests > 0) hueMetrics.httpReused++);
+    HUE_METRIC(if (conn->pipelined) hueMetrics.httpPipelined++);
+    conn->pipelined = false;
+    conn->requests++;
+    conn->consumed = headerEnd + contentLength;
+
+    _uri = String(methodEnd + 1, uriEnd - methodEnd - 1);
+    _body = String(data + headerEnd, contentLength);
+    _current = conn;
+    return true;
+}
+
+void HueHttpServer::dispatch()
+{
+    connection_t * conn = _current;
+    _client._remoteIP = conn->remoteIP;
+    _responseHeaders = "";
+    _contentLength = CONTENT_LENGTH_NOT_SET;
+    _chunked = false;
+
+    // the query string is kept apart from the path that is matched
+    String path = _uri;
+    int query = _uri.indexOf('?');
+    if (query >= 0)
+    {
+        path = _uri.substring(0, query);
+    }
+
+    bool handled = false;
+    for (size_t i = 0; i < _routes.size() && !handled; i++)
+    {
+        if ((_routes[i].method == HTTP_ANY || _routes[i].method == _method) && uriMatches(_routes[i].uri.c_str(), path.c_str()))
+        {
+            _uri = path;
+            _routes[i].fn();
+            handled = true;
+        }
+    }
+    if (!handled)
+    {
+        _uri = path;
+        if (_notFoundHandler)
+        {
+            _notFoundHandler();
+        }
+        else
+        {
+            send(404, "text/plain", "Not found");
+        }
+    }
+
+    _current = NULL;
+    _headers = NULL;
+    _body = "";
+    conn->state = WRITING;
+    conn->sent = 0;
+}
+
+// {} in the pattern matches one path segment
+bool HueHttpServer::uriMatches(const char * pattern, const char * uri)
+{
+    while (*pattern && *uri)
+    {
+        if (pattern[0] == '{' && pattern[1] == '}')
+        {
+            if (*uri == '/')
+            {
+                return false;
+            }
+            while (*uri && *uri != '/')
+            {
+                uri++;
+            }
+            pattern += 2;
+        }
+        else if (*pattern++ != *uri++)
+        {
+            return false;
+        }
+    }
+    return *pattern == 0 && *uri == 0;
+}
+
+// whether a comma separated header value lists token, ignoring case
+bool HueHttpServer::hasToken(const String & value, const char * token)
+{
+    size_t length = strlen(token);
+    const char * p = value.c_str();
+    while (*p != 0)
+    {
+        while (*p == ' ' || *p == ',')
+        {
+            p++;
+        }
+        const char * end = p;
+        while (*end != 0 && *end != ',')
+        {
+            end++;
+        }
+        const char * last = end;
+        while (last > p && last[-1] == ' ')
+        {
+            last--;
+        }
+        if ((size_t)(last - p) == length && strncasecmp(p, token, length) == 0)
+        {
+            return true;
+        }
+        p = end;
+    }
+    return false;
+}
+
+String HueHttpServer::arg(const char * name) const
+{
+    if (strcmp(name, "plain") == 0)
+    {
+        return _body;
+    }
+    return String();
+}
+
+bool HueHttpServer::hasArg(const char * name) const
+{
+    return strcmp(name, "plain") == 0 && _body.length() > 0;
+}
+
+String HueHttpServer::header(const char * name) const
+{
+    size_t nameLength = strlen(name);
+    const char * line = _headers;
+    const char * end = _headers + _headersLength;
+    while (line != NULL && line < end)
+    {
+        const char * lineEnd = (const char *)memchr(line, '\r', end - line);
+        if (lineEnd == NULL)
+        {
+            break;
+        }
+        if ((size_t)(lineEnd - line) > nameLength && line[nameLength] == ':' && strncasecmp(line, name, nameLength) == 0)
+        {
+            String value(line + nameLength + 1, lineEnd - line - nameLength - 1);
+            value.trim();
+            return value;
+        }
+        line = lineEnd + 2;
+    }
+    return String();
+}
+
+void HueHttpServer::sendHeader(const String & name, const String & value, bool first)
+{
+    String line = name + ": " + value + "\r\n";
+    _responseHeaders = first ? line + _responseHeaders : _responseHeaders + line;
+}
+
+void HueHttpServer::send(int code, const char * content_type, const String & content)
+{
+    if (_current == NULL)
+    {
+        return;
+    }
+
+    size_t length = _contentLength == CONTENT_LENGTH_NOT_SET ? content.length() : _contentLength;
+    _chunked = (length == CONTENT_LENGTH_UNKNOWN);
+
+    char line[64];
+    snprintf(line, sizeof(line), "HTTP/1.1 %d %s\r\n", code, statusText(code));
+    append(line, strlen(line));
+    if (content_type != NULL)
+    {
+        append("Content-Type: ", 14);
+        append(content_type, strlen(content_type));
+        append("\r\n", 2);
+    }
+    if (_chunked)
+    {
+        append("Transfer-Encoding: chunked\r\n", 28);
+    }
+    else
+    {
+        snprintf(line, sizeof(line), "Content-Length: %u\r\n", (unsigned int)length);
+        append(line, strlen(line));
+    }
+    if (_cors)
+    {
+        append("Access-Control-Allow-Origin: *\r\n", 32);
+    }
+    append(_responseHeaders.c_str(), _responseHeaders.length());
+    if (_current->keepAlive)
+    {
+        snprintf(line, sizeof(line), "Connection: keep-alive\r\nKeep-Alive: timeout=%u\r\n\r\n", (unsigned int)((_keepAliveTimeout + 999) / 1000));
+        append(line, strlen(line));
+    }
+    else
+    {
+        append("Connection: close\r\n\r\n", 21);
+    }
+
+    _responseHeaders = "";
+    _contentLength = CONTENT_LENGTH_NOT_SET;
+    if (content.length() > 0)
+    {
+        sendContent(content);
+    }
+}
+
+void HueHttpServer::send_P(int code, PGM_P content_type, PGM_P content)
+{
+    send_P(code, content_type, content, strlen_P(content));
+}
+
+// the body is not copied, it is written from flash once the headers are out
+void HueHttpServer::send_P(int code, PGM_P content_type, PGM_P content, size_t contentLength)
+{
+    if (_current == NULL)
+    {
+        return;
+    }
+
+    _contentLength = contentLength;
+    send(code, content_type, String(""));
+    if (_method != HTTP_HEAD)
+    {
+        _current->flash = content;
+        _current->flashLength = contentLength;
+    }
+}
+
+bool HueHttpServer::sendEvents(HueEvents * events)
+{
+    if (_current == NULL || events->subscribers() >= HUE_EVENT_MAX_SUBSCRIBERS)
+    {
+        return false;
+    }
+
+    // no length, the body ends when the connection does
+    append("HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\n", 75);
+    if (_cors)
+    {
+        append("Access-Control-Allow-Origin: *\r\n", 32);
+    }
+    append(_responseHeaders.c_str(), _responseHeaders.length());
+    append("Connection: close\r\n\r\nretry: 2000\n\n", 34);
+    _responseHeaders = "";
+    _current->keepAlive = false;
+    _current->events = events;
+    _current->position = events->subscribe();
+    return true;
+}
+
+void HueHttpServer::sendContent(const char * content, size_t contentLength)
+{
+    if (_method == HTTP_HEAD)
+    {
+        return;     // the headers tell the length, a body would be taken for the next response
+    }
+    if (_chunked)
+    {
+        char size[12];
+        snprintf(size, sizeof(size), "%x\r\n", (unsigned int)contentLength);
+        append(size, strlen(size));
+        append(content, contentLength);
+        append("\r\n", 2);    // an empty chunk ends the body
+    }
+    else
+    {
+        append(content, contentLength);
+    }
+}
+
+void HueHttpServer::append(const char * data, size_t length)
+{
+    if (_current != NULL)
+    {
+        _current->out.insert(_current->out.end(), data, data + length);
+    }
+}
+
+void HueHttpServer::sendError(connection_t * conn, int code)
+{
+    _current = conn;
+    _responseHeaders = "";
+    _contentLength = CONTENT_LENGTH_NOT_SET;
+    _chunked = false;
+    conn->keepAlive = false;    // what follows in the stream can not be trusted
+    conn->out.clear();
+    send(code);
+    _current = NULL;
+    conn->state = WRITING;
+    conn->sent = 0;
+}
+
+const char * HueHttpServer::statusText(int code)
+{
+    switch (code)
+    {
+        case 200: return "OK";
+        case 204: return "No Content";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 406: return "Not Acceptable";
+        case 413: return "Payload Too Large";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default:  return "";
+    }
+}
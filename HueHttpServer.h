@@ -0,0 +1,170 @@
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+#include <vector>
+#include <HTTP_Method.h>
+#include "HueMetrics.h"
+#include "HueEvents.h"
+
+#ifndef HUE_HTTP_MAX_CONNECTIONS
+    #define HUE_HTTP_MAX_CONNECTIONS 4      // sockets served at the same time, more wait in the backlog
+#endif
+#define HUE_HTTP_MAX_REQUEST        4096    // request line, headers and body
+#define HUE_HTTP_TIMEOUT            5000    // ms without progress before a connection is dropped
+
+// A connection is kept open after a response for this many ms of idle time,
+// and for at most HUE_HTTP_KEEP_ALIVE_REQUESTS requests. 0 closes it after
+// every response as before.
+#ifndef HUE_HTTP_KEEP_ALIVE_TIMEOUT
+    #define HUE_HTTP_KEEP_ALIVE_TIMEOUT  10000
+#endif
+#define HUE_HTTP_KEEP_ALIVE_REQUESTS     100
+
+#ifndef CONTENT_LENGTH_UNKNOWN
+    #define CONTENT_LENGTH_UNKNOWN  ((size_t) -1)
+    #define CONTENT_LENGTH_NOT_SET  ((size_t) -2)
+#endif
+
+class HueHttpClient
+{
+    public:
+        IPAddress remoteIP() const { return _remoteIP; }
+
+    private:
+        IPAddress _remoteIP;
+        friend class HueHttpServer;
+};
+
+/*
+    Event driven replacement for WebServer. Every socket is non-blocking and
+    handleClient() only does the work that is ready: accept new connections,
+    read what has arrived, run the handler of each complete request and write
+    as much of each response as the socket takes. A slow or stalled client
+    therefore never holds up the loop, SSDP or the other connections.
+
+    Connections are persistent (HTTP/1.1 keep-alive), so an Echo polling the
+    light list pays for the TCP handshake and the accept once rather than
+    on every poll. Requests that arrive back to back on a connection
+    (pipelining) are run one after the other once the response before has
+    been written, so responses go out in request order. An idle connection
+    is closed after the keep-alive timeout, and when every slot is taken the
+    connection that has been idle longest is closed to make room for a new
+    client, so persistent connections never lock out a new one.
+
+    It exposes the same subset of the WebServer interface that HueBridge uses,
+    so the route table in HueBridge::start works with either server. It is
+    written against BSD sockets and runs on the ESP32 (lwIP) and on Linux.
+*/
+class HueHttpServer
+{
+    public:
+        typedef std::function<void(void)> THandlerFunction;
+
+        HueHttpServer(int port = 80);
+        ~HueHttpServer() { stop(); }
+
+        void begin();
+        void stop();
+        void handleClient();
+
+        void on(const char * uri, HTTPMethod method, THandlerFunction fn);
+        void onNotFound(THandlerFunction fn) { _notFoundHandler = fn; }
+        void enableCORS(bool value = true) { _cors = value; }
+        // idle ms a connection is kept open for, 0 closes it after every response
+        void setKeepAlive(unsigned long timeout, unsigned int maxRequests = HUE_HTTP_KEEP_ALIVE_REQUESTS) { _keepAliveTimeout = timeout; _keepAliveRequests = maxRequests; }
+
+        // request being handled
+        String uri() const { return _uri; }
+        HTTPMethod method() const { return _method; }
+        String arg(const char * name) const;
+        String arg(const String & name) const { return arg(name.c_str()); }
+        bool hasArg(const char * name) const;
+        String header(const char * name) const;
+        // every header of the request is kept, nothing to collect
+        void collectHeaders(const char * [], const size_t) {}
+        HueHttpClient & client() { return _client; }
+
+        // response to the request being handled
+        void sendHeader(const String & name, const String & value, bool first = false);
+        void setContentLength(size_t contentLength) { _contentLength = contentLength; }
+        void send(int code, const char * content_type = NULL, const String & content = String(""));
+        void send(int code, const String & content_type, const String & content) { send(code, content_type.c_str(), content); }
+        void send_P(int code, PGM_P content_type, PGM_P content);
+        void send_P(int code, PGM_P content_type, PGM_P content, size_t contentLength);
+        void sendContent(const String & content) { sendContent(content.c_str(), content.length()); }
+        void sendContent(const char * content, size_t contentLength);
+        // answers the request with a text/event-stream of the events published from
+        // now on, the connection stays open until the client closes it. False when
+        // HUE_EVENT_MAX_SUBSCRIBERS streams are open already.
+        bool sendEvents(HueEvents * events);
+
+    private:
+        typedef enum {
+            READING,
+            WRITING,
+            STREAMING,              // writes the events of a HueEvents ring until closed
+        } ConnectionState;
+
+        typedef struct {
+            int fd;
+            IPAddress remoteIP;
+            ConnectionState state;
+            unsigned long lastActivity;
+            std::vector<char> in;
+            std::vector<char> out;
+            size_t sent;
+            PGM_P flash;            // body that is written straight from flash after out
+            size_t flashLength;
+            size_t consumed;        // bytes of in taken by the request being answered
+            unsigned int requests;  // requests answered on this connection
+            bool keepAlive;         // the connection stays open after the response
+            bool pipelined;         // the next request arrived before the response was written
+            HueEvents * events;     // the connection becomes a stream of these events
+            uint32_t position;      // next byte of events to write
+        } connection_t;
+
+        typedef struct {
+            String uri;
+            HTTPMethod method;
+            THandlerFunction fn;
+        } route_t;
+
+        int _port;
+        int _listenFd = -1;
+        bool _cors = false;
+        unsigned long _keepAliveTimeout = HUE_HTTP_KEEP_ALIVE_TIMEOUT;
+        unsigned int _keepAliveRequests = HUE_HTTP_KEEP_ALIVE_REQUESTS;
+        std::vector<route_t> _routes;
+        THandlerFunction _notFoundHandler = NULL;
+        connection_t _connections[HUE_HTTP_MAX_CONNECTIONS];
+        int _connectionCount = 0;
+
+        // state of the request being handled
+        connection_t * _current = NULL;
+        String _uri;
+        HTTPMethod _method = HTTP_GET;
+        String _body;
+        const char * _headers = NULL;
+        size_t _headersLength = 0;
+        HueHttpClient _client;
+        String _responseHeaders;
+        size_t _contentLength = CONTENT_LENGTH_NOT_SET;
+        bool _chunked = false;
+
+        void acceptConnections();
+        void readConnection(connection_t * conn);
+        void serveConnection(connection_t * conn);
+        bool writeConnection(connection_t * conn);
+        void finishResponse(connection_t * conn);
+        void streamConnection(connection_t * conn);
+        void closeConnection(connection_t * conn);
+        connection_t * idleConnection();
+        bool parseRequest(connection_t * conn);
+        void dispatch();
+        void append(const char * data, size_t length);
+        void sendError(connection_t * conn, int code);
+        static bool uriMatches(const char * pattern, const char * uri);
+        static bool hasToken(const String & value, const char * token);
+        static const char * statusText(int code);
+};
@@ -0,0 +1,141 @@
+#include "HueLog.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+    #include <freertos/FreeRTOS.h>
+    #include <freertos/task.h>
+#else
+    #include <thread>
+    #include <chrono>
+#endif
+
+#define HUE_LOG_DRAIN_INTERVAL  20      // ms between two passes of the drain task
+
+HueLog hueLog;
+
+#if defined(ARDUINO_ARCH_ESP32)
+static void drainTask(void *)
+{
+    while (true)
+    {
+        hueLog.flush();
+        vTaskDelay(HUE_LOG_DRAIN_INTERVAL / portTICK_PERIOD_MS);
+    }
+}
+#endif
+
+// starts the task that empties the ring buffer
+void HueLog::begin()
+{
+#if HUE_LOG_BUFFERED
+    if (_started)
+    {
+        return;
+    }
+    _started = true;
+
+    #if defined(ARDUINO_ARCH_ESP32)
+        xTaskCreate(drainTask, "hueLog", 2048, NULL, tskIDLE_PRIORITY + 1, NULL);
+    #else
+        std::thread([this]() {
+            while (true)
+            {
+                flush();
+                std::this_thread::sleep_for(std::chrono::milliseconds(HUE_LOG_DRAIN_INTERVAL));
+            }
+        }).detach();
+    #endif
+#endif
+}
+
+void HueLog::write(const char * tag, PGM_P fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+
+#if HUE_LOG_BUFFERED
+    // claim a slot, several writers can race for it but none of them waits
+    uint32_t head = _head.load();
+    do
+    {
+        if (head - _tail.load() >= HUE_LOG_SLOTS)
+        {
+            _dropped++;
+            va_end(args);
+            return;
+        }
+    } while (!_head.compare_exchange_weak(head, head + 1));
+
+    slot_t * slot = &_slots[head % HUE_LOG_SLOTS];
+    slot->length = format(slot->text, sizeof(slot->text), tag, fmt, args);
+    slot->ready.store(true, std::memory_order_release);
+#else
+    char buffer[HUE_LOG_SLOT_SIZE];
+    char * text = buffer;
+    va_list copy;
+    va_copy(copy, args);
+    int length = format(buffer, sizeof(buffer), tag, fmt, copy);
+    va_end(copy);
+    if (length >= (int)sizeof(buffer) - 1)
+    {
+        // long messages are printed in full when they are not buffered
+        va_copy(copy, args);
+        int needed = strlen(tag) + vsnprintf_P(NULL, 0, fmt, copy) + 5;
+        va_end(copy);
+        text = (char *)malloc(needed);
+        if (text != NULL)
+        {
+            length = format(text, needed, tag, fmt, args);
+        }
+        else
+        {
+            text = buffer;
+        }
+    }
+    HUE_LOG_PORT.write((const uint8_t *)text, length);
+    if (text != buffer)
+    {
+        free(text);
+    }
+#endif
+
+    va_end(args);
+}
+
+// prints the messages that are waiting in the ring buffer
+void HueLog::flush()
+{
+    while (true)
+    {
+        uint32_t tail = _tail.load();
+        if (tail == _head.load())
+        {
+            break;
+        }
+        slot_t * slot = &_slots[tail % HUE_LOG_SLOTS];
+        if (!slot->ready.load(std::memory_order_acquire))
+        {
+            break;      // claimed but still being formatted
+        }
+        HUE_LOG_PORT.write((const uint8_t *)slot->text, slot->length);
+        slot->ready.store(false, std::memory_order_relaxed);
+        _tail.store(tail + 1, std::memory_order_release);
+    }
+}
+
+// [tag] message, always ending in a newline
+int HueLog::format(char * buffer, size_t size, const char * tag, PGM_P fmt, va_list args)
+{
+    int length = snprintf(buffer, size, "[%s] ", tag);
+    int message = vsnprintf_P(buffer + length, size - length, fmt, args);
+    length += message < 0 ? 0 : message;
+    if (length > (int)size - 2)
+    {
+        length = size - 2;
+    }
+    if (length == 0 || buffer[length - 1] != '\n')
+    {
+        buffer[length++] = '\n';
+        buffer[length] = 0;
+    }
+    return length;
+}
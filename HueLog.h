@@ -0,0 +1,65 @@
+#pragma once
+
+#include <Arduino.h>
+#include <stdarg.h>
+#include <atomic>
+
+#define HUE_LOG_NONE        0
+#define HUE_LOG_ERROR       1
+#define HUE_LOG_WARN        2
+#define HUE_LOG_INFO        3
+#define HUE_LOG_DEBUG       4
+
+// Messages above this level are compiled out, their arguments are never
+// evaluated. Each module has its own level that defaults to this one
+// (HUE_LOG_LEVEL_BRIDGE, HUE_LOG_LEVEL_UPNP, HUE_LOG_LEVEL_JSON,
+// HUE_LOG_LEVEL_JOURNAL).
+#ifndef HUE_LOG_LEVEL
+    #define HUE_LOG_LEVEL   HUE_LOG_INFO
+#endif
+
+// 0 writes every message to the serial port from the handler that logs it
+// instead of going through the ring buffer
+#ifndef HUE_LOG_BUFFERED
+    #define HUE_LOG_BUFFERED    1
+#endif
+
+#define HUE_LOG_PORT        Serial
+#define HUE_LOG_SLOTS       16      // messages that can wait in the ring buffer
+#define HUE_LOG_SLOT_SIZE   160     // longer messages are cut off when buffered
+
+#define HUE_LOG(module_level, level, tag, fmt, ...) \
+    do { if ((level) <= (module_level)) hueLog.write(tag, PSTR(fmt), ## __VA_ARGS__); } while (0)
+
+/*
+    Logging for HueBridge, UPnP and SimpleJson. In buffered mode a message is
+    formatted into a slot of a lock-free ring buffer and a low priority task
+    writes it to the serial port later, so the request handler never waits on
+    the UART. When the buffer is full the message is dropped and counted
+    rather than blocking the caller.
+*/
+class HueLog
+{
+    public:
+        void begin();
+        void write(const char * tag, PGM_P fmt, ...);
+        void flush();
+        uint32_t dropped() const { return _dropped; }
+
+    private:
+        typedef struct {
+            std::atomic<bool> ready;
+            uint16_t length;
+            char text[HUE_LOG_SLOT_SIZE];
+        } slot_t;
+
+        slot_t _slots[HUE_LOG_SLOTS];
+        std::atomic<uint32_t> _head{0};      // next slot to fill, claimed by the writers
+        std::atomic<uint32_t> _tail{0};      // next slot to print, only moved by flush()
+        std::atomic<uint32_t> _dropped{0};
+        bool _started = false;
+
+        static int format(char * buffer, size_t size, const char * tag, PGM_P fmt, va_list args);
+};
+
+extern HueLog hueLog;
@@ -0,0 +1,121 @@
+#include "HueMetrics.h"
+#include "HueLog.h"
+#include "Platform.h"
+
+#ifdef HUE_METRICS
+
+HueMetrics hueMetrics;
+
+int HueMetrics::addRoute(const char * name)
+{
+    if (_routeCount >= HUE_METRICS_MAX_ROUTES)
+    {
+        return -1;
+    }
+    route_metrics_t * route = &_routes[_routeCount];
+    memset(route, 0, sizeof(route_metrics_t));
+    route->name = name;
+    return _routeCount++;
+}
+
+void HueMetrics::begin()
+{
+    _bytes = 0;
+    _heapStart = platformHeapUsed();
+    _allocatedStart = platformHeapAllocated();
+    _start = micros();
+}
+
+void HueMetrics::end(int route)
+{
+    unsigned long us = micros() - _start;
+    size_t heap = platformHeapUsed();
+    size_t allocated = platformHeapAllocated() - _allocatedStart;
+    if (heap > _heapPeak)
+    {
+        _heapPeak = heap;
+    }
+
+    if (route < 0 || route >= _routeCount)
+    {
+        return;
+    }
+
+    route_metrics_t * metrics = &_routes[route];
+    metrics->count++;
+    metrics->bytes += _bytes;
+    metrics->totalUs += us;
+    metrics->maxUs = us > metrics->maxUs ? us : metrics->maxUs;
+    metrics->heapDelta += (int32_t)(heap - _heapStart);
+    metrics->allocated += allocated;
+
+    int bucket = 0;
+    while (bucket < HUE_METRICS_BUCKETS - 1 && us >= (128UL << bucket))
+    {
+        bucket++;
+    }
+    metrics->histogram[bucket]++;
+}
+
+/*
+    {
+        "uptime": 1234,
+        "heap": {"used": 41000, "peak": 52000},
+        "ssdp": {"searches": 12, "ignored": 0, "replies": 4, "suppressed": 8, "notifies": 6},
+        "http": {"connections": 3, "requests": 120, "reused": 117, "pipelined": 0, "evicted": 0,
+                 "idle_closed": 2, "open_peak": 2},
+        "events": {"published": 40, "bytes": 3100, "subscriptions": 2, "overruns": 0},
+        "commands": {"fast": 38, "parsed": 2},
+        "state": {"queued": 40, "coalesced": 31, "batches": 9},
+        "journal": {"changes": 40, "records": 6, "bytes": 96, "compactions": 0, "erases": 0,
+                    "replayed": 12, "restore_us": 850, "amplification": 0.15},
+        "log": {"dropped": 0},
+        "routes": [
+            {"route": "GET /api/{}/lights", "count": 10, "bytes": 4410, "avg_us": 310, "max_us": 920,
+             "heap_delta": 0, "allocated": 3200, "histogram": [0,2,7,1,0,0,0,0,0,0,0,0]}
+        ]
+    }
+*/
+String HueMetrics::json()
+{
+    // flash bytes per byte of state that changed, in hundredths
+    unsigned int amplification = journalChanges > 0 ? (unsigned int)((uint64_t)journalBytes * 100 / ((uint64_t)journalChanges * 20)) : 0;
+    char buffer[896];
+    snprintf(buffer, sizeof(buffer), "{\"uptime\":%lu,\"heap\":{\"used\":%u,\"peak\":%u},\"ssdp\":{\"searches\":%u,\"ignored\":%u,\"replies\":%u,\"suppressed\":%u,\"notifies\":%u},"
+        "\"http\":{\"connections\":%u,\"requests\":%u,\"reused\":%u,\"pipelined\":%u,\"evicted\":%u,\"idle_closed\":%u,\"open_peak\":%u},"
+        "\"events\":{\"published\":%u,\"bytes\":%u,\"subscriptions\":%u,\"overruns\":%u},\"commands\":{\"fast\":%u,\"parsed\":%u},\"state\":{\"queued\":%u,\"coalesced\":%u,\"batches\":%u},"
+        "\"journal\":{\"changes\":%u,\"records\":%u,\"bytes\":%u,\"compactions\":%u,\"erases\":%u,\"replayed\":%u,\"restore_us\":%u,\"amplification\":%u.%02u},\"log\":{\"dropped\":%u},\"routes\":[",
+        millis() / 1000, (unsigned int)platformHeapUsed(), (unsigned int)_heapPeak,
+        (unsigned int)ssdpSearches, (unsigned int)ssdpIgnored, (unsigned int)ssdpReplies, (unsigned int)ssdpSuppressed, (unsigned int)ssdpNotifies,
+        (unsigned int)httpConnections, (unsigned int)httpRequests, (unsigned int)httpReused, (unsigned int)httpPipelined,
+        (unsigned int)httpEvicted, (unsigned int)httpIdleClosed, (unsigned int)httpOpenPeak,
+        (unsigned int)eventsPublished, (unsigned int)eventBytes, (unsigned int)eventSubscriptions, (unsigned int)eventOverruns,
+        (unsigned int)fastCommands, (unsigned int)parsedCommands,
+        (unsigned int)stateQueued, (unsigned int)stateCoalesced, (unsigned int)stateBatches,
+        (unsigned int)journalChanges, (unsigned int)journalRecords, (unsigned int)journalBytes, (unsigned int)journalCompactions,
+        (unsigned int)journalErases, (unsigned int)journalReplayed, (unsigned int)journalRestoreUs, amplification / 100, amplification % 100,
+        (unsigned int)hueLog.dropped());
+
+    String json;
+    json.reserve(strlen(buffer) + _routeCount * 176);
+    json += buffer;
+    for (int i = 0; i < _routeCount; i++)
+    {
+        route_metrics_t * route = &_routes[i];
+        snprintf(buffer, sizeof(buffer), "%s{\"route\":\"%s\",\"count\":%u,\"bytes\":%u,\"avg_us\":%u,\"max_us\":%u,\"heap_delta\":%d,\"allocated\":%u,\"histogram\":[",
+            i > 0 ? "," : "", route->name, (unsigned int)route->count, (unsigned int)route->bytes,
+            (unsigned int)(route->count > 0 ? route->totalUs / route->count : 0), (unsigned int)route->maxUs, (int)route->heapDelta,
+            (unsigned int)route->allocated);
+        json += buffer;
+        for (int b = 0; b < HUE_METRICS_BUCKETS; b++)
+        {
+            snprintf(buffer, sizeof(buffer), "%s%u", b > 0 ? "," : "", (unsigned int)route->histogram[b]);
+            json += buffer;
+        }
+        json += "]}";
+    }
+    json += "]}";
+    return json;
+}
+
+#endif
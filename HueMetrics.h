@@ -0,0 +1,117 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+// Comment out to compile the request and SSDP counters out of the firmware
+#define HUE_METRICS
+
+#ifdef HUE_METRICS
+    #define HUE_METRIC(x)   x
+#else
+    #define HUE_METRIC(x)
+#endif
+
+#define HUE_METRICS_MAX_ROUTES      16
+#define HUE_METRICS_BUCKETS         12      // handler latency, bucket n counts requests under 128us << n
+
+typedef struct {
+    const char * name;
+    uint32_t count;
+    uint32_t bytes;             // response bytes
+    uint32_t totalUs;
+    uint32_t maxUs;
+    int32_t heapDelta;          // sum of the heap growth over the handler
+    uint32_t allocated;         // bytes allocated by the handler, host build only
+    uint32_t histogram[HUE_METRICS_BUCKETS];
+} route_metrics_t;
+
+/*
+    Counter that is bumped on one task and read on another: the handlers,
+    the state worker and the journal flush do not all run on the task that
+    serves /debug/metrics. The counters do not order anything, so every
+    access is a relaxed atomic.
+*/
+class HueCounter
+{
+    public:
+        operator uint32_t() const { return _value.load(std::memory_order_relaxed); }
+        HueCounter & operator=(uint32_t value) { _value.store(value, std::memory_order_relaxed); return *this; }
+        HueCounter & operator+=(uint32_t value) { _value.fetch_add(value, std::memory_order_relaxed); return *this; }
+        uint32_t operator++(int) { return _value.fetch_add(1, std::memory_order_relaxed); }
+
+    private:
+        std::atomic<uint32_t> _value{0};
+};
+
+/*
+    Per route request counters and latency histograms of HueBridge and the
+    SSDP counters of UPnP, served as json on GET /debug/metrics. Recording a
+    request is a couple of additions, the json is only built when the endpoint
+    is polled.
+*/
+class HueMetrics
+{
+    public:
+        int addRoute(const char * name);
+        void begin();
+        void addBytes(size_t bytes) { _bytes += bytes; }
+        void end(int route);
+
+        String json();
+
+        // SSDP
+        HueCounter ssdpSearches;        // M-SEARCH requests seen
+        HueCounter ssdpIgnored;         // M-SEARCH requests for targets the bridge does not serve
+        HueCounter ssdpReplies;         // M-SEARCH requests answered
+        HueCounter ssdpSuppressed;      // M-SEARCH requests not answered as duplicates or over capacity
+        HueCounter ssdpNotifies;        // NOTIFY packets multicast
+
+        // HueHttpServer connections, reuse is httpReused of httpRequests
+        HueCounter httpConnections;     // connections accepted
+        HueCounter httpRequests;        // requests parsed
+        HueCounter httpReused;          // requests on a connection that had answered one before
+        HueCounter httpPipelined;       // requests sent before the response to the one before was written
+        HueCounter httpEvicted;         // idle kept connections closed to make room for a new one
+        HueCounter httpIdleClosed;      // kept connections closed after the keep-alive timeout
+        HueCounter httpOpenPeak;        // most connections open at the same time
+
+        // HueEvents, bytes are counted once however many streams write them
+        HueCounter eventsPublished;
+        HueCounter eventBytes;              // framed bytes put in the ring
+        HueCounter eventSubscriptions;      // streams opened
+        HueCounter eventOverruns;           // streams closed for falling a whole ring behind
+
+        // PUT /lights/{id}/state bodies, see hueParseAlexaCommand
+        HueCounter fastCommands;        // recognized by the fast path
+        HueCounter parsedCommands;      // left to the json tokenizer
+
+        // state changes delivered through the StateQueue
+        HueCounter stateQueued;         // changes queued
+        HueCounter stateCoalesced;      // queued changes replaced by a newer one before delivery
+        HueCounter stateBatches;        // calls of the batched callback
+
+        // StateJournal, amplification in the json is journalBytes per record
+        // (20 bytes) of journalChanges
+        HueCounter journalChanges;      // state changes recorded
+        HueCounter journalRecords;      // records written, appended or compacted
+        HueCounter journalBytes;        // bytes written to flash, records and headers
+        HueCounter journalCompactions;
+        HueCounter journalErases;       // segments erased
+        HueCounter journalReplayed;     // records replayed at startup
+        HueCounter journalRestoreUs;    // time taken to open and replay the journal
+
+    private:
+        route_metrics_t _routes[HUE_METRICS_MAX_ROUTES];
+        int _routeCount = 0;
+
+        unsigned long _start = 0;
+        size_t _heapStart = 0;
+        size_t _allocatedStart = 0;
+        size_t _bytes = 0;
+        size_t _heapPeak = 0;
+};
+
+#ifdef HUE_METRICS
+    extern HueMetrics hueMetrics;
+#endif
@@ -0,0 +1,128 @@
+#pragma once
+
+// Generated by host/pagegen.cpp from resouces/, do not edit
+
+#define INDEX_PAGE_SIZE 2289
+PROGMEM const char INDEX_PAGE_ETAG[] = "\"40ff7f5a\"";
+PROGMEM const unsigned char INDEX_PAGE[] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xad, 0x56, 0x5d, 0x4f, 0x1b, 0x3b,
+    0x10, 0x7d, 0xe7, 0x57, 0x4c, 0x9f, 0x9c, 0xa8, 0xfb, 0x41, 0x20, 0x5c, 0x51, 0x58, 0xe7, 0xa1,
+    0x9f, 0xa8, 0x6a, 0x2f, 0x55, 0x2f, 0x55, 0xdb, 0x47, 0xc7, 0x3b, 0xc9, 0x1a, 0x36, 0xf6, 0xd6,
+    0x9e, 0x25, 0x8d, 0xaa, 0xfe, 0xf7, 0x3b, 0xce, 0x02, 0xa1, 0x24, 0x10, 0x2a, 0xb1, 0xd2, 0x2a,
+    0xeb, 0xf1, 0xd9, 0x33, 0x27, 0xe3, 0x39, 0xa3, 0x2d, 0x9e, 0xbd, 0x3e, 0x7d, 0x75, 0xf6, 0xfd,
+    0xd3, 0x1b, 0xa8, 0x68, 0x56, 0x8f, 0x76, 0x8a, 0xf8, 0x03, 0xb5, 0xb2, 0x53, 0x29, 0xd0, 0x8a,
+    0xd1, 0x0e, 0xf0, 0x55, 0x54, 0xa8, 0xca, 0xee, 0x71, 0xb9, 0x9c, 0x21, 0x29, 0xd0, 0x95, 0xf2,
+    0x01, 0x49, 0x8a, 0x2f, 0x67, 0x6f, 0xd3, 0x43, 0x71, 0x77, 0xdb, 0xaa, 0x19, 0x4a, 0x71, 0x69,
+    0x70, 0xde, 0x38, 0x4f, 0x02, 0xb4, 0xb3, 0x84, 0x96, 0xe1, 0x73, 0x53, 0x52, 0x25, 0x4b, 0xbc,
+    0x34, 0x1a, 0xd3, 0xe5, 0x22, 0x01, 0x63, 0x0d, 0x19, 0x55, 0xa7, 0x41, 0xab, 0x1a, 0xe5, 0x20,
+    0x81, 0x50, 0x79, 0x63, 0x2f, 0x52, 0x72, 0xe9, 0xc4, 0x90, 0xb4, 0xee, 0x36, 0x7d, 0xcd, 0x3b,
+    0xe0, 0xb1, 0x96, 0x22, 0xd0, 0xa2, 0xc6, 0x50, 0x21, 0x32, 0x7f, 0xe5, 0x71, 0x22, 0x45, 0x45,
+    0xd4, 0x84, 0xa3, 0x3c, 0x0f, 0xa4, 0xf4, 0x45, 0xa3, 0xa8, 0xca, 0xc6, 0xce, 0x51, 0x20, 0xaf,
+    0x1a, 0x5d, 0xda, 0x4c, 0xbb, 0x59, 0x7e, 0x13, 0xc8, 0x87, 0xd9, 0x41, 0xb6, 0x97, 0xeb, 0x10,
+    0x56, 0xb1, 0x6c, 0x66, 0x18, 0x15, 0x02, 0xeb, 0xf5, 0x2e, 0x04, 0xe7, 0xcd, 0xd4, 0x58, 0x29,
+    0x94, 0x75, 0x76, 0x31, 0x73, 0x6d, 0xb8, 0xad, 0x83, 0x0c, 0xd5, 0x38, 0x3a, 0x69, 0x11, 0x5e,
+    0x7a, 0x53, 0x4e, 0xb1, 0xc8, 0xbb, 0xc8, 0x0a, 0x11, 0xb4, 0x37, 0x0d, 0x8d, 0x76, 0x6e, 0x22,
+    0xf1, 0x9a, 0xb4, 0x56, 0x93, 0x71, 0x16, 0x02, 0xda, 0xf2, 0xb5, 0x22, 0xd5, 0x73, 0x36, 0x81,
+    0xb1, 0x37, 0x09, 0x68, 0x4a, 0xa0, 0x6a, 0x91, 0xff, 0xbe, 0xa2, 0xfe, 0xaf, 0x3f, 0xde, 0x8a,
+    0x97, 0x29, 0x41, 0xc2, 0xe0, 0x78, 0x2d, 0x5e, 0x32, 0x09, 0xef, 0xfc, 0xfa, 0xbd, 0x79, 0x2b,
+    0xe3, 0x5c, 0x12, 0x9c, 0x5d, 0xdf, 0x35, 0x13, 0xe8, 0xc5, 0xcc, 0x30, 0x92, 0xb0, 0x0b, 0x1b,
+    0x32, 0xde, 0x50, 0x44, 0x90, 0x8c, 0xd0, 0x75, 0x92, 0xdf, 0x9b, 0x69, 0x35, 0x6d, 0x67, 0x65,
+    0x8c, 0x64, 0xe0, 0xa3, 0x39, 0xb9, 0x36, 0xdb, 0x49, 0x23, 0x48, 0x46, 0xe8, 0xa3, 0x69, 0xb9,
+    0xda, 0xdb, 0x69, 0x23, 0x48, 0x46, 0xe8, 0x26, 0xda, 0xb5, 0xd0, 0xa5, 0xf2, 0xf0, 0xb3, 0xf2,
+    0xfc, 0x86, 0xc5, 0x39, 0x7c, 0xfb, 0xf8, 0xe1, 0x84, 0x1b, 0xf3, 0x33, 0xfe, 0x68, 0x31, 0x50,
+    0xaf, 0xbf, 0x4e, 0xc1, 0xd8, 0xcc, 0x35, 0x68, 0x7b, 0xe2, 0xd3, 0x97, 0x33, 0x91, 0x80, 0xc8,
+    0x55, 0x63, 0xf2, 0x36, 0x20, 0x77, 0x56, 0x5e, 0x9b, 0x69, 0x45, 0x21, 0x17, 0xf0, 0x3c, 0xb6,
+    0xc0, 0x73, 0xde, 0xe4, 0xf6, 0x26, 0x64, 0x18, 0xf9, 0x16, 0xef, 0x61, 0x63, 0x6b, 0x5e, 0xe5,
+    0x3b, 0x61, 0xf3, 0xa2, 0xef, 0x89, 0x57, 0x9d, 0x03, 0xd3, 0xb3, 0x45, 0x13, 0xdf, 0x15, 0xaa,
+    0x69, 0x6a, 0xa3, 0x55, 0xec, 0xc5, 0xfc, 0x3c, 0x38, 0x2b, 0xee, 0x65, 0xb2, 0x65, 0xef, 0xfd,
+    0x7f, 0xa7, 0xff, 0x66, 0x6c, 0x11, 0x63, 0xa7, 0x66, 0xb2, 0xe8, 0xc5, 0x92, 0xf4, 0xef, 0xe0,
+    0x57, 0xd5, 0x2d, 0xf2, 0xb5, 0xce, 0xbf, 0xf2, 0x02, 0x04, 0xaf, 0x57, 0x2e, 0xd5, 0xae, 0xc4,
+    0xec, 0x9c, 0x45, 0xfa, 0xc5, 0xd2, 0x9a, 0xdd, 0x63, 0xba, 0xcf, 0xbe, 0x1c, 0x2c, 0x9d, 0x78,
+    0xfe, 0x80, 0x11, 0x57, 0x49, 0xba, 0x94, 0xab, 0x19, 0x55, 0x8c, 0x5d, 0xb9, 0x80, 0xe5, 0x70,
+    0x90, 0x62, 0xcc, 0x83, 0x60, 0xea, 0x5d, 0x6b, 0xcb, 0x54, 0xbb, 0xda, 0xf9, 0x23, 0xf0, 0xd3,
+    0x71, 0xef, 0xf0, 0x20, 0x81, 0xee, 0xee, 0x1f, 0xc3, 0x4c, 0x79, 0x26, 0x3f, 0x82, 0xe1, 0x6e,
+    0xf3, 0xf3, 0x18, 0xae, 0x50, 0xf3, 0xca, 0x10, 0x1e, 0xdf, 0xf6, 0xbb, 0xe6, 0xe2, 0xa1, 0xbf,
+    0xe3, 0xe6, 0x62, 0xdc, 0x12, 0x45, 0x33, 0x77, 0xd9, 0x96, 0xf3, 0xec, 0x08, 0x06, 0xbb, 0x91,
+    0x4a, 0x00, 0x71, 0xa9, 0x59, 0xc2, 0x12, 0xc2, 0xff, 0xa4, 0x56, 0x21, 0xf0, 0x92, 0x2c, 0xf0,
+    0x9d, 0x86, 0x56, 0x6b, 0x8c, 0xa3, 0xc6, 0x59, 0xcd, 0x07, 0x71, 0xc1, 0xf3, 0xec, 0x7a, 0x22,
+    0xc4, 0x73, 0x4d, 0x20, 0x1d, 0x5c, 0xdf, 0x90, 0xa4, 0x83, 0x3e, 0x8b, 0x39, 0xb5, 0x45, 0xde,
+    0xb1, 0x8d, 0x9e, 0x4a, 0x45, 0xa9, 0xfc, 0xc5, 0x26, 0x09, 0x13, 0x55, 0x07, 0x84, 0x3f, 0x45,
+    0xc0, 0x95, 0x8a, 0xc9, 0xe4, 0x3e, 0x19, 0x3e, 0xdf, 0x1e, 0xd9, 0x24, 0x75, 0xef, 0x31, 0x52,
+    0xe7, 0xca, 0x5b, 0xee, 0xbf, 0x87, 0x0b, 0xb6, 0x7f, 0xb8, 0x7f, 0x2d, 0x38, 0x6a, 0xfd, 0xaa,
+    0xfc, 0xac, 0x3b, 0xcb, 0xbf, 0x93, 0xfc, 0x74, 0xe5, 0xb5, 0x53, 0xf4, 0xdb, 0xcf, 0x78, 0x37,
+    0x81, 0xbd, 0x83, 0x61, 0x54, 0xfc, 0x19, 0xcb, 0x27, 0x3f, 0xe4, 0x47, 0xb7, 0xda, 0xde, 0xe0,
+    0x70, 0x78, 0x70, 0x23, 0xe5, 0x9d, 0x47, 0x7c, 0xfa, 0x8e, 0x6b, 0xbc, 0x61, 0xc7, 0x2d, 0xb6,
+    0x8b, 0x19, 0xee, 0xff, 0xf3, 0x62, 0x55, 0x97, 0x97, 0x75, 0x7b, 0xeb, 0x0c, 0x1f, 0x3a, 0xb2,
+    0x22, 0xbf, 0xb6, 0x6a, 0xb7, 0x8a, 0xe3, 0x80, 0xbf, 0x6c, 0xf2, 0xe5, 0x17, 0xce, 0xff, 0x34,
+    0xe5, 0x24, 0x5c, 0xf1, 0x08, 0x00, 0x00
+};
+
+#define CLIP_PAGE_SIZE 3024
+PROGMEM const char CLIP_PAGE_ETAG[] = "\"fcf72739\"";
+PROGMEM const unsigned char CLIP_PAGE[] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xb5, 0x56, 0xdb, 0x6e, 0xdb, 0x38,
+    0x10, 0x7d, 0xf7, 0x57, 0x10, 0x28, 0x0a, 0xca, 0x58, 0xdf, 0xb1, 0x2d, 0x0a, 0x47, 0x36, 0x90,
+    0x8b, 0xd1, 0xa6, 0x70, 0x9a, 0x20, 0x49, 0x81, 0x3e, 0xec, 0x0b, 0x2d, 0x8e, 0x64, 0x22, 0x12,
+    0xa9, 0x92, 0x94, 0x5d, 0x75, 0x91, 0x7f, 0x5f, 0xd2, 0x94, 0x65, 0x59, 0x52, 0xdc, 0x6e, 0xd1,
+    0xd2, 0x80, 0x44, 0x53, 0x33, 0xe7, 0xcc, 0x0c, 0x67, 0x86, 0xf4, 0xd7, 0x3a, 0x89, 0xe7, 0x9d,
+    0x8e, 0xbf, 0x06, 0x42, 0xe7, 0x1d, 0x64, 0x86, 0xaf, 0x99, 0x8e, 0x61, 0x7e, 0x7e, 0x77, 0x8d,
+    0xae, 0x60, 0x95, 0x45, 0x48, 0x0b, 0x11, 0xfb, 0x43, 0xb7, 0xea, 0x24, 0x94, 0xce, 0xf7, 0x73,
+    0x3b, 0x56, 0x82, 0xe6, 0xe8, 0xdf, 0xf2, 0xaf, 0x1d, 0xa1, 0xe0, 0xba, 0x1f, 0x92, 0x84, 0xc5,
+    0xf9, 0x14, 0x6d, 0x40, 0x52, 0xc2, 0xc9, 0xd9, 0x91, 0x44, 0x42, 0x64, 0xc4, 0xf8, 0x14, 0x4d,
+    0x46, 0xe9, 0xb7, 0xc3, 0x97, 0xe7, 0x72, 0x56, 0x4e, 0xd6, 0xe3, 0x1a, 0xf6, 0x5e, 0xf3, 0x48,
+    0xb1, 0x24, 0x55, 0xec, 0x3b, 0xfc, 0x0c, 0xea, 0xa4, 0xcd, 0x62, 0xa7, 0x3c, 0x7e, 0x5b, 0x47,
+    0x76, 0x94, 0x7d, 0x2d, 0xd2, 0x3a, 0xb4, 0x1d, 0x81, 0x88, 0x85, 0x9c, 0xa2, 0x48, 0x42, 0x7e,
+    0x92, 0xf3, 0xd5, 0x2a, 0xd3, 0x5a, 0x70, 0x55, 0x63, 0x0e, 0x62, 0x20, 0x46, 0x3d, 0x86, 0x50,
+    0x9f, 0x54, 0x67, 0x3c, 0xcd, 0x74, 0x4d, 0x77, 0xcb, 0xa8, 0x5e, 0x1b, 0x8b, 0x47, 0xa3, 0xd7,
+    0x27, 0x75, 0x43, 0x21, 0x93, 0x9a, 0xea, 0x8a, 0x04, 0x4f, 0x91, 0x14, 0x19, 0xa7, 0x53, 0xf4,
+    0x0a, 0xde, 0xd9, 0xdf, 0x59, 0x1b, 0xf6, 0x9b, 0x51, 0xc3, 0xe1, 0x94, 0x50, 0xca, 0x78, 0xd4,
+    0x16, 0x8b, 0xfe, 0x16, 0x56, 0x4f, 0x4c, 0xf7, 0x57, 0x42, 0x52, 0x90, 0x7d, 0x49, 0x28, 0xcb,
+    0x94, 0x35, 0xb0, 0x21, 0x98, 0x88, 0xef, 0xa7, 0xa5, 0x5a, 0xdc, 0xd0, 0xf0, 0x4d, 0x13, 0x09,
+    0xa4, 0xe6, 0x4a, 0x61, 0x8f, 0xdb, 0x9f, 0x26, 0x55, 0x6b, 0x90, 0x1a, 0x59, 0x9a, 0x08, 0x4e,
+    0x02, 0xd1, 0xb3, 0x6f, 0xa1, 0x52, 0x12, 0xc0, 0x8b, 0xc9, 0x35, 0x9e, 0xfc, 0x71, 0xaf, 0xfd,
+    0x61, 0xa5, 0xc6, 0x7c, 0x15, 0x48, 0x96, 0xea, 0x43, 0xc1, 0x85, 0x19, 0x0f, 0x34, 0x13, 0x1c,
+    0x45, 0xa0, 0x3f, 0x3c, 0xde, 0x2c, 0xbd, 0x40, 0x24, 0x09, 0xe1, 0xb4, 0x5b, 0x8b, 0x0b, 0x0b,
+    0x91, 0xb7, 0x65, 0x9c, 0x8a, 0xed, 0xe0, 0xcb, 0xcd, 0xf2, 0x83, 0xd6, 0xe9, 0x3d, 0x7c, 0xcd,
+    0x40, 0xe9, 0xba, 0xa0, 0x1d, 0x1b, 0x22, 0xd1, 0xda, 0x88, 0xa0, 0x19, 0xe2, 0xb0, 0x45, 0xc7,
+    0x0a, 0x5e, 0xf7, 0xac, 0xa1, 0x60, 0x85, 0x07, 0x22, 0x05, 0xbe, 0xa7, 0xef, 0x21, 0x2a, 0x82,
+    0x2c, 0x01, 0xae, 0x07, 0xc5, 0x8a, 0x4d, 0xbb, 0xfd, 0x3c, 0x93, 0xf1, 0x60, 0x43, 0xe2, 0x0c,
+    0x7a, 0x48, 0xcb, 0x0c, 0x5e, 0x04, 0xe4, 0x66, 0x7f, 0x69, 0xae, 0x34, 0xd1, 0x10, 0xac, 0x09,
+    0x8f, 0xc0, 0x18, 0xb4, 0x77, 0xd8, 0x6b, 0x33, 0x7c, 0xef, 0xe9, 0x4e, 0x7d, 0xa7, 0xfc, 0x60,
+    0x95, 0xd1, 0x6c, 0x86, 0xfe, 0x7e, 0x49, 0xfe, 0x48, 0xc7, 0x72, 0x65, 0xca, 0xca, 0x4f, 0x46,
+    0xa3, 0x53, 0x1a, 0x76, 0xb4, 0xba, 0x28, 0x41, 0xa5, 0xa6, 0xb0, 0xc1, 0x39, 0x68, 0x0c, 0xc6,
+    0x17, 0x84, 0xa2, 0x8f, 0x0f, 0xb7, 0x9f, 0xa6, 0x08, 0xa3, 0xbf, 0x50, 0x61, 0x9a, 0x13, 0x7a,
+    0x34, 0x49, 0x7c, 0xf6, 0x1b, 0x38, 0x2c, 0xbc, 0xb1, 0x5d, 0x9a, 0xcc, 0x67, 0x61, 0xee, 0xed,
+    0xfe, 0xa6, 0x44, 0x2a, 0xf0, 0x1a, 0x74, 0xdd, 0x1e, 0xe2, 0x59, 0x1c, 0xf7, 0x10, 0xfe, 0x47,
+    0xe3, 0xee, 0xcb, 0xe4, 0xcf, 0x08, 0x62, 0x05, 0xbf, 0x27, 0x02, 0x0b, 0x29, 0x85, 0x3c, 0x78,
+    0xef, 0x82, 0x7c, 0x82, 0xba, 0xf3, 0x73, 0xab, 0xcf, 0xed, 0x69, 0xa3, 0x80, 0x53, 0xaf, 0xd5,
+    0xb2, 0x04, 0x94, 0x22, 0x11, 0xd8, 0x43, 0xca, 0x19, 0x57, 0xf3, 0xff, 0x18, 0x50, 0x82, 0xce,
+    0x24, 0x47, 0x21, 0x31, 0x71, 0xa8, 0x16, 0x65, 0xb3, 0xf6, 0x12, 0xc2, 0x9a, 0xf9, 0x68, 0x8b,
+    0x68, 0xa5, 0xf9, 0x7b, 0x69, 0xcb, 0xa8, 0x34, 0xc7, 0x94, 0x90, 0xcc, 0x1f, 0x20, 0x86, 0x40,
+    0x0b, 0x79, 0x1e, 0xc7, 0x1e, 0x76, 0x27, 0x41, 0x7d, 0x2b, 0xce, 0xa5, 0x24, 0xf9, 0x20, 0x94,
+    0x22, 0xf1, 0x1c, 0x48, 0x77, 0x60, 0x5c, 0x58, 0x90, 0x60, 0xed, 0x95, 0x15, 0x60, 0x3e, 0xb4,
+    0xa5, 0x68, 0xc9, 0x65, 0x5a, 0xc2, 0x22, 0x06, 0x3b, 0xbd, 0xc8, 0xaf, 0xa9, 0x15, 0x1f, 0x30,
+    0xda, 0x1d, 0x98, 0x0e, 0xb9, 0xd8, 0x98, 0xc5, 0x25, 0x53, 0x1a, 0x38, 0x48, 0x0f, 0x07, 0x31,
+    0x0b, 0x9e, 0x70, 0xef, 0xc7, 0xb5, 0xb5, 0x6f, 0x32, 0x16, 0xaa, 0x2d, 0x80, 0xbb, 0x00, 0xd5,
+    0x83, 0xda, 0x6d, 0x0d, 0x5e, 0x69, 0x65, 0xd3, 0x9c, 0xab, 0xdb, 0x9b, 0x4b, 0xd3, 0x62, 0xed,
+    0x9a, 0x20, 0x14, 0x68, 0xd5, 0x32, 0xb0, 0xa2, 0xdd, 0xc6, 0x35, 0xc0, 0xc6, 0xbf, 0x42, 0x53,
+    0xcc, 0x4d, 0xeb, 0x2c, 0xda, 0xa5, 0x3f, 0x74, 0xb7, 0x9a, 0x8e, 0x6f, 0x37, 0xbf, 0xe8, 0xa5,
+    0xbb, 0x93, 0x90, 0x93, 0x04, 0x66, 0xb8, 0x92, 0x25, 0xf8, 0xd0, 0x5c, 0xfd, 0xf5, 0x78, 0x7e,
+    0xb9, 0xbc, 0xbe, 0x43, 0xe5, 0x0d, 0x28, 0x02, 0x69, 0xa0, 0xc6, 0x55, 0x91, 0xc9, 0xfc, 0xf3,
+    0xfd, 0x72, 0x6a, 0x56, 0x27, 0x95, 0x55, 0x77, 0x40, 0x1f, 0x61, 0x9b, 0xa6, 0x87, 0x91, 0xce,
+    0x53, 0xb3, 0x62, 0xcf, 0x2e, 0x8c, 0xec, 0x09, 0x32, 0xc3, 0x6f, 0x47, 0x18, 0xed, 0x42, 0x39,
+    0xc3, 0x43, 0x92, 0xb2, 0x61, 0xa6, 0x40, 0x32, 0x3a, 0x8c, 0x59, 0xb4, 0xd6, 0xaa, 0x6a, 0x0b,
+    0x65, 0x1b, 0xc4, 0xe8, 0xac, 0xc8, 0x97, 0xea, 0xa7, 0xdd, 0x67, 0xb7, 0x5c, 0x10, 0x14, 0x39,
+    0xe5, 0xe4, 0x4d, 0xfa, 0x80, 0x2e, 0x49, 0xde, 0x2f, 0x1e, 0xf1, 0xdc, 0x3c, 0xfc, 0xa1, 0x13,
+    0xfa, 0x1f, 0x30, 0x77, 0xd9, 0x01, 0xe6, 0xee, 0xb3, 0x81, 0x31, 0x8f, 0x5f, 0x81, 0x11, 0xaa,
+    0x82, 0x73, 0xfb, 0x60, 0x81, 0xcc, 0xf3, 0x17, 0x90, 0xae, 0x4c, 0x1d, 0x69, 0x28, 0xb1, 0xae,
+    0x16, 0xcb, 0xc5, 0xe3, 0x02, 0xcf, 0xdd, 0xbb, 0x89, 0xe7, 0x0f, 0x4d, 0x0c, 0x8f, 0xb7, 0xee,
+    0xc6, 0x75, 0x04, 0x74, 0x61, 0xb2, 0xa2, 0xbe, 0x87, 0xe5, 0x0d, 0xc3, 0x6d, 0x63, 0xa5, 0x79,
+    0x60, 0x24, 0xc5, 0x56, 0xcd, 0xf0, 0xd8, 0xec, 0x9d, 0xb9, 0xf1, 0xed, 0x66, 0x23, 0x3c, 0x37,
+    0x37, 0xe3, 0x42, 0xe5, 0x98, 0xe4, 0xd2, 0x25, 0x00, 0xba, 0x2f, 0x1a, 0xe3, 0x0f, 0x88, 0xf6,
+    0xfd, 0x73, 0xcf, 0x32, 0x79, 0x73, 0x92, 0xc5, 0x1f, 0xda, 0xac, 0xb5, 0x29, 0xee, 0x52, 0xdb,
+    0xe6, 0xba, 0xbd, 0xc9, 0xff, 0x07, 0x88, 0xa3, 0xa6, 0x73, 0xd0, 0x0b, 0x00, 0x00
+};
+
+#define HUE_PAGES(X) \
+    X(INDEX_PAGE, "index.html") \
+    X(CLIP_PAGE, "clip.html")
@@ -0,0 +1,165 @@
+#include "HueRouter.h"
+#include <string.h>
+
+#define HUE_ROUTE_MAX_SEGMENTS  4   // {u}/{resource}/{id}/{sub}
+
+typedef enum {
+    RESOURCE_NONE,
+    RESOURCE_CONFIG,
+    RESOURCE_LIGHTS,
+    RESOURCE_GROUPS,
+    RESOURCE_SCENES,
+} Resource;
+
+static Resource resource(const char * name, size_t length)
+{
+    if (length != 6)
+    {
+        return RESOURCE_NONE;
+    }
+    switch (name[0])
+    {
+        case 'c': return memcmp(name, "config", 6) == 0 ? RESOURCE_CONFIG : RESOURCE_NONE;
+        case 'l': return memcmp(name, "lights", 6) == 0 ? RESOURCE_LIGHTS : RESOURCE_NONE;
+        case 'g': return memcmp(name, "groups", 6) == 0 ? RESOURCE_GROUPS : RESOURCE_NONE;
+        case 's': return memcmp(name, "scenes", 6) == 0 ? RESOURCE_SCENES : RESOURCE_NONE;
+        default:  return RESOURCE_NONE;
+    }
+}
+
+// ids are 1 to 3 digits, anything else does not name a resource
+static int parseId(const char * text, size_t length)
+{
+    if (length == 0 || length > 3)
+    {
+        return -1;
+    }
+    int id = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        if (text[i] < '0' || text[i] > '9')
+        {
+            return -1;
+        }
+        id = id * 10 + (text[i] - '0');
+    }
+    return id;
+}
+
+static HueRoute match(HTTPMethod method, HTTPMethod expected, HueRoute route)
+{
+    return method == expected ? route : HUE_ROUTE_NONE;
+}
+
+HueRoute hueRoute(HTTPMethod method, const char * uri, hue_path_t * path)
+{
+    path->route = HUE_ROUTE_NONE;
+    path->user = NULL;
+    path->userLength = 0;
+    path->id = -1;
+    path->sub = NULL;
+    path->subLength = 0;
+
+    if (strncmp(uri, "/api", 4) != 0 || (uri[4] != 0 && uri[4] != '/'))
+    {
+        return HUE_ROUTE_NONE;
+    }
+
+    // split what follows /api into segments, a trailing / is ignored
+    const char * segments[HUE_ROUTE_MAX_SEGMENTS];
+    size_t lengths[HUE_ROUTE_MAX_SEGMENTS];
+    int count = 0;
+    const char * p = uri + 4;
+    while (*p == '/' && p[1] != 0 && p[1] != '?')
+    {
+        p++;
+        if (count == HUE_ROUTE_MAX_SEGMENTS)
+        {
+            return HUE_ROUTE_NONE;
+        }
+        const char * start = p;
+        while (*p != 0 && *p != '/' && *p != '?')
+        {
+            p++;
+        }
+        if (p == start || p - start > 0xFF)
+        {
+            return HUE_ROUTE_NONE;
+        }
+        segments[count] = start;
+        lengths[count] = p - start;
+        count++;
+    }
+    if (*p == '/')
+    {
+        p++;
+    }
+    if (*p != 0 && *p != '?')
+    {
+        return HUE_ROUTE_NONE;
+    }
+
+    if (count == 0)
+    {
+        path->route = match(method, HTTP_POST, HUE_ROUTE_CREATE_USER);
+        return path->route;
+    }
+
+    path->user = segments[0];
+    path->userLength = lengths[0];
+    if (count >= 3)
+    {
+        path->id = parseId(segments[2], lengths[2]);
+        if (path->id < 0)
+        {
+            return HUE_ROUTE_NONE;
+        }
+    }
+    if (count == 4)
+    {
+        path->sub = segments[3];
+        path->subLength = lengths[3];
+    }
+
+    switch (count == 1 ? RESOURCE_NONE : resource(segments[1], lengths[1]))
+    {
+        case RESOURCE_NONE:
+            path->route = count == 1 ? match(method, HTTP_GET, HUE_ROUTE_DATASTORE) : HUE_ROUTE_NONE;
+            break;
+        case RESOURCE_CONFIG:
+            path->route = count == 2 ? match(method, HTTP_GET, HUE_ROUTE_CONFIG) : HUE_ROUTE_NONE;
+            break;
+        case RESOURCE_LIGHTS:
+            if (count == 2)
+            {
+                path->route = match(method, HTTP_GET, HUE_ROUTE_LIGHTS);
+            }
+            else if (count == 3)
+            {
+                path->route = match(method, HTTP_GET, HUE_ROUTE_LIGHT);
+            }
+            else if (path->subLength == 5 && memcmp(path->sub, "state", 5) == 0)
+            {
+                path->route = match(method, HTTP_PUT, HUE_ROUTE_LIGHT_STATE);
+            }
+            break;
+        case RESOURCE_GROUPS:
+            if (count == 2)
+            {
+                path->route = match(method, HTTP_GET, HUE_ROUTE_GROUPS);
+            }
+            else if (count == 3)
+            {
+                path->route = match(method, HTTP_GET, HUE_ROUTE_GROUP);
+            }
+            else if (path->subLength == 6 && memcmp(path->sub, "action", 6) == 0)
+            {
+                path->route = match(method, HTTP_PUT, HUE_ROUTE_GROUP_ACTION);
+            }
+            break;
+        case RESOURCE_SCENES:
+            path->route = count == 2 ? match(method, HTTP_GET, HUE_ROUTE_SCENES) : HUE_ROUTE_NONE;
+            break;
+    }
+    return path->route;
+}
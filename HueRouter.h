@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <HTTP_Method.h>
+
+// Hue API requests the bridge answers, anything else is HUE_ROUTE_NONE
+typedef enum {
+    HUE_ROUTE_NONE,
+    HUE_ROUTE_CREATE_USER,      // POST /api
+    HUE_ROUTE_DATASTORE,        // GET  /api/{u}
+    HUE_ROUTE_CONFIG,           // GET  /api/{u}/config
+    HUE_ROUTE_LIGHTS,           // GET  /api/{u}/lights
+    HUE_ROUTE_LIGHT,            // GET  /api/{u}/lights/{id}
+    HUE_ROUTE_LIGHT_STATE,      // PUT  /api/{u}/lights/{id}/state
+    HUE_ROUTE_GROUPS,           // GET  /api/{u}/groups
+    HUE_ROUTE_GROUP,            // GET  /api/{u}/groups/{id}
+    HUE_ROUTE_GROUP_ACTION,     // PUT  /api/{u}/groups/{id}/action
+    HUE_ROUTE_SCENES,           // GET  /api/{u}/scenes
+    HUE_ROUTE_COUNT
+} HueRoute;
+
+// segments of the path, pointing into the uri that was routed
+typedef struct {
+    HueRoute route;
+    const char * user;          // username, not terminated
+    uint8_t userLength;
+    int id;                     // light or group id, -1 when the path has none
+    const char * sub;           // segment after the id, e.g. "state"
+    uint8_t subLength;
+} hue_path_t;
+
+/*
+    Router for the Hue REST API. The path is split into its segments in one
+    pass and dispatched with a switch on the resource and the number of
+    segments, instead of matching every {} pattern in turn and then taking the
+    uri apart again with indexOf, substring and toInt in each handler. Nothing
+    is copied or allocated.
+
+    hue_path_t path;
+    if (hueRoute(HTTP_PUT, "/api/userid/lights/1/state", &path) == HUE_ROUTE_LIGHT_STATE)
+        path.id is 1
+
+    A path that matches but with another method is HUE_ROUTE_NONE, so it gets
+    the same 404 as an unknown path.
+*/
+HueRoute hueRoute(HTTPMethod method, const char * uri, hue_path_t * path);
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <limits>
+
+// Largest buffer a template may need, a bigger one is a compile error
+#define HUE_TEMPLATE_MAX_SIZE       4096
+
+/*
+    Compile time sizing of the printf style templates in templates.h and
+    UPnP.h. The templates are constexpr arrays, so the longest text they can
+    produce is worked out by the compiler from the template and the types
+    of its fields, and handlers get a fixed size buffer that cannot truncate
+    instead of strlen_P(TEMPLATE) plus a guess.
+
+    constexpr size_t HUE_USER_JSON_SIZE = hueTemplateSize<HueText<6> >(HUE_USER_JSON_TEMPLATE);
+    char buffer[HUE_USER_JSON_SIZE];
+    snprintf_P(buffer, sizeof(buffer), HUE_USER_JSON_TEMPLATE, "userid");
+
+    A field is sized by its type: the digits of the largest value of an
+    integer type (%d of a uint8_t is 3), the bound N of a HueText<N> string,
+    or the width of the conversion when that is larger (%04d). A const char *
+    has no bound, the conversion has to give one as its precision (%.64s).
+    The number of fields has to match the conversions of the template, and
+    the size stays under HUE_TEMPLATE_MAX_SIZE, otherwise the constant can
+    not be evaluated and the build fails on the call of
+    template_fields_do_not_match or template_too_large.
+
+    The template is scanned by halves so that the recursion depth stays at
+    the log of its length, C++11 constexpr has no loops.
+*/
+
+// a string of at most N characters
+template <size_t N> struct HueText {};
+
+template <typename T> struct HueField;
+
+constexpr size_t hueDigits(unsigned long long value)
+{
+    return value < 10 ? 1 : 1 + hueDigits(value / 10);
+}
+
+template <typename T> struct HueField
+{
+    static constexpr size_t size = hueDigits((unsigned long long)std::numeric_limits<T>::max()) + (std::numeric_limits<T>::is_signed ? 1 : 0);
+    static constexpr bool bounded = true;
+};
+
+template <size_t N> struct HueField<HueText<N> >
+{
+    static constexpr size_t size = N;
+    static constexpr bool bounded = true;
+};
+
+template <> struct HueField<const char *>
+{
+    static constexpr size_t size = HUE_TEMPLATE_MAX_SIZE;
+    static constexpr bool bounded = false;
+};
+
+// not constexpr, calling them while sizing a template stops the build
+size_t template_fields_do_not_match();
+size_t template_too_large();
+
+// number of '%' right before position i
+constexpr size_t huePercentRun(const char * text, size_t i)
+{
+    return i > 0 && text[i - 1] == '%' ? 1 + huePercentRun(text, i - 1) : 0;
+}
+
+constexpr bool hueStartsSpec(const char * text, size_t i)
+{
+    return text[i] == '%' && huePercentRun(text, i) % 2 == 0;
+}
+
+// true at the '%' of a conversion, false at a %% escape
+constexpr bool hueIsConversion(const char * text, size_t i)
+{
+    return hueStartsSpec(text, i) && text[i + 1] != '%';
+}
+
+constexpr bool hueIsModifier(char c)
+{
+    return c == '-' || c == '+' || c == ' ' || c == '#' || c == '.' || (c >= '0' && c <= '9') || c == 'l' || c == 'h' || c == 'z';
+}
+
+// characters after the '%' up to and including the conversion letter
+constexpr size_t hueSpecLength(const char * text, size_t i)
+{
+    return hueIsModifier(text[i]) ? 1 + hueSpecLength(text, i + 1) : 1;
+}
+
+constexpr size_t hueNumber(const char * text, size_t i, size_t value)
+{
+    return text[i] >= '0' && text[i] <= '9' ? hueNumber(text, i + 1, value * 10 + (text[i] - '0')) : value;
+}
+
+constexpr size_t hueSkipFlags(const char * text, size_t i)
+{
+    return text[i] == '-' || text[i] == '+' || text[i] == ' ' || text[i] == '#' || text[i] == '0' ? hueSkipFlags(text, i + 1) : i;
+}
+
+constexpr size_t hueSkipDigits(const char * text, size_t i)
+{
+    return text[i] >= '0' && text[i] <= '9' ? hueSkipDigits(text, i + 1) : i;
+}
+
+// minimum width of the conversion at i, 0 when it has none
+constexpr size_t hueSpecWidth(const char * text, size_t i)
+{
+    return hueNumber(text, hueSkipFlags(text, i + 1), 0);
+}
+
+// precision of the conversion at i, -1 when it has none
+constexpr long hueSpecPrecision(const char * text, size_t i)
+{
+    return text[hueSkipDigits(text, hueSkipFlags(text, i + 1))] == '.'
+        ? (long)hueNumber(text, hueSkipDigits(text, hueSkipFlags(text, i + 1)) + 1, 0) : -1;
+}
+
+// template characters that are not copied to the output as they are
+constexpr size_t hueSpecChars(const char * text, size_t i)
+{
+    return hueIsConversion(text, i) ? 1 + hueSpecLength(text, i + 1) : hueStartsSpec(text, i) ? 1 : 0;
+}
+
+constexpr size_t hueSpecCharsIn(const char * text, size_t begin, size_t end)
+{
+    return end - begin == 0 ? 0 : end - begin == 1 ? hueSpecChars(text, begin)
+        : hueSpecCharsIn(text, begin, (begin + end) / 2) + hueSpecCharsIn(text, (begin + end) / 2, end);
+}
+
+constexpr size_t hueConversionsIn(const char * text, size_t begin, size_t end)
+{
+    return end - begin == 0 ? 0 : end - begin == 1 ? (hueIsConversion(text, begin) ? 1 : 0)
+        : hueConversionsIn(text, begin, (begin + end) / 2) + hueConversionsIn(text, (begin + end) / 2, end);
+}
+
+// position of conversion n within [begin, end)
+constexpr size_t hueConversionAt(const char * text, size_t begin, size_t end, size_t n)
+{
+    return end - begin == 1 ? begin
+        : n < hueConversionsIn(text, begin, (begin + end) / 2) ? hueConversionAt(text, begin, (begin + end) / 2, n)
+        : hueConversionAt(text, (begin + end) / 2, end, n - hueConversionsIn(text, begin, (begin + end) / 2));
+}
+
+constexpr size_t hueFieldSize(const char * text, size_t at, size_t size, bool bounded)
+{
+    return text[at + hueSpecLength(text, at + 1)] == 's' && hueSpecPrecision(text, at) >= 0 && (size_t)hueSpecPrecision(text, at) < size
+        ? (size_t)hueSpecPrecision(text, at)
+        : !bounded ? template_too_large()
+        : size > hueSpecWidth(text, at) ? size : hueSpecWidth(text, at);
+}
+
+template <size_t I, typename... Fields> struct HueFields;
+
+template <size_t I> struct HueFields<I>
+{
+    static constexpr size_t count = 0;
+    static constexpr size_t size(const char *, size_t) { return 0; }
+};
+
+template <size_t I, typename T, typename... Rest> struct HueFields<I, T, Rest...>
+{
+    static constexpr size_t count = 1 + sizeof...(Rest);
+    static constexpr size_t size(const char * text, size_t length)
+    {
+        return hueFieldSize(text, hueConversionAt(text, 0, length, I), HueField<T>::size, HueField<T>::bounded)
+            + HueFields<I + 1, Rest...>::size(text, length);
+    }
+};
+
+constexpr size_t hueCheckSize(size_t size)
+{
+    return size <= HUE_TEMPLATE_MAX_SIZE ? size : template_too_large();
+}
+
+// bytes the template can produce with these fields, including the terminator
+template <typename... Fields, size_t N>
+constexpr size_t hueTemplateSize(const char (&text)[N])
+{
+    return hueConversionsIn(text, 0, N - 1) != sizeof...(Fields) ? template_fields_do_not_match()
+        : hueCheckSize(N - hueSpecCharsIn(text, 0, N - 1) + HueFields<0, Fields...>::size(text, N - 1));
+}
@@ -0,0 +1,55 @@
+#include "Platform.h"
+
+#ifdef HUE_HOST
+    #include <malloc.h>
+    #include <atomic>
+    #include <new>
+
+    static std::atomic<size_t> heapAllocated(0);
+
+    void * operator new(size_t size)
+    {
+        heapAllocated.fetch_add(size, std::memory_order_relaxed);
+        void * p = malloc(size > 0 ? size : 1);
+        if (p == NULL)
+        {
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+
+    void operator delete(void * p) noexcept
+    {
+        free(p);
+    }
+
+    void operator delete(void * p, size_t) noexcept
+    {
+        free(p);
+    }
+#endif
+
+void platformBridgeId(char * buffer, size_t size)
+{
+    uint8_t mac[6];
+    WiFi.macAddress(mac);
+    snprintf(buffer, size, "%02x%02x%02x%02x%02x%02x", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+}
+
+size_t platformHeapUsed()
+{
+#ifdef HUE_HOST
+    return mallinfo2().uordblks;
+#else
+    return ESP.getHeapSize() - ESP.getFreeHeap();
+#endif
+}
+
+size_t platformHeapAllocated()
+{
+#ifdef HUE_HOST
+    return heapAllocated.load(std::memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
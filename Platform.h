@@ -0,0 +1,31 @@
+#pragma once
+
+/*
+    Platform layer of the bridge. On the ESP32 this is the Arduino core with
+    WiFi and WiFiUDP. Without ARDUINO the code is built for Linux against the
+    stand-ins in host/, where WiFi reports a configured MAC and IP address and
+    WiFiUDP is implemented with BSD sockets (see host/README.md).
+*/
+
+#include <Arduino.h>
+
+#if defined(ARDUINO_ARCH_ESP32)
+    #include <WiFi.h>
+    #include <WiFiUdp.h>
+#elif !defined(ARDUINO)
+    #define HUE_HOST
+    #include "WiFi.h"
+    #include "WiFiUdp.h"
+#else
+    #error Platform not supported
+#endif
+
+// MAC address as 12 lower case hex digits, used as serial number and bridge id
+void platformBridgeId(char * buffer, size_t size);
+
+// Bytes of heap in use, for the metrics
+size_t platformHeapUsed();
+
+// Bytes allocated since startup, for the heap churn of a request. Only the
+// host build counts them (through operator new), on the ESP32 it is 0
+size_t platformHeapAllocated();
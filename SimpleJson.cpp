@@ -3,9 +3,274 @@
 #include "WString.h"
 #include <map>
 #include "SimpleJson.h"
+#include "HueLog.h"
+
+#ifndef HUE_LOG_LEVEL_JSON
+    #define HUE_LOG_LEVEL_JSON      HUE_LOG_LEVEL
+#endif
+#define LOG_JSON(level, fmt, ...)   HUE_LOG(HUE_LOG_LEVEL_JSON, level, "json", fmt, ## __VA_ARGS__)
 
 // https://www.json.org/json-en.html
 
+static const float POW10[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+
+/*
+    Parses an int, fraction and exponent in a single pass without copying the
+    text. Returns the number of characters consumed, isFloat is set when the
+    number had a fraction or an exponent (or does not fit into an int).
+*/
+static int parseNumber( const char* str, int* iValue, float* fValue, bool* isFloat )
+{
+    const char* p = str;
+    uint32_t mantissa = 0;
+    int exponent = 0;
+    *isFloat = false;
+
+    bool negative = ( *p == '-' );
+    if ( negative )
+    {
+        p++;
+    }
+
+    while ( *p >= '0' && *p <= '9' )
+    {
+        if ( mantissa < 214748364 )
+        {
+            mantissa = mantissa * 10 + ( *p - '0' );
+        }
+        else
+        {
+            exponent++;    // too many digits for an int, keep the magnitude only
+            *isFloat = true;
+        }
+        p++;
+    }
+
+    if ( *p == '.' )
+    {
+        *isFloat = true;
+        p++;
+        while ( *p >= '0' && *p <= '9' )
+        {
+            if ( mantissa < 214748364 )
+            {
+                mantissa = mantissa * 10 + ( *p - '0' );
+                exponent--;
+            }
+            p++;
+        }
+    }
+
+    if ( *p == 'e' || *p == 'E' )
+    {
+        *isFloat = true;
+        p++;
+        bool negativeExp = ( *p == '-' );
+        if ( *p == '-' || *p == '+' )
+        {
+            p++;
+        }
+        int exp = 0;
+        while ( *p >= '0' && *p <= '9' )
+        {
+            if ( exp < 1000 )
+            {
+                exp = exp * 10 + ( *p - '0' );
+            }
+            p++;
+        }
+        exponent += negativeExp ? -exp : exp;
+    }
+
+    float value = mantissa;
+    int scale = exponent < 0 ? -exponent : exponent;
+    while ( scale > 0 && value != 0 )
+    {
+        int step = scale > 10 ? 10 : scale;
+        value = exponent < 0 ? value / POW10[step] : value * POW10[step];
+        scale -= step;
+    }
+
+    *fValue = negative ? -value : value;
+    if ( *isFloat )
+    {
+        *iValue = jsonFloatToInt( *fValue );    // 1e999 is inf
+    }
+    else
+    {
+        *iValue = negative ? -(int)mantissa : (int)mantissa;
+    }
+    return p - str;
+}
+
+static int parseHex4( const char* str, int len, int i )
+{
+    int retVal = 0;
+    if ( i + 4 > len )
+    {
+        return -1;
+    }
+    for ( int end = i + 4; i < end; i++ )
+    {
+        char c = str[i];
+        retVal <<= 4;
+        if ( c >= '0' && c <= '9' ) retVal |= c - '0';
+        else if ( c >= 'a' && c <= 'f' ) retVal |= c - 'a' + 10;
+        else if ( c >= 'A' && c <= 'F' ) retVal |= c - 'A' + 10;
+        else return -1;
+    }
+    return retVal;
+}
+
+/*
+    Decodes the escape sequence whose letter is at str[*i] (the character after
+    the backslash) into out and returns the number of bytes written. \u escapes
+    are written as utf-8, including surrogate pairs, *i is left on the last
+    character of the sequence.
+*/
+static int decodeEscape( const char* str, int len, int* i, char* out )
+{
+    switch( str[*i] )
+    {
+        case 'b': out[0] = '\b'; return 1;
+        case 'f': out[0] = '\f'; return 1;
+        case 'n': out[0] = '\n'; return 1;
+        case 'r': out[0] = '\r'; return 1;
+        case 't': out[0] = '\t'; return 1;
+        case 'u':
+            break;
+        default:  out[0] = str[*i]; return 1;
+    }
+
+    long code = parseHex4( str, len, *i + 1 );
+    if ( code < 0 )
+    {
+        out[0] = 'u';
+        return 1;
+    }
+    (*i) += 4;
+
+    if ( code >= 0xD800 && code <= 0xDBFF )
+    {
+        int low = ( *i + 2 < len && str[*i + 1] == '\\' && str[*i + 2] == 'u' ) ? parseHex4( str, len, *i + 3 ) : -1;
+        if ( low >= 0xDC00 && low <= 0xDFFF )
+        {
+            code = 0x10000 + ( ( code - 0xD800 ) << 10 ) + ( low - 0xDC00 );
+            (*i) += 6;
+        }
+        else
+        {
+            code = 0xFFFD;   // unpaired surrogate
+        }
+    }
+    else if ( code >= 0xDC00 && code <= 0xDFFF )
+    {
+        code = 0xFFFD;
+    }
+
+    if ( code < 0x80 )
+    {
+        out[0] = code;
+        return 1;
+    }
+    if ( code < 0x800 )
+    {
+        out[0] = 0xC0 | ( code >> 6 );
+        out[1] = 0x80 | ( code & 0x3F );
+        return 2;
+    }
+    if ( code < 0x10000 )
+    {
+        out[0] = 0xE0 | ( code >> 12 );
+        out[1] = 0x80 | ( ( code >> 6 ) & 0x3F );
+        out[2] = 0x80 | ( code & 0x3F );
+        return 3;
+    }
+    out[0] = 0xF0 | ( code >> 18 );
+    out[1] = 0x80 | ( ( code >> 12 ) & 0x3F );
+    out[2] = 0x80 | ( ( code >> 6 ) & 0x3F );
+    out[3] = 0x80 | ( code & 0x3F );
+    return 4;
+}
+
+/*
+    Copy of the text of a string token with the escape sequences replaced.
+    The decoded length is counted first so the String is allocated exactly once.
+*/
+static String decodeString( const char* str, int len )
+{
+    char utf8[4];
+    int decodedLen = 0;
+    for ( int i = 0; i < len; i++ )
+    {
+        if ( str[i] == '\\' && i + 1 < len )
+        {
+            i++;
+            decodedLen += decodeEscape( str, len, &i, utf8 );
+        }
+        else
+        {
+            decodedLen++;
+        }
+    }
+
+    String retVal;
+    retVal.reserve( decodedLen );
+    for ( int i = 0; i < len; i++ )
+    {
+        if ( str[i] == '\\' && i + 1 < len )
+        {
+            i++;
+            int count = decodeEscape( str, len, &i, utf8 );
+            for ( int j = 0; j < count; j++ )
+            {
+                retVal += utf8[j];
+            }
+        }
+        else
+        {
+            retVal += str[i];
+        }
+    }
+    return retVal;
+}
+
+/*
+    Appends text to json as the inside of a string, the quotes are left to the
+    caller. Quote, backslash and the control characters are escaped, UTF-8 is
+    copied as it is.
+*/
+void jsonAppendString( String& json, const char* text )
+{
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    const char* run = text;
+    for ( ; *text != 0; text++ )
+    {
+        unsigned char c = *text;
+        if ( c != '"' && c != '\\' && c >= 0x20 )
+        {
+            continue;
+        }
+        json.concat( run, text - run );
+        run = text + 1;
+        json += '\\';
+        switch ( c )
+        {
+            case '"':  json += '"'; break;
+            case '\\': json += '\\'; break;
+            case '\n': json += 'n'; break;
+            case '\r': json += 'r'; break;
+            case '\t': json += 't'; break;
+            default:
+                json += "u00";
+                json += HEX_DIGITS[c >> 4];
+                json += HEX_DIGITS[c & 0x0F];
+                break;
+        }
+    }
+    json.concat( run, text - run );
+}
+
 void SimpleJson::parse(String data){
     int index = 0;
 
@@ -24,7 +289,7 @@ JsonValue SimpleJson::getValue( int* index, const char* ptr ){
     }
     else if ( isNumber(index, ptr) )
     {
-        value.setValue( getNumber( index, ptr ) );
+        value = getNumber( index, ptr );
     }
     else if (isObject(index, ptr) )
     {
@@ -116,55 +381,16 @@ String SimpleJson::getString( int* index, const char* ptr )
     if ( ptr[*index] == '"' )
     {
         (*index)++;   // skip the openning quote
+        int start = *index;
         while ( ptr[*index] != 0 && ptr[*index] != '"' )
         {
-            if ( ptr[*index] == '\\' )
-            {
-                (*index)++;    
-                switch( ptr[*index] )
-                {
-                    case '"':
-                        retVal += '"';
-                        break;
-                    case '\\':
-                        retVal += '\\';
-                        break;
-                    case '/':
-                        retVal += '/';
-                        break;            
-                    case 'b':
-                        retVal += '\b';
-                        break;   
-                    case 'f':
-                        retVal += '\f';
-                        break;   
-                    case 'n':
-                        retVal += '\n';
-                        break;   
-                    case 'r':
-                        retVal += '\r';
-                        break;   
-                    case 't':
-                        retVal += '\t';
-                        break;   
-                    case 'u':
-                        char digits[5];
-                        digits[0] = ptr[(*index) + 1];
-                        digits[1] = ptr[(*index) + 2];
-                        digits[2] = ptr[(*index) + 3];
-                        digits[3] = ptr[(*index) + 4];
-                        digits[4] = 0;
-                        (*index) += 4;
-                        retVal += atoi(digits);
-                        break;                                                                                                                                                               
-                }
-            }    
-            else
+            if ( ptr[*index] == '\\' && ptr[(*index) + 1] != 0 )
             {
-                retVal += ptr[(*index)];
+                (*index)++;
             }
             (*index)++;
         }
+        retVal = decodeString( ptr + start, (*index) - start );
     }
 
     if ( ptr[*index] == '"' )
@@ -174,28 +400,23 @@ String SimpleJson::getString( int* index, const char* ptr )
     return retVal;
 }
 
-int SimpleJson::getNumber( int* index, const char* ptr )
+JsonValue SimpleJson::getNumber( int* index, const char* ptr )
 {
-    int retVal = 0;
-    String num = "";
-    bool negative = false;
+    JsonValue retVal;
+    int iValue;
+    float fValue;
+    bool isFloat;
+
     skipWhitespace(index, ptr);
+    (*index) += parseNumber( ptr + (*index), &iValue, &fValue, &isFloat );
 
-    if ( ptr[*index] == '-' )
+    if ( isFloat )
     {
-        negative = true;
-        (*index)++;
+        retVal.setValue( fValue );
     }
-
-    while ( ptr[*index] >= '0' && ptr[*index] <= '9' )
+    else
     {
-        num += ptr[*index];
-        (*index)++;
-    }
-
-    retVal = atoi(num.c_str());
-    if ( negative ){
-        retVal = retVal * -1;
+        retVal.setValue( iValue );
     }
     return retVal;
 }
@@ -301,4 +522,510 @@ JsonValue SimpleJson::operator[]( String name)
 JsonValue SimpleJson::operator[]( int index )
 {
     return rootValue[index];
-}
\ No newline at end of file
+}
+
+JsonTokenizer::TokenType JsonTokenizer::next()
+{
+    if ( token == ERROR )
+    {
+        return token;
+    }
+
+    // skip whitespace and the separators between values
+    while ( ptr[index] == ' ' || ptr[index] == '\n' || ptr[index] == '\r' || ptr[index] == '\t' || ptr[index] == ',' )
+    {
+        if ( ptr[index] == ',' )
+        {
+            expectKey = inObject();
+        }
+        index++;
+    }
+
+    char c = ptr[index];
+    if ( c == 0 )
+    {
+        token = level == 0 ? END : ERROR;
+        return token;
+    }
+
+    if ( expectKey && c != '}' )
+    {
+        if ( c != '"' || scanString( KEY ) == ERROR )
+        {
+            return setError();
+        }
+
+        while ( ptr[index] == ' ' || ptr[index] == '\n' || ptr[index] == '\r' || ptr[index] == '\t' )
+        {
+            index++;
+        }
+        if ( ptr[index] != ':' )
+        {
+            return setError();
+        }
+        index++; // skip the colon
+        expectKey = false;
+        return token;
+    }
+
+    switch ( c )
+    {
+        case '{':
+        case '[':
+            if ( level >= 32 )
+            {
+                return setError();
+            }
+            if ( c == '{' )
+            {
+                objectLevels |= (1UL << level);
+            }
+            else
+            {
+                objectLevels &= ~(1UL << level);
+            }
+            level++;
+            index++;
+            expectKey = ( c == '{' );
+            token = ( c == '{' ) ? OBJECT_START : ARRAY_START;
+            break;
+        case '}':
+        case ']':
+            if ( level == 0 || inObject() != ( c == '}' ) )
+            {
+                return setError();
+            }
+            level--;
+            index++;
+            expectKey = false;
+            token = ( c == '}' ) ? OBJECT_END : ARRAY_END;
+            break;
+        case '"':
+            scanString( STRING );
+            break;
+        case 't':
+            scanLiteral( "true", 4, TRUE_TYPE );
+            break;
+        case 'f':
+            scanLiteral( "false", 5, FALSE_TYPE );
+            break;
+        case 'n':
+            scanLiteral( "null", 4, NULL_TYPE );
+            break;
+        default:
+            if ( c != '-' && ( c < '0' || c > '9' ) )
+            {
+                return setError();
+            }
+            tokenIndex = index;
+            index++;
+            while ( ( ptr[index] >= '0' && ptr[index] <= '9' ) || ptr[index] == '.' || ptr[index] == 'e' || ptr[index] == 'E'
+                || ( ( ptr[index] == '-' || ptr[index] == '+' ) && ( ptr[index - 1] == 'e' || ptr[index - 1] == 'E' ) ) )
+            {
+                index++;
+            }
+            tokenLen = index - tokenIndex;
+            token = NUMBER;
+            break;
+    }
+    return token;
+}
+
+// consumes the next value, including everything nested inside of it
+bool JsonTokenizer::skipValue()
+{
+    int start = level;
+    TokenType type = next();
+    while ( level > start && type != ERROR && type != END )
+    {
+        type = next();
+    }
+    return type != ERROR && type != END;
+}
+
+bool JsonTokenizer::keyEquals(const char* name)
+{
+    return strncmp( ptr + tokenIndex, name, tokenLen ) == 0 && name[tokenLen] == 0;
+}
+
+int JsonTokenizer::getInt()
+{
+    int iValue = 0;
+    float fValue;
+    bool isFloat;
+    if ( token == NUMBER )
+    {
+        parseNumber( ptr + tokenIndex, &iValue, &fValue, &isFloat );
+    }
+    return iValue;
+}
+
+float JsonTokenizer::getFloat()
+{
+    int iValue;
+    float fValue = 0;
+    bool isFloat;
+    if ( token == NUMBER )
+    {
+        parseNumber( ptr + tokenIndex, &iValue, &fValue, &isFloat );
+    }
+    return fValue;
+}
+
+int32_t JsonTokenizer::getFixed( int decimals )
+{
+    if ( token != NUMBER )
+    {
+        return 0;
+    }
+
+    const char* p = ptr + tokenIndex;
+    bool negative = ( *p == '-' );
+    if ( negative )
+    {
+        p++;
+    }
+
+    // value is mantissa * 10^exponent
+    int64_t mantissa = 0;
+    int exponent = decimals;
+    while ( *p >= '0' && *p <= '9' )
+    {
+        if ( mantissa < 100000000000000000LL )
+        {
+            mantissa = mantissa * 10 + ( *p - '0' );
+        }
+        else
+        {
+            exponent++;
+        }
+        p++;
+    }
+    if ( *p == '.' )
+    {
+        p++;
+        while ( *p >= '0' && *p <= '9' )
+        {
+            if ( mantissa < 100000000000000000LL )
+            {
+                mantissa = mantissa * 10 + ( *p - '0' );
+                exponent--;
+            }
+            p++;
+        }
+    }
+    if ( *p == 'e' || *p == 'E' )
+    {
+        p++;
+        bool negativeExp = ( *p == '-' );
+        if ( *p == '-' || *p == '+' )
+        {
+            p++;
+        }
+        int exp = 0;
+        while ( *p >= '0' && *p <= '9' )
+        {
+            exp = exp < 100 ? exp * 10 + ( *p - '0' ) : exp;
+            p++;
+        }
+        exponent += negativeExp ? -exp : exp;
+    }
+
+    while ( exponent > 0 && mantissa <= INT32_MAX )
+    {
+        mantissa *= 10;
+        exponent--;
+    }
+    while ( exponent < -1 && mantissa > 0 )
+    {
+        mantissa /= 10;
+        exponent++;
+    }
+    if ( exponent == -1 )
+    {
+        mantissa = ( mantissa + 5 ) / 10;
+    }
+    if ( mantissa > INT32_MAX )
+    {
+        mantissa = INT32_MAX;
+    }
+    return negative ? -(int32_t)mantissa : (int32_t)mantissa;
+}
+
+JsonTokenizer::TokenType JsonTokenizer::scanString( TokenType type )
+{
+    index++;   // skip the openning quote
+    tokenIndex = index;
+    while ( ptr[index] != 0 && ptr[index] != '"' )
+    {
+        if ( ptr[index] == '\\' && ptr[index + 1] != 0 )
+        {
+            index++;
+        }
+        index++;
+    }
+
+    if ( ptr[index] != '"' )
+    {
+        return setError();
+    }
+    tokenLen = index - tokenIndex;
+    index++; // skip the closing quote
+    token = type;
+    return token;
+}
+
+JsonTokenizer::TokenType JsonTokenizer::scanLiteral( const char* literal, int len, TokenType type )
+{
+    if ( strncmp( ptr + index, literal, len ) != 0 )
+    {
+        return setError();
+    }
+    tokenIndex = index;
+    tokenLen = len;
+    index += len;
+    token = type;
+    return token;
+}
+
+bool FlatJson::parse(String data)
+{
+    delete[] nodes;
+    nodes = NULL;
+    nodeCount = 0;
+    nodeCapacity = 0;
+
+    source = data;
+    if ( source.length() > 0xFFFF )
+    {
+        LOG_JSON(HUE_LOG_WARN, "Document of %u bytes is too large", source.length());
+        return false;
+    }
+
+    // first pass only counts the values so the arena is allocated exactly once,
+    // the tokenizer lets a key without a value through ({"a":}) but the second
+    // pass would store a node for it, so that is a syntax error here
+    int count = 0;
+    bool value = false;     // the token before was a key
+    JsonTokenizer counter( source.c_str() );
+    JsonTokenizer::TokenType type;
+    while ( ( type = counter.next() ) != JsonTokenizer::END )
+    {
+        if ( type == JsonTokenizer::ERROR || ( value && ( type == JsonTokenizer::KEY || type == JsonTokenizer::OBJECT_END || type == JsonTokenizer::ARRAY_END ) ) )
+        {
+            LOG_JSON(HUE_LOG_WARN, "Syntax error at offset %d", (int)(counter.tokenStart() - source.c_str()));
+            return false;
+        }
+        value = type == JsonTokenizer::KEY;
+        if ( type != JsonTokenizer::KEY && type != JsonTokenizer::OBJECT_END && type != JsonTokenizer::ARRAY_END )
+        {
+            count++;
+        }
+    }
+    if ( value )
+    {
+        return false;
+    }
+
+    if ( count == 0 )
+    {
+        return false;
+    }
+
+    nodes = new json_node_t[count];
+    nodeCapacity = count;
+    JsonTokenizer json( source.c_str() );
+    json.next();
+    parseValue( &json, &nodeCount );
+    return true;
+}
+
+// builds the node for the value of the current token, returns its index, -1
+// when the arena is full, which the counting pass is there to prevent
+int FlatJson::parseValue( JsonTokenizer* json, int* count )
+{
+    if ( *count >= nodeCapacity )
+    {
+        return -1;
+    }
+    int index = (*count)++;
+    json_node_t* node = &nodes[index];
+    memset( node, 0, sizeof(json_node_t) );
+
+    const char* base = source.c_str();
+    int prev = -1;
+
+    switch ( json->type() )
+    {
+        case JsonTokenizer::OBJECT_START:
+            node->type = JsonValue::OBJECT;
+            while ( json->next() == JsonTokenizer::KEY )
+            {
+                uint16_t keyStart = json->tokenStart() - base;
+                uint8_t keyLength = json->tokenLength() > 0xFF ? 0xFF : json->tokenLength();
+                json->next();
+                int child = parseValue( json, count );
+                if ( child < 0 )
+                {
+                    break;
+                }
+                nodes[child].keyStart = keyStart;
+                nodes[child].keyLength = keyLength;
+                if ( prev >= 0 )
+                {
+                    nodes[prev].next = child;
+                }
+                prev = child;
+                node->length++;
+            }
+            break;
+        case JsonTokenizer::ARRAY_START:
+            node->type = JsonValue::ARRAY;
+            while ( json->next() != JsonTokenizer::ARRAY_END && json->type() != JsonTokenizer::ERROR && json->type() != JsonTokenizer::END )
+            {
+                int child = parseValue( json, count );
+                if ( child < 0 )
+                {
+                    break;
+                }
+                if ( prev >= 0 )
+                {
+                    nodes[prev].next = child;
+                }
+                prev = child;
+                node->length++;
+            }
+            break;
+        case JsonTokenizer::STRING:
+        case JsonTokenizer::NUMBER:
+            node->start = json->tokenStart() - base;
+            node->length = json->tokenLength();
+            node->type = JsonValue::STRING;
+            if ( json->type() == JsonTokenizer::NUMBER )
+            {
+                node->type = JsonValue::NUMBER_INT;
+                for ( int i = 0; i < node->length; i++ )
+                {
+                    char c = base[node->start + i];
+                    if ( c == '.' || c == 'e' || c == 'E' )
+                    {
+                        node->type = JsonValue::NUMBER_FLOAT;
+                    }
+                }
+            }
+            break;
+        case JsonTokenizer::TRUE_TYPE:
+            node->type = JsonValue::TRUE_TYPE;
+            break;
+        case JsonTokenizer::FALSE_TYPE:
+            node->type = JsonValue::FALSE_TYPE;
+            break;
+        case JsonTokenizer::NULL_TYPE:
+            node->type = JsonValue::NULL_TYPE;
+            break;
+        default:
+            node->type = JsonValue::UNKNOWN;
+            break;
+    }
+    return index;
+}
+
+const json_node_t* FlatJsonValue::get()
+{
+    return node >= 0 ? &doc->nodes[node] : NULL;
+}
+
+int FlatJsonValue::find(const char* name)
+{
+    const json_node_t* n = get();
+    if ( n == NULL || n->type != JsonValue::OBJECT || n->length == 0 )
+    {
+        return -1;
+    }
+
+    size_t len = strlen( name );
+    const char* base = doc->source.c_str();
+    int child = node + 1;
+    for ( int i = 0; i < n->length; i++ )
+    {
+        const json_node_t* c = &doc->nodes[child];
+        if ( c->keyLength == len && strncmp( base + c->keyStart, name, len ) == 0 )
+        {
+            return child;
+        }
+        child = c->next;
+    }
+    return -1;
+}
+
+FlatJsonValue FlatJsonValue::operator[](int index)
+{
+    const json_node_t* n = get();
+    if ( n == NULL || ( n->type != JsonValue::ARRAY && n->type != JsonValue::OBJECT ) || index < 0 || index >= n->length )
+    {
+        return FlatJsonValue( doc, -1 );
+    }
+
+    int child = node + 1;
+    while ( index-- > 0 )
+    {
+        child = doc->nodes[child].next;
+    }
+    return FlatJsonValue( doc, child );
+}
+
+int FlatJsonValue::getInt()
+{
+    const json_node_t* n = get();
+    if ( n == NULL || ( n->type != JsonValue::NUMBER_INT && n->type != JsonValue::NUMBER_FLOAT ) )
+    {
+        return 0;
+    }
+    int iValue;
+    float fValue;
+    bool isFloat;
+    parseNumber( doc->source.c_str() + n->start, &iValue, &fValue, &isFloat );
+    return iValue;
+}
+
+float FlatJsonValue::getFloat()
+{
+    const json_node_t* n = get();
+    if ( n == NULL || ( n->type != JsonValue::NUMBER_INT && n->type != JsonValue::NUMBER_FLOAT ) )
+    {
+        return 0;
+    }
+    int iValue;
+    float fValue;
+    bool isFloat;
+    parseNumber( doc->source.c_str() + n->start, &iValue, &fValue, &isFloat );
+    return fValue;
+}
+
+bool FlatJsonValue::getBool()
+{
+    const json_node_t* n = get();
+    return n != NULL && n->type == JsonValue::TRUE_TYPE;
+}
+
+bool FlatJsonValue::isNull()
+{
+    const json_node_t* n = get();
+    return n != NULL && n->type == JsonValue::NULL_TYPE;
+}
+
+String FlatJsonValue::getString()
+{
+    const json_node_t* n = get();
+    if ( n == NULL || n->type != JsonValue::STRING )
+    {
+        return String();
+    }
+    return decodeString( doc->source.c_str() + n->start, n->length );
+}
+
+int FlatJsonValue::size()
+{
+    const json_node_t* n = get();
+    return n != NULL && ( n->type == JsonValue::ARRAY || n->type == JsonValue::OBJECT ) ? n->length : 0;
+}
@@ -3,6 +3,16 @@
 #include "WString.h"
 #include <map>
 #include <vector>
+#include <stdint.h>
+
+// a float as an int, clamped to the range of int, 0 for NaN
+static inline int jsonFloatToInt(float value)
+{
+    return value >= 2147483648.0f ? INT32_MAX : value <= -2147483648.0f ? INT32_MIN : value == value ? (int)value : 0;
+}
+
+// appends text to json escaped as the contents of a json string, without the quotes
+void jsonAppendString(String& json, const char* text);
 
 class JsonValue
 {
@@ -21,8 +31,8 @@ class JsonValue
         void setValue(std::vector<JsonValue> val){ arrayValue = val; type = ARRAY; }
 
         bool hasPropery( String name){ return type == OBJECT ? oValue.count(name) : false; }
-        int getInt() { return iValue; }
-        float getFloat() { return fValue; }
+        int getInt() { return type == NUMBER_FLOAT ? jsonFloatToInt(fValue) : iValue; }
+        float getFloat() { return type == NUMBER_INT ? (float)iValue : fValue; }
         bool getBool() { return type == TRUE_TYPE ? true : false; }
         bool isNull() { return type == NULL_TYPE; }
         String getString() { return strValue; }
@@ -66,7 +76,7 @@ class SimpleJson
         std::map<String, JsonValue> getObject( int* index, const char* ptr );
         JsonValue getValue( int* index, const char* ptr );
         String getString( int* index, const char* ptr );
-        int getNumber( int* index, const char* ptr );
+        JsonValue getNumber( int* index, const char* ptr );
         void skipWhitespace( int* index, const char* ptr );
 
         bool isArray( int* index, const char* ptr );
@@ -77,4 +87,151 @@ class SimpleJson
         bool isFalse( int* index, const char* ptr );
         bool isNull( int* index, const char* ptr );
         bool isNumber( int* index, const char* ptr );
-};
\ No newline at end of file
+};
+
+/*
+    Pull style tokenizer that walks the json text once without building a tree
+    and without allocating. Each call to next() returns the next event, the
+    text of keys, strings and numbers is left in the source buffer and can be
+    inspected with keyEquals(), getInt(), getFloat() and getBool().
+
+    JsonTokenizer json(body.c_str());
+    json.next();    // OBJECT_START
+    while ( json.next() == JsonTokenizer::KEY )
+    {
+        if ( json.keyEquals("bri") && json.next() == JsonTokenizer::NUMBER )
+            bri = json.getInt();
+        else
+            json.skipValue();
+    }
+*/
+class JsonTokenizer
+{
+    public:
+        JsonTokenizer(const char* data){ ptr = data; }
+
+        typedef enum {
+            END,
+            ERROR,
+            OBJECT_START,
+            OBJECT_END,
+            ARRAY_START,
+            ARRAY_END,
+            KEY,
+            STRING,
+            NUMBER,
+            TRUE_TYPE,
+            FALSE_TYPE,
+            NULL_TYPE,
+        } TokenType;
+
+        TokenType next();
+        bool skipValue();
+
+        // text of the current KEY, STRING or NUMBER token, strings are still escaped
+        const char* tokenStart(){ return ptr + tokenIndex; }
+        int tokenLength(){ return tokenLen; }
+        int depth(){ return level; }
+        TokenType type(){ return token; }
+
+        bool keyEquals(const char* name);
+        int getInt();
+        float getFloat();
+        // the number times 10^decimals, rounded, without going through a float
+        int32_t getFixed( int decimals );
+        bool getBool(){ return token == TRUE_TYPE; }
+
+    private:
+        const char* ptr;
+        int index = 0;
+        int tokenIndex = 0;
+        int tokenLen = 0;
+        TokenType token = END;
+
+        // one bit per nesting level, set when the level is an object
+        uint32_t objectLevels = 0;
+        int level = 0;
+        bool expectKey = false;
+
+        TokenType scanString( TokenType type );
+        TokenType scanLiteral( const char* literal, int len, TokenType type );
+        TokenType setError(){ token = ERROR; return token; }
+        bool inObject(){ return level > 0 && ( objectLevels & (1UL << (level - 1)) ); }
+};
+
+
+/*
+    Flat alternative to SimpleJson. All the values of a parse are stored as
+    fixed size nodes in one array that is allocated once, sized by a counting
+    pass of the JsonTokenizer, and released in one shot when the FlatJson goes
+    out of scope. Keys, strings and numbers are not copied, a node only keeps
+    the offset and length of its text in the parsed body.
+
+    Each node is 10 bytes, so {"on":true,"bri":183} costs one copy of the
+    body plus 3 nodes, compared to a JsonValue with its own String, map and
+    vector for every value in the SimpleJson tree.
+
+    FlatJson json;
+    json.parse(body);
+    unsigned char bri = json.hasPropery("bri") ? json["bri"].getInt() : 0;
+*/
+typedef struct {
+    uint8_t type;         // JsonValue::ValueType
+    uint8_t keyLength;    // key of the node when its parent is an object
+    uint16_t keyStart;
+    uint16_t start;       // text of strings and numbers
+    uint16_t length;      // text length, or number of children for objects and arrays
+    uint16_t next;        // index of the next sibling, 0 for the last child
+} json_node_t;
+
+class FlatJson;
+
+class FlatJsonValue
+{
+    public:
+        FlatJsonValue(const FlatJson* doc, int node){ this->doc = doc; this->node = node; }
+
+        bool hasPropery(const char* name){ return find(name) >= 0; }
+        int getInt();
+        float getFloat();
+        bool getBool();
+        bool isNull();
+        String getString();
+        int size();
+        FlatJsonValue operator[](const char* name){ return FlatJsonValue(doc, find(name)); }
+        FlatJsonValue operator[](int index);
+
+    private:
+        const FlatJson* doc;
+        int node;   // -1 when the value does not exist
+
+        const json_node_t* get();
+        int find(const char* name);
+};
+
+class FlatJson
+{
+    public:
+        FlatJson(){}
+        ~FlatJson(){ delete[] nodes; }
+
+        bool parse(String data);
+        bool hasPropery(const char* name){ return root().hasPropery(name); }
+        FlatJsonValue operator[](const char* name){ return root()[name]; }
+        FlatJsonValue operator[](int index){ return root()[index]; }
+        FlatJsonValue root(){ return FlatJsonValue(this, nodeCount > 0 ? 0 : -1); }
+
+    private:
+        // the arena owns raw memory, it is neither copied nor moved
+        FlatJson(const FlatJson&);
+        FlatJson& operator=(const FlatJson&);
+
+        String source;
+        json_node_t* nodes = NULL;
+        int nodeCount = 0;
+        int nodeCapacity = 0;
+
+        int parseValue( JsonTokenizer* json, int* count );
+
+        friend class FlatJsonValue;
+};
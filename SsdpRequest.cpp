@@ -0,0 +1,172 @@
+#include "SsdpRequest.h"
+#include <string.h>
+#include <strings.h>
+
+#define SSDP_UUID_PREFIX    "uuid:2f402f80-da50-11e1-9b23-"
+#define SSDP_MAX_MX         120
+
+static bool isSpace(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+bool SsdpRequest::equals(const char * text, size_t length, const char * literal)
+{
+    return strlen(literal) == length && strncasecmp(text, literal, length) == 0;
+}
+
+/*
+    Sample message received from Amazon Echo
+
+    M-SEARCH * HTTP/1.1
+    HOST: 239.255.255.250:1900
+    ST: ssdp:all
+    MAN: "ssdp:discover"
+    MX: 3
+
+*/
+bool SsdpRequest::parse(const char * data, size_t length)
+{
+    _method = UNKNOWN;
+    _discover = false;
+    _mx = -1;
+    _st = NULL;
+    _stLength = 0;
+
+    const char * end = data + length;
+    const char * line = data;
+    bool requestLine = true;
+    while (line < end)
+    {
+        const char * lineEnd = (const char *)memchr(line, '\n', end - line);
+        const char * next = lineEnd != NULL ? lineEnd + 1 : end;
+        if (lineEnd == NULL)
+        {
+            lineEnd = end;
+        }
+        if (lineEnd > line && lineEnd[-1] == '\r')
+        {
+            lineEnd--;
+        }
+
+        if (requestLine)
+        {
+            // METHOD SP * SP HTTP/1.1
+            const char * methodEnd = (const char *)memchr(line, ' ', lineEnd - line);
+            if (methodEnd == NULL || lineEnd - methodEnd < 3 || methodEnd[1] != '*' || methodEnd[2] != ' ')
+            {
+                return false;
+            }
+            if (equals(line, methodEnd - line, "M-SEARCH"))
+            {
+                _method = M_SEARCH;
+            }
+            else if (equals(line, methodEnd - line, "NOTIFY"))
+            {
+                _method = NOTIFY;
+            }
+            requestLine = false;
+        }
+        else if (lineEnd == line)
+        {
+            break;      // end of the headers
+        }
+        else
+        {
+            const char * colon = (const char *)memchr(line, ':', lineEnd - line);
+            if (colon != NULL)
+            {
+                const char * nameEnd = colon;
+                while (nameEnd > line && isSpace(nameEnd[-1]))
+                {
+                    nameEnd--;
+                }
+                const char * value = colon + 1;
+                const char * valueEnd = lineEnd;
+                while (value < valueEnd && isSpace(*value))
+                {
+                    value++;
+                }
+                while (valueEnd > value && isSpace(valueEnd[-1]))
+                {
+                    valueEnd--;
+                }
+                parseHeader(line, nameEnd - line, value, valueEnd - value);
+            }
+        }
+        line = next;
+    }
+    return !requestLine;
+}
+
+void SsdpRequest::parseHeader(const char * name, size_t nameLength, const char * value, size_t valueLength)
+{
+    if (equals(name, nameLength, "ST"))
+    {
+        _st = value;
+        _stLength = valueLength;
+    }
+    else if (equals(name, nameLength, "MAN"))
+    {
+        // the value is quoted, but be lenient with senders that leave the quotes out
+        if (valueLength >= 2 && value[0] == '"' && value[valueLength - 1] == '"')
+        {
+            value++;
+            valueLength -= 2;
+        }
+        _discover = equals(value, valueLength, "ssdp:discover");
+    }
+    else if (equals(name, nameLength, "MX"))
+    {
+        int mx = 0;
+        size_t i = 0;
+        while (i < valueLength && value[i] >= '0' && value[i] <= '9')
+        {
+            mx = mx < SSDP_MAX_MX ? mx * 10 + (value[i] - '0') : mx;
+            i++;
+        }
+        _mx = (i > 0 && i == valueLength) ? (mx < SSDP_MAX_MX ? mx : SSDP_MAX_MX) : -1;
+    }
+}
+
+SsdpRequest::Target SsdpRequest::target(const char * bridgeId) const
+{
+    if (_st == NULL)
+    {
+        return TARGET_NONE;
+    }
+    if (equals(_st, _stLength, "ssdp:all"))
+    {
+        return TARGET_ALL;
+    }
+    if (equals(_st, _stLength, "upnp:rootdevice"))
+    {
+        return TARGET_ROOT_DEVICE;
+    }
+    if (equals(_st, _stLength, "urn:schemas-upnp-org:device:basic:1"))
+    {
+        return TARGET_BASIC_DEVICE;
+    }
+
+    size_t prefixLength = strlen(SSDP_UUID_PREFIX);
+    size_t idLength = strlen(bridgeId);
+    if (_stLength == prefixLength + idLength
+        && strncasecmp(_st, SSDP_UUID_PREFIX, prefixLength) == 0
+        && strncasecmp(_st + prefixLength, bridgeId, idLength) == 0)
+    {
+        return TARGET_UUID;
+    }
+    return TARGET_NONE;
+}
+
+uint8_t SsdpRequest::replies(Target target)
+{
+    switch (target)
+    {
+        case TARGET_ALL:            return SSDP_REPLY_ROOT_DEVICE | SSDP_REPLY_UUID | SSDP_REPLY_BASIC_DEVICE;
+        case TARGET_ROOT_DEVICE:    return SSDP_REPLY_ROOT_DEVICE;
+        case TARGET_UUID:           return SSDP_REPLY_UUID;
+        case TARGET_BASIC_DEVICE:   return SSDP_REPLY_BASIC_DEVICE;
+        default:                    return 0;
+    }
+}
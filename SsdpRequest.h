@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+    Parser for the SSDP requests that reach the bridge. It works on the
+    received datagram in place: nothing is copied and nothing is allocated,
+    the header values it keeps are pointers into the packet. Header names and
+    the method are matched case-insensitively, lines may end in CRLF or LF.
+
+    It depends on nothing but the C library so it can be fed a packet corpus
+    or a fuzzer on Linux (see host/ssdpbench.cpp).
+
+    SsdpRequest request;
+    if (request.parse(data, len) && request.isSearch() && request.target(bridgeId) != SsdpRequest::TARGET_NONE)
+        reply after a random delay up to request.mx() seconds
+*/
+// replies to a search, bit n is the reply of NOTIFY type n in UPnP.cpp
+#define SSDP_REPLY_ROOT_DEVICE      0x01    // ST: upnp:rootdevice
+#define SSDP_REPLY_UUID             0x02    // ST: uuid:2f402f80-da50-11e1-9b23-<bridge id>
+#define SSDP_REPLY_BASIC_DEVICE     0x04    // ST: urn:schemas-upnp-org:device:basic:1
+
+class SsdpRequest
+{
+    public:
+        typedef enum {
+            UNKNOWN,
+            M_SEARCH,
+            NOTIFY,
+        } Method;
+
+        // search targets the bridge answers for
+        typedef enum {
+            TARGET_NONE,
+            TARGET_ALL,             // ssdp:all
+            TARGET_ROOT_DEVICE,     // upnp:rootdevice
+            TARGET_BASIC_DEVICE,    // urn:schemas-upnp-org:device:basic:1
+            TARGET_UUID,            // uuid:2f402f80-da50-11e1-9b23-<bridge id>
+        } Target;
+
+        // false when the packet is not an SSDP request at all
+        bool parse(const char * data, size_t length);
+
+        Method method() const { return _method; }
+        // M-SEARCH * with MAN: "ssdp:discover"
+        bool isSearch() const { return _method == M_SEARCH && _discover; }
+        // seconds, -1 when the request has no MX header (unicast search)
+        int mx() const { return _mx; }
+        const char * st() const { return _st; }
+        size_t stLength() const { return _stLength; }
+
+        // which of the targets the ST header asks for, bridgeId is the 12 hex digit MAC
+        Target target(const char * bridgeId) const;
+
+        // replies a search for target gets, SSDP_REPLY_* bits. ssdp:all gets
+        // one for each type the bridge is, as UPnP 1.0 asks
+        static uint8_t replies(Target target);
+
+    private:
+        Method _method = UNKNOWN;
+        bool _discover = false;
+        int _mx = -1;
+        const char * _st = NULL;
+        size_t _stLength = 0;
+
+        void parseHeader(const char * name, size_t nameLength, const char * value, size_t valueLength);
+        static bool equals(const char * text, size_t length, const char * literal);
+};
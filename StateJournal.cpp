@@ -0,0 +1,621 @@
+#include "StateJournal.h"
+#include <string.h>
+#include <stddef.h>
+
+#if !defined(ARDUINO_ARCH_ESP32)
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/stat.h>
+#endif
+
+#define HUE_JOURNAL_READ_RECORDS    32      // records read per call during replay
+
+static_assert(sizeof(journal_record_t) == 20, "journal records are 20 bytes");
+static_assert(sizeof(journal_header_t) == sizeof(journal_record_t), "the header takes the place of one record");
+static_assert(sizeof(journal_names_t) + HUE_MAX_DEVICES < HUE_JOURNAL_SEGMENT_SIZE, "the generations fit into a segment");
+
+StateJournal::~StateJournal()
+{
+#if !defined(ARDUINO_ARCH_ESP32)
+    if (_fd >= 0)
+    {
+        close(_fd);
+    }
+#endif
+}
+
+bool StateJournal::begin(const char * location)
+{
+    unsigned long start = micros();
+    if (!openStorage(location))
+    {
+        LOG_JOURNAL(HUE_LOG_WARN, "No storage at '%s', light state is not kept", location);
+        return false;
+    }
+    _open = true;
+    readNames();
+    replay();
+    HUE_METRIC(hueMetrics.journalRestoreUs = micros() - start);
+    LOG_JOURNAL(HUE_LOG_INFO, "%d lights restored from segment %d (generation %u) in %lu us",
+        _entryCount, (int)_segment, (unsigned int)_generation, micros() - start);
+    return true;
+}
+
+bool StateJournal::restore(unsigned char id, const char * name, device_t * device)
+{
+    if (!_open)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(_lock);
+    if (!(_names[id] == name))
+    {
+        _names[id] = name;
+        _namesDirty = true;
+    }
+
+    int i = find(device->nameHash);
+    bool found = i >= 0;
+    if (!found)
+    {
+        i = slot(device->nameHash);
+        if (i < 0)
+        {
+            return false;
+        }
+        // nothing to write until the light changes
+        journal_record_t& record = _entries[i].latest;
+        record.hue = device->hue;
+        record.ct = device->ct;
+        record.x = device->x;
+        record.y = device->y;
+        record.bri = device->bri;
+        record.sat = device->sat;
+        record.state = device->state;
+        record.mode = device->mode;
+        _entries[i].written = record;
+    }
+
+    entry_t& entry = _entries[i];
+    entry.bound = true;
+    entry.latest.id = id;
+    if (found)
+    {
+        device->hue = entry.latest.hue;
+        device->ct = entry.latest.ct;
+        device->x = entry.latest.x;
+        device->y = entry.latest.y;
+        device->bri = entry.latest.bri;
+        device->sat = entry.latest.sat;
+        device->state = entry.latest.state;
+        device->mode = entry.latest.mode;
+    }
+    return found;
+}
+
+void StateJournal::forget(unsigned char id, uint32_t nameHash, uint8_t generation)
+{
+    if (!_open)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_lock);
+    _names[id] = "";
+    _slotGenerations[id] = generation;
+    _namesDirty = true;
+
+    int i = find(nameHash);
+    if (i >= 0)
+    {
+        _entries[i].bound = false;
+    }
+}
+
+void StateJournal::record(unsigned char id, const device_t & device)
+{
+    if (!_open)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_lock);
+    int i = find(device.nameHash);
+    if (i < 0 || !_entries[i].bound)
+    {
+        return;
+    }
+
+    journal_record_t& record = _entries[i].latest;
+    record.id = id;
+    record.hue = device.hue;
+    record.ct = device.ct;
+    record.x = device.x;
+    record.y = device.y;
+    record.bri = device.bri;
+    record.sat = device.sat;
+    record.state = device.state;
+    record.mode = device.mode;
+
+    unsigned long now = millis();
+    if (_dirty == 0)
+    {
+        _firstChange = now;
+    }
+    _lastChange = now;
+    _dirty |= 1ULL << i;
+    HUE_METRIC(hueMetrics.journalChanges++);
+}
+
+/*
+    Takes the due records under the lock and writes them after, so a
+    setState on another task never waits on the flash. Only this function
+    touches the storage. Lights are rarely added or removed, the names are
+    written on the first flush after that without waiting.
+*/
+void StateJournal::flush(bool force)
+{
+    if (!_open)
+    {
+        return;
+    }
+
+    std::vector<uint8_t> names;
+    journal_record_t records[HUE_MAX_DEVICES];
+    size_t count = 0;
+    bool compacting = false;
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        if (_dirty == 0 && !_compactPending && !_namesDirty)
+        {
+            return;
+        }
+        if (_namesDirty)
+        {
+            packNames(&names);
+            _namesDirty = false;
+        }
+        unsigned long now = millis();
+        bool due = (_dirty != 0 || _compactPending)
+            && (force || _compactPending || now - _lastChange >= HUE_JOURNAL_DEBOUNCE || now - _firstChange >= HUE_JOURNAL_MAX_DELAY);
+        if (due)
+        {
+            for (unsigned char i = 0; i < _entryCount; i++)
+            {
+                entry_t& entry = _entries[i];
+                if ((_dirty & (1ULL << i)) && memcmp(&entry.written, &entry.latest, offsetof(journal_record_t, type)) != 0)
+                {
+                    records[count++] = entry.latest;
+                    entry.written = entry.latest;
+                }
+            }
+            _dirty = 0;
+
+            compacting = _compactPending || _position + count * sizeof(journal_record_t) > HUE_JOURNAL_SEGMENT_SIZE;
+            if (compacting)
+            {
+                count = 0;
+                for (unsigned char i = 0; i < _entryCount; i++)
+                {
+                    records[count++] = _entries[i].latest;
+                    _entries[i].written = _entries[i].latest;
+                }
+                _compactPending = false;
+            }
+        }
+    }
+
+    if (!names.empty() && !writeNames(names))
+    {
+        LOG_JOURNAL(HUE_LOG_ERROR, "Writing the names failed");
+    }
+    if (count == 0 && !compacting)
+    {
+        return;
+    }
+    if (!(compacting ? compact(records, count) : append(records, count)))
+    {
+        LOG_JOURNAL(HUE_LOG_ERROR, "Writing %d records failed", (int)count);
+    }
+}
+
+int StateJournal::find(uint32_t nameHash) const
+{
+    for (unsigned char i = 0; i < _entryCount; i++)
+    {
+        if (_entries[i].latest.nameHash == nameHash)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// entry for a name that is not in the journal yet, replaces the state of a
+// light that was not added since startup when all entries are taken
+int StateJournal::slot(uint32_t nameHash)
+{
+    int i = -1;
+    if (_entryCount < HUE_MAX_DEVICES)
+    {
+        i = _entryCount++;
+    }
+    else
+    {
+        for (unsigned char n = 0; n < _entryCount && i < 0; n++)
+        {
+            if (!_entries[n].bound)
+            {
+                i = n;
+            }
+        }
+        if (i < 0)
+        {
+            return -1;
+        }
+    }
+
+    memset(&_entries[i], 0, sizeof(entry_t));
+    _entries[i].latest.nameHash = nameHash;
+    _entries[i].latest.type = HUE_JOURNAL_STATE;
+    _entries[i].written = _entries[i].latest;
+    _dirty &= ~(1ULL << i);
+    return i;
+}
+
+/*
+    Finds the live segment, the valid header with the highest generation, and
+    applies its records in order until the erased space after the last one.
+    A record with a bad CRC is the remains of a write that was cut off and is
+    skipped. Without a live segment the storage is formatted.
+*/
+void StateJournal::replay()
+{
+    bool found = false;
+    for (size_t s = HUE_JOURNAL_NAME_SEGMENTS; s < _segmentCount; s++)
+    {
+        journal_header_t header;
+        if (!readStorage(s * HUE_JOURNAL_SEGMENT_SIZE, &header, sizeof(header)))
+        {
+            continue;
+        }
+        if (header.magic == HUE_JOURNAL_MAGIC && header.check == ~(header.magic ^ header.generation)
+            && header.recordSize == sizeof(journal_record_t) && (!found || header.generation > _generation))
+        {
+            found = true;
+            _segment = s;
+            _generation = header.generation;
+        }
+    }
+    if (!found)
+    {
+        LOG_JOURNAL(HUE_LOG_INFO, "Formatting %d segments", (int)(_segmentCount - HUE_JOURNAL_NAME_SEGMENTS));
+        _segment = _segmentCount - 1;
+        _generation = 0;
+        compact(NULL, 0);
+        return;
+    }
+
+    journal_record_t records[HUE_JOURNAL_READ_RECORDS];
+    size_t base = _segment * HUE_JOURNAL_SEGMENT_SIZE;
+    _position = HUE_JOURNAL_SEGMENT_SIZE;
+    int corrupt = 0;
+    for (size_t offset = sizeof(journal_header_t); offset < HUE_JOURNAL_SEGMENT_SIZE && _position == HUE_JOURNAL_SEGMENT_SIZE; offset += sizeof(records))
+    {
+        size_t count = (HUE_JOURNAL_SEGMENT_SIZE - offset) / sizeof(journal_record_t);
+        count = count < HUE_JOURNAL_READ_RECORDS ? count : HUE_JOURNAL_READ_RECORDS;
+        if (!readStorage(base + offset, records, count * sizeof(journal_record_t)))
+        {
+            break;
+        }
+        for (size_t r = 0; r < count; r++)
+        {
+            const uint8_t * bytes = (const uint8_t *)&records[r];
+            size_t erased = 0;
+            while (erased < sizeof(journal_record_t) && bytes[erased] == 0xFF)
+            {
+                erased++;
+            }
+            if (erased == sizeof(journal_record_t))
+            {
+                _position = offset + r * sizeof(journal_record_t);
+                break;
+            }
+            if (!valid(records[r]))
+            {
+                corrupt++;
+                continue;
+            }
+            int i = find(records[r].nameHash);
+            i = i >= 0 ? i : slot(records[r].nameHash);
+            if (i >= 0)
+            {
+                _entries[i].latest = records[r];
+                _entries[i].written = records[r];
+            }
+            HUE_METRIC(hueMetrics.journalReplayed++);
+        }
+    }
+    if (corrupt > 0)
+    {
+        LOG_JOURNAL(HUE_LOG_WARN, "%d damaged records skipped", corrupt);
+    }
+    _compactPending = _position > HUE_JOURNAL_SEGMENT_SIZE / 2;
+}
+
+/*
+    Takes the copy of the names with the highest generation whose bytes are
+    intact. Without one every slot starts at generation 0 and no light is
+    added again.
+*/
+void StateJournal::readNames()
+{
+    std::vector<uint8_t> names;
+    bool found = false;
+    for (size_t s = 0; s < HUE_JOURNAL_NAME_SEGMENTS; s++)
+    {
+        journal_names_t header;
+        if (!readStorage(s * HUE_JOURNAL_SEGMENT_SIZE, &header, sizeof(header)) || header.magic != HUE_JOURNAL_NAMES_MAGIC
+            || header.length < HUE_MAX_DEVICES || header.length > HUE_JOURNAL_SEGMENT_SIZE - sizeof(header)
+            || (found && header.generation <= _nameGeneration))
+        {
+            continue;
+        }
+        std::vector<uint8_t> bytes(header.length);
+        if (!readStorage(s * HUE_JOURNAL_SEGMENT_SIZE + sizeof(header), bytes.data(), bytes.size())
+            || crc16(bytes.data(), bytes.size()) != header.check)
+        {
+            continue;
+        }
+        found = true;
+        _nameSegment = s;
+        _nameGeneration = header.generation;
+        names.swap(bytes);
+    }
+    if (!found)
+    {
+        return;
+    }
+
+    memcpy(_slotGenerations, names.data(), HUE_MAX_DEVICES);
+    size_t offset = HUE_MAX_DEVICES;
+    while (offset + 2 <= names.size())
+    {
+        uint8_t id = names[offset];
+        uint8_t length = names[offset + 1];
+        offset += 2;
+        if (id >= HUE_MAX_DEVICES || offset + length > names.size())
+        {
+            break;
+        }
+        _names[id] = String((const char *)&names[offset], length);
+        offset += length;
+    }
+}
+
+// the generation of every slot, then id, length and name of every light
+void StateJournal::packNames(std::vector<uint8_t> * names)
+{
+    names->assign(_slotGenerations, _slotGenerations + HUE_MAX_DEVICES);
+    for (unsigned char id = 0; id < HUE_MAX_DEVICES; id++)
+    {
+        size_t length = _names[id].length();
+        if (length == 0)
+        {
+            continue;
+        }
+        if (sizeof(journal_names_t) + names->size() + 2 + length > HUE_JOURNAL_SEGMENT_SIZE)
+        {
+            LOG_JOURNAL(HUE_LOG_WARN, "No room for the name of light #%d, it is not added again after a restart", id);
+            continue;
+        }
+        names->push_back(id);
+        names->push_back(length);
+        names->insert(names->end(), _names[id].c_str(), _names[id].c_str() + length);
+    }
+}
+
+// writes the names to the other copy, its header last like a compaction
+bool StateJournal::writeNames(const std::vector<uint8_t> & names)
+{
+    size_t next = (_nameSegment + 1) % HUE_JOURNAL_NAME_SEGMENTS;
+    if (!eraseSegment(next))
+    {
+        return false;
+    }
+
+    journal_names_t header;
+    header.magic = HUE_JOURNAL_NAMES_MAGIC;
+    header.generation = _nameGeneration + 1;
+    header.length = names.size();
+    header.check = crc16(names.data(), names.size());
+    size_t base = next * HUE_JOURNAL_SEGMENT_SIZE;
+    if (!writeStorage(base + sizeof(header), names.data(), names.size())
+        || !writeStorage(base, &header, sizeof(header)))
+    {
+        return false;
+    }
+
+    _nameSegment = next;
+    _nameGeneration = header.generation;
+    LOG_JOURNAL(HUE_LOG_DEBUG, "Names written to segment %d", (int)next);
+    return true;
+}
+
+bool StateJournal::append(const journal_record_t * records, size_t count)
+{
+    journal_record_t sealed[HUE_MAX_DEVICES];
+    for (size_t i = 0; i < count; i++)
+    {
+        sealed[i] = records[i];
+        seal(&sealed[i]);
+    }
+    if (!writeStorage(_segment * HUE_JOURNAL_SEGMENT_SIZE + _position, sealed, count * sizeof(journal_record_t)))
+    {
+        return false;
+    }
+    _position += count * sizeof(journal_record_t);
+    HUE_METRIC(hueMetrics.journalRecords += count);
+    return true;
+}
+
+/*
+    Writes the state of every light to the next segment of the ring. The
+    header goes in last, so a compaction that is cut off leaves the previous
+    segment live.
+*/
+bool StateJournal::compact(const journal_record_t * records, size_t count)
+{
+    size_t next = _segment + 1 < _segmentCount ? _segment + 1 : HUE_JOURNAL_NAME_SEGMENTS;
+    if (!eraseSegment(next))
+    {
+        return false;
+    }
+
+    journal_record_t sealed[HUE_MAX_DEVICES];
+    for (size_t i = 0; i < count; i++)
+    {
+        sealed[i] = records[i];
+        seal(&sealed[i]);
+    }
+    size_t base = next * HUE_JOURNAL_SEGMENT_SIZE;
+    if (count > 0 && !writeStorage(base + sizeof(journal_header_t), sealed, count * sizeof(journal_record_t)))
+    {
+        return false;
+    }
+
+    journal_header_t header;
+    header.magic = HUE_JOURNAL_MAGIC;
+    header.generation = _generation + 1;
+    header.recordSize = sizeof(journal_record_t);
+    header.reserved = 0;
+    header.check = ~(header.magic ^ header.generation);
+    if (!writeStorage(base, &header, sizeof(header)))
+    {
+        return false;
+    }
+
+    _segment = next;
+    _generation = header.generation;
+    _position = sizeof(journal_header_t) + count * sizeof(journal_record_t);
+    HUE_METRIC(hueMetrics.journalRecords += count);
+    HUE_METRIC(hueMetrics.journalCompactions++);
+    LOG_JOURNAL(HUE_LOG_DEBUG, "Compacted %d lights into segment %d", (int)count, (int)next);
+    return true;
+}
+
+void StateJournal::seal(journal_record_t * record)
+{
+    record->type = HUE_JOURNAL_STATE;
+    record->check = crc16((const uint8_t *)record, offsetof(journal_record_t, check));
+}
+
+bool StateJournal::valid(const journal_record_t & record)
+{
+    return record.type == HUE_JOURNAL_STATE && record.check == crc16((const uint8_t *)&record, offsetof(journal_record_t, check));
+}
+
+// CRC-16/CCITT-FALSE
+uint16_t StateJournal::crc16(const uint8_t * data, size_t length)
+{
+    uint16_t crc = 0xFFFF;
+    while (length--)
+    {
+        crc ^= (uint16_t)*data++ << 8;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+bool StateJournal::openStorage(const char * location)
+{
+    _partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, location);
+    if (_partition == NULL)
+    {
+        return false;
+    }
+    _segmentCount = _partition->size / HUE_JOURNAL_SEGMENT_SIZE;
+    return _segmentCount >= HUE_JOURNAL_NAME_SEGMENTS + 2;
+}
+
+bool StateJournal::readStorage(size_t offset, void * data, size_t length)
+{
+    return esp_partition_read(_partition, offset, data, length) == ESP_OK;
+}
+
+bool StateJournal::writeStorage(size_t offset, const void * data, size_t length)
+{
+    HUE_METRIC(hueMetrics.journalBytes += length);
+    return esp_partition_write(_partition, offset, data, length) == ESP_OK;
+}
+
+bool StateJournal::eraseSegment(size_t segment)
+{
+    HUE_METRIC(hueMetrics.journalErases++);
+    return esp_partition_erase_range(_partition, segment * HUE_JOURNAL_SEGMENT_SIZE, HUE_JOURNAL_SEGMENT_SIZE) == ESP_OK;
+}
+
+#else
+
+// a file of HUE_JOURNAL_SEGMENTS segments that behaves like erased flash
+bool StateJournal::openStorage(const char * location)
+{
+    _fd = open(location, O_RDWR | O_CREAT, 0644);
+    if (_fd < 0)
+    {
+        return false;
+    }
+    _segmentCount = HUE_JOURNAL_SEGMENTS;
+
+    struct stat st;
+    if (fstat(_fd, &st) == 0 && st.st_size == (off_t)(_segmentCount * HUE_JOURNAL_SEGMENT_SIZE))
+    {
+        return true;
+    }
+    if (ftruncate(_fd, _segmentCount * HUE_JOURNAL_SEGMENT_SIZE) != 0)
+    {
+        return false;
+    }
+    for (size_t s = 0; s < _segmentCount; s++)
+    {
+        if (!eraseSegment(s))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool StateJournal::readStorage(size_t offset, void * data, size_t length)
+{
+    return pread(_fd, data, length, offset) == (ssize_t)length;
+}
+
+bool StateJournal::writeStorage(size_t offset, const void * data, size_t length)
+{
+    HUE_METRIC(hueMetrics.journalBytes += length);
+    return pwrite(_fd, data, length, offset) == (ssize_t)length && fdatasync(_fd) == 0;
+}
+
+bool StateJournal::eraseSegment(size_t segment)
+{
+    uint8_t erased[256];
+    memset(erased, 0xFF, sizeof(erased));
+    for (size_t offset = 0; offset < HUE_JOURNAL_SEGMENT_SIZE; offset += sizeof(erased))
+    {
+        if (pwrite(_fd, erased, sizeof(erased), segment * HUE_JOURNAL_SEGMENT_SIZE + offset) != (ssize_t)sizeof(erased))
+        {
+            return false;
+        }
+    }
+    HUE_METRIC(hueMetrics.journalErases++);
+    return true;
+}
+
+#endif
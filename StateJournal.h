@@ -0,0 +1,174 @@
+#pragma once
+
+#include <Arduino.h>
+#include <mutex>
+#include <vector>
+#include <stdint.h>
+#include "DeviceRegistry.h"
+#include "HueMetrics.h"
+#include "HueLog.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+    #include <esp_partition.h>
+#endif
+
+#ifndef HUE_LOG_LEVEL_JOURNAL
+    #define HUE_LOG_LEVEL_JOURNAL   HUE_LOG_LEVEL
+#endif
+#define LOG_JOURNAL(level, fmt, ...)    HUE_LOG(HUE_LOG_LEVEL_JOURNAL, level, "journal", fmt, ## __VA_ARGS__)
+
+// Where the journal lives: the label of a data partition on the ESP32 (see
+// partitions.csv), a file on Linux
+#if defined(ARDUINO_ARCH_ESP32)
+    #define HUE_JOURNAL_LOCATION    "huestate"
+#else
+    #define HUE_JOURNAL_LOCATION    "huebridge.journal"
+    #define HUE_JOURNAL_SEGMENTS    6       // size of the file in segments
+#endif
+#define HUE_JOURNAL_SEGMENT_SIZE    4096    // one flash sector, the unit that is erased
+#define HUE_JOURNAL_NAME_SEGMENTS   2       // the first segments hold the names, the ring of state follows
+
+// A changed light is written once it has been quiet for HUE_JOURNAL_DEBOUNCE
+// ms, or HUE_JOURNAL_MAX_DELAY ms after the first change of a long ramp
+#ifndef HUE_JOURNAL_DEBOUNCE
+    #define HUE_JOURNAL_DEBOUNCE    2000
+#endif
+#define HUE_JOURNAL_MAX_DELAY       10000
+
+#define HUE_JOURNAL_MAGIC           0x4A455548UL    // "HUEJ"
+#define HUE_JOURNAL_STATE           0x53            // type of a state record
+#define HUE_JOURNAL_NAMES_MAGIC     0x4E455548UL    // "HUEN"
+
+// state of one light as it is written to flash
+typedef struct {
+    uint32_t nameHash;      // the light is found by its name when it is added again
+    uint16_t hue;
+    int16_t ct;
+    uint16_t x;
+    uint16_t y;
+    uint8_t bri;
+    uint8_t sat;
+    uint8_t state;
+    char mode;
+    uint8_t type;           // HUE_JOURNAL_STATE, 0xFF in erased flash
+    uint8_t id;             // id of the light when it was written, informational
+    uint16_t check;         // CRC-16 of the bytes before, catches torn writes
+} journal_record_t;
+
+// start of every segment, written after the records of a compaction
+typedef struct {
+    uint32_t magic;
+    uint32_t generation;    // the segment with the highest generation is the live one
+    uint32_t recordSize;    // a journal written with other records is formatted again
+    uint32_t reserved;
+    uint32_t check;         // ~(magic ^ generation)
+} journal_header_t;
+
+// start of a copy of the name pool, followed by the generation of every
+// slot and then the id, length and name of every light
+typedef struct {
+    uint32_t magic;
+    uint32_t generation;    // the copy with the highest generation is the live one
+    uint16_t length;        // bytes after the header
+    uint16_t check;         // CRC-16 of the bytes after the header
+} journal_names_t;
+
+/*
+    Append-only journal of the light state, so that the lights come back as
+    they were after a power cut instead of off at full brightness.
+
+    Storage is a ring of segments of one flash sector each. New records are
+    appended to the live segment, nothing is written twice without an erase.
+    When the live segment is full the latest state of every light is written
+    to the next segment of the ring (a compaction) and that segment becomes
+    the live one, so erases rotate over the whole partition. Startup reads
+    the headers of the segments and replays the records of the live one,
+    which is at most one sector. A live segment that is more than half full
+    at startup is compacted on the first flush(), which keeps the next
+    replay short.
+
+    record() only updates the state kept in memory. flush(), called from the
+    loop of the bridge, writes the lights that changed once they have been
+    quiet for HUE_JOURNAL_DEBOUNCE ms, all of them in one write, so a
+    brightness ramp of a hundred PUTs is one record rather than a hundred.
+    A light that ends up where it was written last is not written again.
+
+    The names of the lights are kept apart from the state, in a pool that is
+    written whole to one of the first two segments, in turn, whenever a
+    light was added or removed. It holds the id each light had and the
+    generation of every slot, so the bridge adds the lights of the last run
+    again under the same uniqueid, also the ones added at runtime. State
+    records refer to their light by the hash of its name.
+*/
+class StateJournal
+{
+    public:
+        ~StateJournal();
+
+        // opens the storage and replays it, false when there is no storage
+        bool begin(const char * location = HUE_JOURNAL_LOCATION);
+        bool enabled() const { return _open; }
+
+        // name of the light that was in slot id in the last run, NULL when none
+        const char * name(unsigned char id) const { return _names[id].length() > 0 ? _names[id].c_str() : NULL; }
+        // lights removed from slot id so far, see DeviceRegistry::uniqueId
+        uint8_t generation(unsigned char id) const { return _slotGenerations[id]; }
+
+        // state the light had, binds the light to its entry and keeps its name
+        bool restore(unsigned char id, const char * name, device_t * device);
+        // the light was removed, its last state is kept should it come back
+        void forget(unsigned char id, uint32_t nameHash, uint8_t generation);
+        // called from any task when the state of a light changed
+        void record(unsigned char id, const device_t & device);
+        // writes what is due, or everything that changed with force
+        void flush(bool force = false);
+
+    private:
+        typedef struct {
+            journal_record_t written;   // state in flash
+            journal_record_t latest;    // state in memory
+            bool bound;                 // a light was added under this name since startup
+        } entry_t;
+
+        entry_t _entries[HUE_MAX_DEVICES];
+        unsigned char _entryCount = 0;
+        uint64_t _dirty = 0;            // entries with a change that is not written yet
+        unsigned long _firstChange = 0;
+        unsigned long _lastChange = 0;
+        std::mutex _lock;               // guards the entries, storage is only touched by flush()
+
+        String _names[HUE_MAX_DEVICES];         // name of the light in each slot, empty when free
+        uint8_t _slotGenerations[HUE_MAX_DEVICES] = {0};
+        bool _namesDirty = false;
+        size_t _nameSegment = 1;        // live copy of the names
+        uint32_t _nameGeneration = 0;
+
+        bool _open = false;
+        bool _compactPending = false;
+        size_t _segmentCount = 0;
+        size_t _segment = 0;            // live segment
+        size_t _position = 0;           // offset of the next record in the live segment
+        uint32_t _generation = 0;
+    #if defined(ARDUINO_ARCH_ESP32)
+        const esp_partition_t * _partition = NULL;
+    #else
+        int _fd = -1;
+    #endif
+
+        int find(uint32_t nameHash) const;
+        int slot(uint32_t nameHash);
+        void replay();
+        void readNames();
+        void packNames(std::vector<uint8_t> * names);
+        bool writeNames(const std::vector<uint8_t> & names);
+        bool append(const journal_record_t * records, size_t count);
+        bool compact(const journal_record_t * records, size_t count);
+        static void seal(journal_record_t * record);
+        static bool valid(const journal_record_t & record);
+        static uint16_t crc16(const uint8_t * data, size_t length);
+
+        bool openStorage(const char * location);
+        bool readStorage(size_t offset, void * data, size_t length);
+        bool writeStorage(size_t offset, const void * data, size_t length);
+        bool eraseSegment(size_t segment);
+};
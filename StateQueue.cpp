@@ -0,0 +1,122 @@
+#include "StateQueue.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+void StateQueue::task(void * queue)
+{
+    StateQueue * self = (StateQueue *)queue;
+    while (!self->_stopping)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        self->deliver();
+    }
+    self->_stopped = true;
+    vTaskDelete(NULL);
+}
+#endif
+
+void StateQueue::start(int core)
+{
+    if (_started || !enabled())
+    {
+        return;
+    }
+    _started = true;
+    // a queue that was stopped before starts over
+    _stopping = false;
+
+#if defined(ARDUINO_ARCH_ESP32)
+    _stopped = false;
+    xTaskCreatePinnedToCore(task, "hueState", HUE_STATE_TASK_STACK, this, HUE_STATE_TASK_PRIORITY, &_task,
+        core < 0 ? tskNO_AFFINITY : core);
+#else
+    (void)core;
+    _thread = std::thread([this]() {
+        while (!_stopping)
+        {
+            {
+                std::unique_lock<std::mutex> lock(_lock);
+                _wake.wait(lock, [this]() { return _dirty != 0 || _stopping; });
+            }
+            deliver();
+        }
+    });
+#endif
+}
+
+void StateQueue::stop()
+{
+    if (!_started)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _stopping = true;
+    }
+#if defined(ARDUINO_ARCH_ESP32)
+    xTaskNotifyGive(_task);
+    while (!_stopped)
+    {
+        vTaskDelay(1);
+    }
+#else
+    _wake.notify_one();
+    _thread.join();
+#endif
+    _started = false;
+}
+
+void StateQueue::push(unsigned char id, const device_t & device)
+{
+    if (id >= HUE_MAX_DEVICES)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        if (_dirty & (1ULL << id))
+        {
+            HUE_METRIC(hueMetrics.stateCoalesced++);
+        }
+        _pending[id] = device;
+        _dirty |= 1ULL << id;
+        HUE_METRIC(hueMetrics.stateQueued++);
+    }
+
+#if defined(ARDUINO_ARCH_ESP32)
+    if (_task != NULL)
+    {
+        xTaskNotifyGive(_task);
+    }
+#else
+    _wake.notify_one();
+#endif
+}
+
+// takes every waiting change and passes them to the callback outside the lock
+void StateQueue::deliver()
+{
+    device_change_t changes[HUE_MAX_DEVICES];
+    size_t count = 0;
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        for (unsigned char id = 0; _dirty != 0 && id < HUE_MAX_DEVICES; id++)
+        {
+            if (_dirty & (1ULL << id))
+            {
+                changes[count].id = id;
+                changes[count].device = _pending[id];
+                count++;
+                _dirty &= ~(1ULL << id);
+            }
+        }
+    }
+
+    if (count > 0 && _callback)
+    {
+        HUE_METRIC(hueMetrics.stateBatches++);
+        _callback(changes, count);
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include "DeviceRegistry.h"
+#include "HueMetrics.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+    #include <freertos/FreeRTOS.h>
+    #include <freertos/task.h>
+#else
+    #include <condition_variable>
+    #include <thread>
+#endif
+
+#define HUE_STATE_TASK_STACK        4096
+#define HUE_STATE_TASK_PRIORITY     1
+
+typedef struct {
+    unsigned char id;
+    device_t device;        // state of the light when it was queued
+} device_change_t;
+
+typedef std::function<void(const device_change_t *, size_t)> TStateChangesCallback;
+
+/*
+    Hands state changes from the HTTP handlers to a worker task that calls the
+    user callback, so a reply never waits on LEDs, relays or fades. There is
+    one slot per light: a change to a light that is still waiting replaces
+    the queued state, so a fast brightness ramp ends up as the latest value
+    rather than a backlog. The worker takes every waiting change in one go and
+    passes them to the callback as one batch, ordered by light id.
+
+    The queue is bounded by HUE_MAX_DEVICES and push() never blocks on the
+    callback, only briefly on the lock that guards the slots.
+*/
+class StateQueue
+{
+    public:
+        ~StateQueue() { stop(); }
+        // changes are queued from now on and delivered once the worker runs
+        void begin(TStateChangesCallback fn) { _callback = fn; }
+        // starts the worker, pinned to core on the ESP32 unless core is negative
+        void start(int core = -1);
+        // delivers what is still waiting and ends the worker
+        void stop();
+        bool enabled() const { return _callback != NULL; }
+        void push(unsigned char id, const device_t & device);
+        void deliver();
+
+    private:
+        TStateChangesCallback _callback = NULL;
+        bool _started = false;
+        std::atomic<bool> _stopping{false};
+        device_t _pending[HUE_MAX_DEVICES];
+        uint64_t _dirty = 0;                // bit n is set while light n waits
+        std::mutex _lock;
+
+    #if defined(ARDUINO_ARCH_ESP32)
+        TaskHandle_t _task = NULL;
+        std::atomic<bool> _stopped{false};
+        static void task(void * queue);
+    #else
+        std::condition_variable _wake;
+        std::thread _thread;
+    #endif
+};
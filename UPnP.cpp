@@ -1,20 +1,52 @@
 
 #include "UPnP.h"
 
+// NT of the notifications, NULL stands for the uuid of the bridge, in the
+// order of the SSDP_REPLY_* bits
+static const char * const notifyTypes[UPnP_NOTIFY_TYPES] = {
+    "upnp:rootdevice",
+    NULL,
+    "urn:schemas-upnp-org:device:basic:1",
+};
+
 void UPnP::handle()
 {
     _handleUDP();
+    _sendPendingResponses();
+    _announce();
 }
 
-void UPnP::init()
+void UPnP::init(unsigned int tcp_port)
 {
+    _tcp_port = tcp_port;
+    platformBridgeId(_bridgeId, sizeof(_bridgeId));
+
+    // announcements are repeated within the max-age the search replies advertise
+    const char * maxAge = strstr(UPnP_UDP_RESPONSE_TEMPLATE, "max-age=");
+    _maxAge = maxAge != NULL ? atoi(maxAge + 8) : _maxAge;
+    _notifyIP = IPAddress();
+    _ipCheckTime = millis() - UPnP_IP_CHECK_INTERVAL;
+
     // UDP setup
-    #ifdef ESP32
-        _udp.beginMulticast(UPnP_UDP_MULTICAST_IP, UPnP_UDP_MULTICAST_PORT);
-    #else
-        #error Platform not supported
-    #endif
-    DEBUG_MSG_UPnP("[UPnP] UDP server started\n");
+    _udp.beginMulticast(UPnP_UDP_MULTICAST_IP, UPnP_UDP_MULTICAST_PORT);
+    LOG_UPnP(HUE_LOG_INFO, "UDP server started");
+}
+
+void UPnP::stop()
+{
+    if (_notifyIP != IPAddress())
+    {
+        for (int round = 0; round < UPnP_NOTIFY_REPEAT; round++)
+        {
+            for (int type = 0; type < UPnP_NOTIFY_TYPES; type++)
+            {
+                _sendNotify(type, false, _notifyIP);
+            }
+        }
+    }
+    _notifyIP = IPAddress();
+    _udp.stop();
+    LOG_UPnP(HUE_LOG_INFO, "UDP server stopped");
 }
 
 /*
@@ -26,63 +58,263 @@ void UPnP::init()
     LOCATION: http://192.168.86.47:80/description.xml
     SERVER: FreeRTOS/6.0.5, UPnP/1.0, IpBridge/1.17.0
     hue-bridgeid: f008d1d2cb4c
-    ST: urn:schemas-upnp-org:device:basic:1
+    ST: upnp:rootdevice
     USN: uuid:2f402f80-da50-11e1-9b23-f008d1d2cb4c::upnp:rootdevice
 
+    ST and USN are those of the NOTIFY of the same type, a search for the
+    uuid gets ST: uuid:... and a search for device:basic:1 gets
+    USN: uuid:...::urn:schemas-upnp-org:device:basic:1.
 */
-void UPnP::_sendUDPResponse()
+void UPnP::_buildResponse(IPAddress ip)
+{
+    for (int type = 0; type < UPnP_NOTIFY_TYPES; type++)
+    {
+        char st[UPnP_NT_LENGTH + 1];
+        char usn[UPnP_USN_LENGTH + 1];
+        _typeFields(type, st, usn);
+        int length = snprintf_P(
+            _response[type], sizeof(_response[type]),
+            UPnP_UDP_RESPONSE_TEMPLATE,
+            ip[0], ip[1], ip[2], ip[3], _tcp_port,  // LOCATION
+            _bridgeId,                              // hue-bridgeid
+            st, usn);
+        _responseLength[type] = length < (int)sizeof(_response[type]) ? length : sizeof(_response[type]) - 1;
+    }
+    _responseIP = ip;
+}
+
+void UPnP::_sendUDPResponse(IPAddress ip, uint16_t port, int type)
 {
-    IPAddress ip = WiFi.localIP();
-    String mac = WiFi.macAddress();
-    mac.replace(":", "");
-    mac.toLowerCase();
-
-    char response[strlen(UPnP_UDP_RESPONSE_TEMPLATE) + 128];
-    snprintf_P(
-        response, sizeof(response),
-        UPnP_UDP_RESPONSE_TEMPLATE,
-        ip[0], ip[1], ip[2], ip[3], _tcp_port,  // LOCATION
-        mac.c_str(), // hue-bridgeid
-        mac.c_str()  // USN
-        );
-
-    DEBUG_MSG_UPnP("\n[UPnP] Responding to M-SEARCH request from %s:%d\n%s", _udp.remoteIP().toString().c_str(), _udp.remotePort(), response);
-
-    _udp.beginPacket(_udp.remoteIP(), _udp.remotePort());
-    #if defined(ESP32)
-        _udp.printf(response);
-    #else
-        #error Platform not supported
-    #endif
+    IPAddress local = WiFi.localIP();
+    if (_responseLength[type] == 0 || local != _responseIP)
+    {
+        _buildResponse(local);
+    }
+
+    DEBUG_MSG_UPnP("Responding to M-SEARCH request from %s:%d\n%s", ip.toString().c_str(), port, _response[type]);
+
+    _udp.beginPacket(ip, port);
+    _udp.write((const uint8_t *)_response[type], _responseLength[type]);
     _udp.endPacket();
+    HUE_METRIC(hueMetrics.ssdpReplies++);
 }
 
 /*
-    Sample message received from Amazon Echo
+    Multicasts one ssdp:alive NOTIFY packet when it is due. An announcement is
+    a NOTIFY for each of upnp:rootdevice, the bridge uuid and device:basic:1,
+    sent UPnP_NOTIFY_REPEAT times, one packet per call spaced by
+    UPnP_NOTIFY_SPACING so handle() never sends a burst. It is repeated after
+    half the max-age, less up to a fifth of that as jitter, and right away
+    when the local IP changes so an Echo does not keep a stale LOCATION until
+    its next search.
+*/
+void UPnP::_announce()
+{
+    unsigned long now = millis();
+    if (now - _ipCheckTime >= UPnP_IP_CHECK_INTERVAL)
+    {
+        _ipCheckTime = now;
+        IPAddress ip = WiFi.localIP();
+        if (ip != _notifyIP)
+        {
+            _notifyIP = ip;
+            _notifyType = 0;
+            _notifyRound = 0;
+            _notifyTime = now;
+        }
+    }
+    if (_notifyIP == IPAddress() || (long)(now - _notifyTime) < 0)
+    {
+        return;
+    }
 
-    M-SEARCH * HTTP/1.1
-    HOST: 239.255.255.250:1900
-    ST: ssdp:all
-    MAN: "ssdp:discover"
-    MX: 3
+    _sendNotify(_notifyType, true, _notifyIP);
+    _notifyTime = now + UPnP_NOTIFY_SPACING;
+    if (++_notifyType == UPnP_NOTIFY_TYPES)
+    {
+        _notifyType = 0;
+        if (++_notifyRound == UPnP_NOTIFY_REPEAT)
+        {
+            _notifyRound = 0;
+            long interval = _maxAge * 1000L / 2;
+            _notifyTime = now + interval - random(interval / 5);
+        }
+    }
+}
 
-*/ 
-void UPnP::_handleUDP()
+// NT (or ST) and USN of a notification type, UPnP_NT_LENGTH + 1 and UPnP_USN_LENGTH + 1 bytes
+void UPnP::_typeFields(int type, char * nt, char * usn)
 {
-    int len = _udp.parsePacket();
-    if (len > 0)
+    if (notifyTypes[type] == NULL)
+    {
+        snprintf(nt, UPnP_NT_LENGTH + 1, "uuid:2f402f80-da50-11e1-9b23-%s", _bridgeId);
+        snprintf(usn, UPnP_USN_LENGTH + 1, "%s", nt);
+    }
+    else
+    {
+        snprintf(nt, UPnP_NT_LENGTH + 1, "%s", notifyTypes[type]);
+        snprintf(usn, UPnP_USN_LENGTH + 1, "uuid:2f402f80-da50-11e1-9b23-%s::%s", _bridgeId, notifyTypes[type]);
+    }
+}
+
+void UPnP::_sendNotify(int type, bool alive, IPAddress ip)
+{
+    char nt[UPnP_NT_LENGTH + 1];
+    char usn[UPnP_USN_LENGTH + 1];
+    _typeFields(type, nt, usn);
+
+    char packet[UPnP_NOTIFY_ALIVE_SIZE > UPnP_NOTIFY_BYEBYE_SIZE ? UPnP_NOTIFY_ALIVE_SIZE : UPnP_NOTIFY_BYEBYE_SIZE];
+    int length;
+    if (alive)
+    {
+        length = snprintf_P(packet, sizeof(packet), UPnP_NOTIFY_ALIVE_TEMPLATE,
+            _maxAge,
+            ip[0], ip[1], ip[2], ip[3], _tcp_port,  // LOCATION
+            _bridgeId,                              // hue-bridgeid
+            nt, usn);
+    }
+    else
+    {
+        length = snprintf_P(packet, sizeof(packet), UPnP_NOTIFY_BYEBYE_TEMPLATE, nt, usn);
+    }
+    length = length < (int)sizeof(packet) ? length : sizeof(packet) - 1;
+
+    DEBUG_MSG_UPnP("Sending NOTIFY\n%s", packet);
+
+    _udp.beginMulticastPacket();
+    _udp.write((const uint8_t *)packet, length);
+    _udp.endPacket();
+    HUE_METRIC(hueMetrics.ssdpNotifies++);
+}
+
+/*
+    Remembers a searcher and picks a random time within its MX window to
+    answer, so a room full of Echos rediscovering at once does not get all
+    the replies in the same loop. A source that is already waiting for a
+    reply of the same type, or got one within UPnP_DEDUP_WINDOW, is not
+    answered again.
+*/
+void UPnP::_scheduleResponse(IPAddress ip, uint16_t port, int mx, int type)
+{
+    unsigned long now = millis();
+    searcher_t * slot = NULL;
+    searcher_t * oldest = NULL;
+    for (int i = 0; i < UPnP_MAX_PENDING; i++)
     {
-        unsigned char data[len + 1];
-        _udp.read(data, len);
-        data[len] = 0;
-        String request = (const char *)data;
-        if (request.indexOf("M-SEARCH") >= 0)
+        searcher_t * searcher = &_searchers[i];
+        if (searcher->port != 0 && searcher->sent && now - searcher->time >= UPnP_DEDUP_WINDOW)
+        {
+            searcher->port = 0;
+        }
+        if (searcher->port == 0)
         {
-            DEBUG_MSG_UPnP("\n[UPnP] M-SEARCH received from  %s:%d\n%s", _udp.remoteIP().toString().c_str(), _udp.remotePort(), (const char *)data);
-            if ((request.indexOf("ssdp:discover") > 0) || (request.indexOf("upnp:rootdevice") > 0) || (request.indexOf("device:basic:1") > 0))
+            if (slot == NULL)
             {
-                _sendUDPResponse();
+                slot = searcher;
             }
+            continue;
+        }
+        if (searcher->ip == ip && searcher->port == port && searcher->type == type)
+        {
+            HUE_METRIC(hueMetrics.ssdpSuppressed++);
+            return;
+        }
+        if (searcher->sent && (oldest == NULL || (long)(searcher->time - oldest->time) < 0))
+        {
+            oldest = searcher;
+        }
+    }
+
+    // forget the oldest answered source before dropping a new one
+    if (slot == NULL)
+    {
+        slot = oldest;
+    }
+    if (slot == NULL)
+    {
+        HUE_METRIC(hueMetrics.ssdpSuppressed++);
+        return;
+    }
+
+    // unicast searches carry no MX and are answered right away
+    long delay = 0;
+    if (mx > 0)
+    {
+        delay = mx * 1000L < UPnP_MAX_REPLY_DELAY ? mx * 1000L : UPnP_MAX_REPLY_DELAY;
+        delay = random(delay);
+    }
+    slot->ip = ip;
+    slot->port = port;
+    slot->sent = false;
+    slot->type = type;
+    slot->time = now + delay;
+}
+
+void UPnP::_sendPendingResponses()
+{
+    unsigned long now = millis();
+    for (int i = 0; i < UPnP_MAX_PENDING; i++)
+    {
+        searcher_t * searcher = &_searchers[i];
+        if (searcher->port == 0 || searcher->sent || (long)(now - searcher->time) < 0)
+        {
+            continue;
+        }
+
+        // over the cap the reply stays pending until the next second
+        if (now - _rateWindow >= 1000)
+        {
+            _rateWindow = now;
+            _rateCount = 0;
+        }
+        if (_rateCount >= UPnP_MAX_REPLIES_PER_SEC)
+        {
+            return;
+        }
+        _rateCount++;
+
+        _sendUDPResponse(searcher->ip, searcher->port, searcher->type);
+        searcher->sent = true;
+        searcher->time = now;
+    }
+}
+
+/*
+    The request is parsed in the receive buffer by SsdpRequest, see there for
+    a sample. Searches are only answered when their ST names something the
+    bridge is: ssdp:all, upnp:rootdevice, device:basic:1 or its own uuid,
+    with the reply of that type. ssdp:all gets all three replies, each with
+    its own delay. The Echo searches with ssdp:all and looks for basic:1.
+*/
+void UPnP::_handleUDP()
+{
+    int len = _udp.parsePacket();
+    if (len <= 0)
+    {
+        return;
+    }
+
+    len = _udp.read((unsigned char *)_packet, sizeof(_packet));
+    SsdpRequest request;
+    if (len <= 0 || !request.parse(_packet, len) || request.method() != SsdpRequest::M_SEARCH)
+    {
+        return;
+    }
+
+    HUE_METRIC(hueMetrics.ssdpSearches++);
+    DEBUG_MSG_UPnP("M-SEARCH received from %s:%d\n%.*s", _udp.remoteIP().toString().c_str(), _udp.remotePort(), len, _packet);
+    SsdpRequest::Target target = request.isSearch() ? request.target(_bridgeId) : SsdpRequest::TARGET_NONE;
+    if (target == SsdpRequest::TARGET_NONE)
+    {
+        HUE_METRIC(hueMetrics.ssdpIgnored++);
+        return;
+    }
+    uint8_t replies = SsdpRequest::replies(target);
+    for (int type = 0; type < UPnP_NOTIFY_TYPES; type++)
+    {
+        if (replies & (1 << type))
+        {
+            _scheduleResponse(_udp.remoteIP(), _udp.remotePort(), request.mx(), type);
         }
     }
 }
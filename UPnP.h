@@ -6,49 +6,122 @@
 #define UPnP_UDP_MULTICAST_PORT   1900
 #define UPnP_TCP_PORT             80
 
-//#define DEBUG_UPnP                Serial
-#ifdef DEBUG_UPnP
-    #if defined(ARDUINO_ARCH_ESP32)
-        #define DEBUG_MSG_UPnP(fmt, ...) { DEBUG_UPnP.printf_P((PGM_P) PSTR(fmt), ## __VA_ARGS__); }
-    #else
-        #error Platform not supported
-    #endif
-#else
-    #define DEBUG_MSG_UPnP(...)
-#endif
+#define UPnP_MAX_PENDING          12      // replies remembered for scheduling and deduplication, ssdp:all takes three
+#define UPnP_MAX_REPLY_DELAY      1500    // ms, upper bound of the random MX delay
+#define UPnP_DEDUP_WINDOW         2000    // ms, repeated searches from a source are ignored this long after its reply
+#define UPnP_MAX_REPLIES_PER_SEC  10
+#define UPnP_NOTIFY_REPEAT        2       // NOTIFY rounds per announcement, UDP may lose some
+#define UPnP_NOTIFY_SPACING       100     // ms between the packets of an announcement
+#define UPnP_IP_CHECK_INTERVAL    1000    // ms, how often the local IP is checked for changes
+#define UPnP_MAX_PACKET           512     // longer SSDP requests are cut off, the headers that matter come first
+#define UPnP_NT_LENGTH            47      // longest NT of a NOTIFY
+#define UPnP_USN_LENGTH           95      // longest USN of a NOTIFY
+#define UPnP_NOTIFY_TYPES         3       // upnp:rootdevice, the bridge uuid and device:basic:1
 
+#include "Platform.h"
+#include "templates.h"
+#include "SsdpRequest.h"
+#include "HueMetrics.h"
+#include "HueLog.h"
 
-#if defined(ESP32)
-    #include <WiFi.h>
-#else
-	#error Platform not supported
+#ifndef HUE_LOG_LEVEL_UPNP
+    #define HUE_LOG_LEVEL_UPNP      HUE_LOG_LEVEL
 #endif
+#define LOG_UPnP(level, fmt, ...)   HUE_LOG(HUE_LOG_LEVEL_UPNP, level, "UPnP", fmt, ## __VA_ARGS__)
+#define DEBUG_MSG_UPnP(fmt, ...)    LOG_UPnP(HUE_LOG_DEBUG, fmt, ## __VA_ARGS__)
 
-#include <WiFiUdp.h>
-#include "templates.h"
-
-PROGMEM const char UPnP_UDP_RESPONSE_TEMPLATE[] =
+PROGMEM constexpr char UPnP_UDP_RESPONSE_TEMPLATE[] =
     "HTTP/1.1 200 OK\r\n"
     "EXT:\r\n"
     "CACHE-CONTROL: max-age=100\r\n"
-    "LOCATION: http://%d.%d.%d.%d:%d/description.xml\r\n"
+    "LOCATION: http://%d.%d.%d.%d:%u/description.xml\r\n"
+    "SERVER: FreeRTOS/6.0.5, UPnP/1.0, IpBridge/1.17.0\r\n"
+    "hue-bridgeid: %s\r\n"
+    "ST: %s\r\n"
+    "USN: %s\r\n"
+    "\r\n";
+// ST and USN are those of the notification type the search asked for
+constexpr size_t UPnP_RESPONSE_SIZE = hueTemplateSize<
+    uint8_t, uint8_t, uint8_t, uint8_t, unsigned int,   // LOCATION
+    HueText<12>,                                        // hue-bridgeid
+    HueText<UPnP_NT_LENGTH>, HueText<UPnP_USN_LENGTH>
+    >(UPnP_UDP_RESPONSE_TEMPLATE);
+
+// NT and USN are filled in for each of the three notification types
+PROGMEM constexpr char UPnP_NOTIFY_ALIVE_TEMPLATE[] =
+    "NOTIFY * HTTP/1.1\r\n"
+    "HOST: 239.255.255.250:1900\r\n"
+    "CACHE-CONTROL: max-age=%d\r\n"
+    "LOCATION: http://%d.%d.%d.%d:%u/description.xml\r\n"
     "SERVER: FreeRTOS/6.0.5, UPnP/1.0, IpBridge/1.17.0\r\n"
+    "NTS: ssdp:alive\r\n"
     "hue-bridgeid: %s\r\n"
-    "ST: urn:schemas-upnp-org:device:basic:1\r\n"
-    "USN: uuid:2f402f80-da50-11e1-9b23-%s::upnp:rootdevice\r\n"
+    "NT: %s\r\n"
+    "USN: %s\r\n"
+    "\r\n";
+constexpr size_t UPnP_NOTIFY_ALIVE_SIZE = hueTemplateSize<
+    int,                                                // max-age
+    uint8_t, uint8_t, uint8_t, uint8_t, unsigned int,   // LOCATION
+    HueText<12>,                                        // hue-bridgeid
+    HueText<UPnP_NT_LENGTH>, HueText<UPnP_USN_LENGTH>
+    >(UPnP_NOTIFY_ALIVE_TEMPLATE);
+
+PROGMEM constexpr char UPnP_NOTIFY_BYEBYE_TEMPLATE[] =
+    "NOTIFY * HTTP/1.1\r\n"
+    "HOST: 239.255.255.250:1900\r\n"
+    "NTS: ssdp:byebye\r\n"
+    "NT: %s\r\n"
+    "USN: %s\r\n"
     "\r\n";
+constexpr size_t UPnP_NOTIFY_BYEBYE_SIZE = hueTemplateSize<HueText<UPnP_NT_LENGTH>, HueText<UPnP_USN_LENGTH> >(UPnP_NOTIFY_BYEBYE_TEMPLATE);
 
 
 class UPnP {
     public:
-        void init();
+        void init(unsigned int tcp_port = UPnP_TCP_PORT);
         void handle();
+        // multicasts ssdp:byebye and closes the socket
+        void stop();
 
     private:
+        typedef struct {
+            IPAddress ip;
+            uint16_t port;          // 0 when the entry is free
+            bool sent;
+            uint8_t type;           // notification type the reply is for
+            unsigned long time;     // when the reply is due, or when it was sent
+        } searcher_t;
+
         WiFiUDP _udp;
         unsigned int _tcp_port = UPnP_TCP_PORT;
+        char _bridgeId[13];
+        char _packet[UPnP_MAX_PACKET];
+
+        // the replies only change with the IP address so they are built once,
+        // one for each notification type
+        char _response[UPnP_NOTIFY_TYPES][UPnP_RESPONSE_SIZE];
+        size_t _responseLength[UPnP_NOTIFY_TYPES] = {};
+        IPAddress _responseIP;
+
+        // ssdp:alive announcements, one packet per handle() when due
+        int _maxAge = 100;                  // seconds, from UPnP_UDP_RESPONSE_TEMPLATE
+        unsigned long _notifyTime = 0;      // when the next packet is due
+        int _notifyType = 0;                // notification type of the next packet
+        int _notifyRound = 0;
+        IPAddress _notifyIP;                // address that was last announced
+        unsigned long _ipCheckTime = 0;
+
+        searcher_t _searchers[UPnP_MAX_PENDING] = {};
+        unsigned long _rateWindow = 0;
+        int _rateCount = 0;
 
         void _handleUDP();
         void _onUDPData(const IPAddress remoteIP, unsigned int remotePort, void *data, size_t len);
-        void _sendUDPResponse();
+        void _scheduleResponse(IPAddress ip, uint16_t port, int mx, int type);
+        void _sendPendingResponses();
+        void _buildResponse(IPAddress ip);
+        void _sendUDPResponse(IPAddress ip, uint16_t port, int type);
+        void _announce();
+        void _sendNotify(int type, bool alive, IPAddress ip);
+        void _typeFields(int type, char * nt, char * usn);
 };
\ No newline at end of file
@@ -0,0 +1,3 @@
+#include "Arduino.h"
+
+HostSerial Serial;
@@ -0,0 +1,98 @@
+#pragma once
+
+// Host (Linux) stand-in for the parts of the Arduino core the sketch uses.
+// Flash memory is ordinary memory here, so the _P functions map onto the
+// regular C library.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include "WString.h"
+#include "IPAddress.h"
+
+#define PROGMEM
+#define PGM_P                   const char *
+#define PSTR(s)                 (s)
+#define F(s)                    (s)
+#define strlen_P                strlen
+#define strcpy_P                strcpy
+#define strncpy_P               strncpy
+#define memcpy_P                memcpy
+#define snprintf_P              snprintf
+#define vsnprintf_P             vsnprintf
+#define pgm_read_byte(addr)     (*(const uint8_t *)(addr))
+#define pgm_read_word(addr)     (*(const uint16_t *)(addr))
+
+// time since the process started, like the time since boot on the ESP32
+inline unsigned long micros()
+{
+    static struct timespec start = { 0, 0 };
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (start.tv_sec == 0 && start.tv_nsec == 0)
+        start = now;
+    return (now.tv_sec - start.tv_sec) * 1000000UL + (now.tv_nsec - start.tv_nsec) / 1000L;
+}
+
+inline unsigned long millis()
+{
+    return micros() / 1000UL;
+}
+
+inline void delay(unsigned long ms)
+{
+    struct timespec wait = { (time_t)(ms / 1000), (long)((ms % 1000) * 1000000L) };
+    nanosleep(&wait, NULL);
+}
+
+inline long random(long max) { return max > 0 ? rand() % max : 0; }
+inline long random(long min, long max) { return max > min ? min + rand() % (max - min) : min; }
+
+// stdout, paced to the baud rate given to begin() so that writing to it takes
+// as long as it does on the UART, unpaced when begin() is not called
+class HostSerial
+{
+    public:
+        void begin(unsigned long baud) { _baud = baud; }
+        size_t printf(const char * fmt, ...) __attribute__((format(printf, 2, 3)))
+        {
+            va_list args;
+            va_start(args, fmt);
+            int len = vprintf(fmt, args);
+            va_end(args);
+            return pace(len < 0 ? 0 : len);
+        }
+        size_t printf_P(const char * fmt, ...)
+        {
+            va_list args;
+            va_start(args, fmt);
+            int len = vprintf(fmt, args);
+            va_end(args);
+            return pace(len < 0 ? 0 : len);
+        }
+        size_t print(const char * str) { return pace(fputs(str, stdout) < 0 ? 0 : strlen(str)); }
+        size_t println(const char * str) { return print(str) + print("\n"); }
+        size_t write(const uint8_t * data, size_t len) { return pace(fwrite(data, 1, len, stdout)); }
+        void flush() { fflush(stdout); }
+
+    private:
+        unsigned long _baud = 0;
+
+        // 10 bits a byte with the start and stop bit
+        size_t pace(size_t len)
+        {
+            if (_baud > 0)
+            {
+                fflush(stdout);
+                usleep((useconds_t)(len * 10 * 1000000ULL / _baud));
+            }
+            return len;
+        }
+};
+
+extern HostSerial Serial;
@@ -0,0 +1,16 @@
+#pragma once
+
+// Host (Linux) stand-in for the WebServer library's request methods,
+// the values match http_parser.h used on the ESP32
+
+typedef enum {
+    HTTP_DELETE  = 0,
+    HTTP_GET     = 1,
+    HTTP_HEAD    = 2,
+    HTTP_POST    = 3,
+    HTTP_PUT     = 4,
+    HTTP_OPTIONS = 6,
+    HTTP_PATCH   = 28,
+} HTTPMethod;
+
+#define HTTP_ANY    (HTTPMethod)(255)
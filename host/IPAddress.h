@@ -0,0 +1,35 @@
+#pragma once
+
+// Host (Linux) stand-in for the Arduino IPAddress class
+
+#include <stdint.h>
+#include <stdio.h>
+#include "WString.h"
+
+class IPAddress
+{
+    public:
+        IPAddress() : _address(0) {}
+        IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) { _bytes[0] = a; _bytes[1] = b; _bytes[2] = c; _bytes[3] = d; }
+        // address in network byte order, as found in sockaddr_in
+        IPAddress(uint32_t address) : _address(address) {}
+
+        operator uint32_t() const { return _address; }
+        uint8_t operator[](int index) const { return _bytes[index]; }
+        uint8_t & operator[](int index) { return _bytes[index]; }
+        bool operator==(const IPAddress & other) const { return _address == other._address; }
+        bool operator!=(const IPAddress & other) const { return _address != other._address; }
+
+        String toString() const
+        {
+            char buffer[16];
+            snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", _bytes[0], _bytes[1], _bytes[2], _bytes[3]);
+            return String(buffer);
+        }
+
+    private:
+        union {
+            uint8_t _bytes[4];
+            uint32_t _address;
+        };
+};
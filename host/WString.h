@@ -0,0 +1,82 @@
+#pragma once
+
+// Host (Linux) stand-in for the Arduino String class, only the parts the
+// sketch uses are implemented
+
+#include <string>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+class String
+{
+    public:
+        String() {}
+        String(const char * cstr) : _str(cstr ? cstr : "") {}
+        String(const char * cstr, unsigned int length) : _str(cstr, length) {}
+        String(const std::string & str) : _str(str) {}
+        String(char c) : _str(1, c) {}
+        String(int value) : _str(std::to_string(value)) {}
+        String(unsigned int value) : _str(std::to_string(value)) {}
+        String(long value) : _str(std::to_string(value)) {}
+        String(unsigned long value) : _str(std::to_string(value)) {}
+
+        const char * c_str() const { return _str.c_str(); }
+        unsigned int length() const { return _str.length(); }
+        bool reserve(unsigned int size) { _str.reserve(size); return true; }
+        char charAt(unsigned int index) const { return index < _str.length() ? _str[index] : 0; }
+        char operator[](unsigned int index) const { return charAt(index); }
+
+        bool concat(const String & s) { _str += s._str; return true; }
+        bool concat(const char * cstr) { _str += cstr; return true; }
+        bool concat(const char * cstr, unsigned int length) { _str.append(cstr, length); return true; }
+        bool concat(char c) { _str += c; return true; }
+        bool concat(int value) { _str += std::to_string(value); return true; }
+
+        String & operator+=(const String & s) { concat(s); return *this; }
+        String & operator+=(const char * cstr) { concat(cstr); return *this; }
+        String & operator+=(char c) { concat(c); return *this; }
+        String & operator+=(int value) { concat(value); return *this; }
+
+        friend String operator+(const String & a, const String & b) { return String(a._str + b._str); }
+        friend String operator+(const String & a, const char * b) { return String(a._str + b); }
+        friend String operator+(const char * a, const String & b) { return String(a + b._str); }
+
+        bool operator==(const String & s) const { return _str == s._str; }
+        bool operator==(const char * cstr) const { return _str == cstr; }
+        bool operator!=(const String & s) const { return _str != s._str; }
+        bool operator<(const String & s) const { return _str < s._str; }
+        bool equalsIgnoreCase(const String & s) const { return strcasecmp(c_str(), s.c_str()) == 0; }
+        bool startsWith(const String & s) const { return _str.compare(0, s._str.length(), s._str) == 0; }
+        bool endsWith(const String & s) const { return _str.length() >= s._str.length() && _str.compare(_str.length() - s._str.length(), s._str.length(), s._str) == 0; }
+
+        int indexOf(char c, unsigned int from = 0) const { size_t pos = _str.find(c, from); return pos == std::string::npos ? -1 : (int)pos; }
+        int indexOf(const String & s, unsigned int from = 0) const { size_t pos = _str.find(s._str, from); return pos == std::string::npos ? -1 : (int)pos; }
+        String substring(unsigned int from) const { return from < _str.length() ? String(_str.substr(from)) : String(); }
+        String substring(unsigned int from, unsigned int to) const { return from < to && from < _str.length() ? String(_str.substr(from, to - from)) : String(); }
+
+        void replace(const String & find, const String & replace)
+        {
+            if (find._str.empty())
+                return;
+            size_t pos = 0;
+            while ((pos = _str.find(find._str, pos)) != std::string::npos)
+            {
+                _str.replace(pos, find._str.length(), replace._str);
+                pos += replace._str.length();
+            }
+        }
+        void toLowerCase() { for (auto & c : _str) c = tolower(c); }
+        void toUpperCase() { for (auto & c : _str) c = toupper(c); }
+        void trim()
+        {
+            size_t start = _str.find_first_not_of(" \t\r\n");
+            size_t end = _str.find_last_not_of(" \t\r\n");
+            _str = start == std::string::npos ? "" : _str.substr(start, end - start + 1);
+        }
+        long toInt() const { return atol(_str.c_str()); }
+        float toFloat() const { return atof(_str.c_str()); }
+
+    private:
+        std::string _str;
+};
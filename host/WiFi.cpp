@@ -0,0 +1,192 @@
+#include "WiFi.h"
+#include "WiFiUdp.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <ifaddrs.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+HostWiFi WiFi;
+
+void HostWiFi::resolve()
+{
+    if (_resolved)
+        return;
+    _resolved = true;
+
+    const uint8_t defaultMac[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };   // locally administered
+    memcpy(_mac, defaultMac, sizeof(_mac));
+    const char * mac = getenv("HUE_MAC");
+    unsigned int m[6];
+    if (mac && sscanf(mac, "%x:%x:%x:%x:%x:%x", &m[0], &m[1], &m[2], &m[3], &m[4], &m[5]) == 6)
+    {
+        for (int i = 0; i < 6; i++)
+            _mac[i] = m[i];
+    }
+
+    struct in_addr addr;
+    const char * ip = getenv("HUE_IP");
+    if (ip && inet_pton(AF_INET, ip, &addr) == 1)
+    {
+        _ip = IPAddress((uint32_t)addr.s_addr);
+        return;
+    }
+
+    struct ifaddrs * list;
+    if (getifaddrs(&list) == 0)
+    {
+        for (struct ifaddrs * i = list; i != NULL; i = i->ifa_next)
+        {
+            if (i->ifa_addr && i->ifa_addr->sa_family == AF_INET)
+            {
+                uint32_t address = ((struct sockaddr_in *)i->ifa_addr)->sin_addr.s_addr;
+                if ((ntohl(address) >> 24) != 127)
+                {
+                    _ip = IPAddress(address);
+                    break;
+                }
+            }
+        }
+        freeifaddrs(list);
+    }
+}
+
+IPAddress HostWiFi::localIP()
+{
+    resolve();
+    return _ip;
+}
+
+uint8_t * HostWiFi::macAddress(uint8_t * mac)
+{
+    resolve();
+    memcpy(mac, _mac, sizeof(_mac));
+    return mac;
+}
+
+String HostWiFi::macAddress()
+{
+    resolve();
+    char buffer[18];
+    snprintf(buffer, sizeof(buffer), "%02X:%02X:%02X:%02X:%02X:%02X", _mac[0], _mac[1], _mac[2], _mac[3], _mac[4], _mac[5]);
+    return String(buffer);
+}
+
+uint8_t WiFiUDP::beginMulticast(IPAddress address, uint16_t port)
+{
+    stop();
+    _fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (_fd < 0)
+        return 0;
+
+    int enable = 1;
+    setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    setsockopt(_fd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        stop();
+        return 0;
+    }
+
+    struct ip_mreq group;
+    group.imr_multiaddr.s_addr = (uint32_t)address;
+    group.imr_interface.s_addr = (uint32_t)WiFi.localIP();
+    setsockopt(_fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &group, sizeof(group));
+    setsockopt(_fd, IPPROTO_IP, IP_MULTICAST_IF, &group.imr_interface, sizeof(group.imr_interface));
+
+    fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL, 0) | O_NONBLOCK);
+    _multicastIP = address;
+    _port = port;
+    return 1;
+}
+
+void WiFiUDP::stop()
+{
+    if (_fd >= 0)
+    {
+        close(_fd);
+        _fd = -1;
+    }
+}
+
+int WiFiUDP::parsePacket()
+{
+    _rxLength = 0;
+    _rxIndex = 0;
+    if (_fd < 0)
+        return 0;
+
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    int received = recvfrom(_fd, _rx, sizeof(_rx), 0, (struct sockaddr *)&addr, &len);
+    if (received <= 0)
+        return 0;
+
+    _rxLength = received;
+    _remoteIP = IPAddress((uint32_t)addr.sin_addr.s_addr);
+    _remotePort = ntohs(addr.sin_port);
+    return received;
+}
+
+int WiFiUDP::read(unsigned char * buffer, size_t len)
+{
+    int count = _rxLength - _rxIndex;
+    if ((size_t)count > len)
+        count = len;
+    memcpy(buffer, _rx + _rxIndex, count);
+    _rxIndex += count;
+    return count;
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port)
+{
+    _tx = "";
+    _txIP = ip;
+    _txPort = port;
+    return 1;
+}
+
+int WiFiUDP::beginMulticastPacket()
+{
+    return beginPacket(_multicastIP, _port);
+}
+
+size_t WiFiUDP::write(const uint8_t * buffer, size_t size)
+{
+    _tx.concat((const char *)buffer, size);
+    return size;
+}
+
+size_t WiFiUDP::printf(const char * fmt, ...)
+{
+    char buffer[1500];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(buffer, sizeof(buffer), fmt, args);
+    va_end(args);
+    if (len < 0)
+        return 0;
+    if ((size_t)len >= sizeof(buffer))
+        len = sizeof(buffer) - 1;
+    return write((const uint8_t *)buffer, len);
+}
+
+int WiFiUDP::endPacket()
+{
+    if (_fd < 0)
+        return 0;
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = (uint32_t)_txIP;
+    addr.sin_port = htons(_txPort);
+    return sendto(_fd, _tx.c_str(), _tx.length(), 0, (struct sockaddr *)&addr, sizeof(addr)) >= 0;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+// Host (Linux) stand-in for the ESP32 WiFi class. The MAC and IP address
+// are taken from the HUE_MAC and HUE_IP environment variables, otherwise the
+// IP of the first non loopback interface and a fixed MAC are used.
+
+#include "Arduino.h"
+
+class HostWiFi
+{
+    public:
+        IPAddress localIP();
+        uint8_t * macAddress(uint8_t * mac);
+        String macAddress();
+
+    private:
+        bool _resolved = false;
+        IPAddress _ip;
+        uint8_t _mac[6];
+
+        void resolve();
+};
+
+extern HostWiFi WiFi;
@@ -0,0 +1,40 @@
+#pragma once
+
+// Host (Linux) stand-in for WiFiUDP on top of a non-blocking BSD socket
+
+#include "Arduino.h"
+
+class WiFiUDP
+{
+    public:
+        ~WiFiUDP() { stop(); }
+
+        uint8_t beginMulticast(IPAddress address, uint16_t port);
+        void stop();
+
+        int parsePacket();
+        int read(unsigned char * buffer, size_t len);
+        IPAddress remoteIP() const { return _remoteIP; }
+        uint16_t remotePort() const { return _remotePort; }
+
+        int beginPacket(IPAddress ip, uint16_t port);
+        int beginMulticastPacket();
+        size_t write(const uint8_t * buffer, size_t size);
+        size_t printf(const char * fmt, ...);
+        int endPacket();
+
+    private:
+        int _fd = -1;
+        IPAddress _multicastIP;
+        uint16_t _port = 0;
+
+        char _rx[1500];
+        int _rxLength = 0;
+        int _rxIndex = 0;
+        IPAddress _remoteIP;
+        uint16_t _remotePort = 0;
+
+        String _tx;
+        IPAddress _txIP;
+        uint16_t _txPort = 0;
+};
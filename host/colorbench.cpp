@@ -0,0 +1,310 @@
+/*
+    Checks the fixed point conversions of HueColor against a double precision
+    implementation of the same formulas and times them.
+
+    For each conversion a grid of inputs is run through both and the largest
+    and mean difference is reported: 8 bit steps for RGB, ten-thousandths for
+    xy, 1/65536 of the circle for hue (only where the saturation is above 10,
+    the hue of a grey is meaningless) and steps of 254 for sat. The ct
+    reference is the Kim et al. formula the table was sampled from.
+
+    colorbench [-n iterations]
+
+    g++ -O2 -std=c++11 -Ihost -I. host/colorbench.cpp HueColor.cpp -o colorbench
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <unistd.h>
+#include <chrono>
+#include <vector>
+#include "HueColor.h"
+
+static const double XYZ_TO_RGB[3][3] = {
+    {  1.656492, -0.354851, -0.255038 },
+    { -0.707196,  1.655397,  0.036152 },
+    {  0.051713, -0.121364,  1.011530 },
+};
+
+static const double RGB_TO_XYZ[3][3] = {
+    { 0.664511, 0.154324, 0.162028 },
+    { 0.283881, 0.668433, 0.047685 },
+    { 0.000088, 0.072310, 0.986039 },
+};
+
+static double encode(double linear)
+{
+    return linear <= 0.0031308 ? 12.92 * linear : 1.055 * pow(linear, 1 / 2.4) - 0.055;
+}
+
+static double decode(double srgb)
+{
+    return srgb <= 0.04045 ? srgb / 12.92 : pow((srgb + 0.055) / 1.055, 2.4);
+}
+
+static int toByte(double value, int bri)
+{
+    return (int)floor(value * 255 * bri / 254 + 0.5);
+}
+
+static void refXyToSrgb(double x, double y, double rgb[3])
+{
+    double z = 1 - x - y;
+    double xyz[3] = { x / y, 1, z > 0 ? z / y : 0 };
+    double max = 0;
+    for (int c = 0; c < 3; c++)
+    {
+        rgb[c] = xyz[0] * XYZ_TO_RGB[c][0] + xyz[1] * XYZ_TO_RGB[c][1] + xyz[2] * XYZ_TO_RGB[c][2];
+        max = rgb[c] > max ? rgb[c] : max;
+    }
+    for (int c = 0; c < 3; c++)
+    {
+        rgb[c] = max > 0 && rgb[c] > 0 ? encode(rgb[c] / max) : 0;
+    }
+}
+
+static void refHueSatToSrgb(double hue, double sat, double rgb[3])
+{
+    double s = sat / 254;
+    double h = hue / 65536 * 6;
+    int sector = (int)h;
+    double f = h - sector;
+    double p = 1 - s, q = 1 - s * f, t = 1 - s * (1 - f);
+    switch (sector)
+    {
+        case 0:  rgb[0] = 1; rgb[1] = t; rgb[2] = p; break;
+        case 1:  rgb[0] = q; rgb[1] = 1; rgb[2] = p; break;
+        case 2:  rgb[0] = p; rgb[1] = 1; rgb[2] = t; break;
+        case 3:  rgb[0] = p; rgb[1] = q; rgb[2] = 1; break;
+        case 4:  rgb[0] = t; rgb[1] = p; rgb[2] = 1; break;
+        default: rgb[0] = 1; rgb[1] = p; rgb[2] = q; break;
+    }
+}
+
+static void refXyToHueSat(double x, double y, double * hue, double * sat)
+{
+    double rgb[3];
+    refXyToSrgb(x, y, rgb);
+    double max = fmax(rgb[0], fmax(rgb[1], rgb[2]));
+    double min = fmin(rgb[0], fmin(rgb[1], rgb[2]));
+    double delta = max - min;
+    *sat = max > 0 ? delta / max * 254 : 0;
+    double h = 0;
+    if (delta > 0)
+    {
+        h = max == rgb[0] ? (rgb[1] - rgb[2]) / delta : max == rgb[1] ? 2 + (rgb[2] - rgb[0]) / delta : 4 + (rgb[0] - rgb[1]) / delta;
+    }
+    h = h / 6 * 65536;
+    *hue = h < 0 ? h + 65536 : h;
+}
+
+static void refHueSatToXy(double hue, double sat, double * x, double * y)
+{
+    double rgb[3], xyz[3];
+    refHueSatToSrgb(hue, sat, rgb);
+    for (int c = 0; c < 3; c++)
+    {
+        rgb[c] = decode(rgb[c]);
+    }
+    for (int c = 0; c < 3; c++)
+    {
+        xyz[c] = rgb[0] * RGB_TO_XYZ[c][0] + rgb[1] * RGB_TO_XYZ[c][1] + rgb[2] * RGB_TO_XYZ[c][2];
+    }
+    double sum = xyz[0] + xyz[1] + xyz[2];
+    *x = xyz[0] / sum;
+    *y = xyz[1] / sum;
+}
+
+// Kim et al. cubic spline approximation of the Planckian locus
+static void refCtToXy(double ct, double * x, double * y)
+{
+    double t = 1e6 / ct;
+    double xc = t <= 4000 ? -0.2661239e9 / (t * t * t) - 0.2343589e6 / (t * t) + 0.8776956e3 / t + 0.179910
+                          : -3.0258469e9 / (t * t * t) + 2.1070379e6 / (t * t) + 0.2226347e3 / t + 0.240390;
+    double yc;
+    if (t <= 2222)
+    {
+        yc = -1.1063814 * xc * xc * xc - 1.34811020 * xc * xc + 2.18555832 * xc - 0.20219683;
+    }
+    else if (t <= 4000)
+    {
+        yc = -0.9549476 * xc * xc * xc - 1.37418593 * xc * xc + 2.09137015 * xc - 0.16748867;
+    }
+    else
+    {
+        yc = 3.0817580 * xc * xc * xc - 5.87338670 * xc * xc + 3.75112997 * xc - 0.37001483;
+    }
+    *x = xc;
+    *y = yc;
+}
+
+typedef struct {
+    const char * name;
+    const char * unit;
+    double max;
+    double sum;
+    long count;
+    long exact;         // differences under one unit
+} error_t;
+
+static void add(error_t * error, double difference)
+{
+    difference = fabs(difference);
+    error->max = difference > error->max ? difference : error->max;
+    error->sum += difference;
+    error->count++;
+    error->exact += difference < 1;
+}
+
+static void print(const error_t & error)
+{
+    printf("%-16s max %6.2f  mean %6.3f %-13s %6.2f%% under 1  (%ld)\n", error.name, error.max,
+        error.count > 0 ? error.sum / error.count : 0.0, error.unit, error.count > 0 ? 100.0 * error.exact / error.count : 0.0, error.count);
+}
+
+static volatile unsigned long sink;
+
+template <typename F>
+static double measure(F convert, long iterations)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (long n = 0; n < iterations; n++)
+    {
+        sink += convert(n);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return iterations > 0 ? ns / iterations : 0.0;
+}
+
+int main(int argc, char ** argv)
+{
+    long iterations = 2000000;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1)
+    {
+        if (opt == 'n')
+        {
+            iterations = atol(optarg);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-n iterations]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // points of the diagram that can be shown, x + y <= 1
+    std::vector<uint16_t> xs, ys;
+    for (int x = 50; x <= 7500; x += 50)
+    {
+        for (int y = 50; x + y <= 9000 && y <= 8500; y += 50)
+        {
+            xs.push_back(x);
+            ys.push_back(y);
+        }
+    }
+
+    error_t xyRgb = { "xy -> rgb", "8 bit steps", 0, 0, 0, 0 };
+    error_t xyHue = { "xy -> hue", "1/65536", 0, 0, 0, 0 };
+    error_t xySat = { "xy -> sat", "1/254", 0, 0, 0, 0 };
+    const int bris[] = { 254, 128, 1 };
+    for (size_t i = 0; i < xs.size(); i++)
+    {
+        double srgb[3];
+        refXyToSrgb(xs[i] / 10000.0, ys[i] / 10000.0, srgb);
+        for (int b = 0; b < 3; b++)
+        {
+            hue_rgbw_t rgb;
+            hueColorXyToRgb(xs[i], ys[i], bris[b], &rgb);
+            add(&xyRgb, rgb.r - toByte(srgb[0], bris[b]));
+            add(&xyRgb, rgb.g - toByte(srgb[1], bris[b]));
+            add(&xyRgb, rgb.b - toByte(srgb[2], bris[b]));
+        }
+
+        uint16_t hue;
+        uint8_t sat;
+        double refHue, refSat;
+        hueColorXyToHueSat(xs[i], ys[i], &hue, &sat);
+        refXyToHueSat(xs[i] / 10000.0, ys[i] / 10000.0, &refHue, &refSat);
+        add(&xySat, sat - refSat);
+        if (refSat > 10)
+        {
+            double difference = fabs(hue - refHue);
+            add(&xyHue, difference > 32768 ? 65536 - difference : difference);
+        }
+    }
+
+    error_t hsRgb = { "hue/sat -> rgb", "8 bit steps", 0, 0, 0, 0 };
+    error_t hsXy = { "hue/sat -> xy", "1/10000", 0, 0, 0, 0 };
+    for (int hue = 0; hue < 65536; hue += 97)
+    {
+        for (int sat = 0; sat <= 254; sat += 2)
+        {
+            double srgb[3], x, y;
+            hue_rgbw_t rgb;
+            hueColorHueSatToRgb(hue, sat, 254, &rgb);
+            refHueSatToSrgb(hue, sat, srgb);
+            add(&hsRgb, rgb.r - toByte(srgb[0], 254));
+            add(&hsRgb, rgb.g - toByte(srgb[1], 254));
+            add(&hsRgb, rgb.b - toByte(srgb[2], 254));
+
+            uint16_t fx, fy;
+            hueColorHueSatToXy(hue, sat, &fx, &fy);
+            refHueSatToXy(hue, sat, &x, &y);
+            add(&hsXy, fx - x * 10000);
+            add(&hsXy, fy - y * 10000);
+        }
+    }
+
+    error_t ctXy = { "ct -> xy", "1/10000", 0, 0, 0, 0 };
+    for (int ct = 153; ct <= 500; ct++)
+    {
+        uint16_t fx, fy;
+        double x, y;
+        hueColorCtToXy(ct, &fx, &fy);
+        refCtToXy(ct, &x, &y);
+        add(&ctXy, fx - x * 10000);
+        add(&ctXy, fy - y * 10000);
+    }
+
+    print(xyRgb);
+    print(xyHue);
+    print(xySat);
+    print(hsRgb);
+    print(hsXy);
+    print(ctXy);
+
+    const size_t points = xs.size();
+    printf("\n%-16s %7.1f ns\n", "xy -> rgb", measure([&](long n) {
+        hue_rgbw_t rgb;
+        hueColorXyToRgb(xs[n % points], ys[n % points], 254, &rgb);
+        return rgb.r + rgb.g + rgb.b;
+    }, iterations));
+    printf("%-16s %7.1f ns\n", "xy -> hue/sat", measure([&](long n) {
+        uint16_t hue;
+        uint8_t sat;
+        hueColorXyToHueSat(xs[n % points], ys[n % points], &hue, &sat);
+        return hue + sat;
+    }, iterations));
+    printf("%-16s %7.1f ns\n", "hue/sat -> rgb", measure([&](long n) {
+        hue_rgbw_t rgb;
+        hueColorHueSatToRgb(n * 97, n % 255, 254, &rgb);
+        return rgb.r + rgb.g + rgb.b;
+    }, iterations));
+    printf("%-16s %7.1f ns\n", "hue/sat -> xy", measure([&](long n) {
+        uint16_t x, y;
+        hueColorHueSatToXy(n * 97, n % 255, &x, &y);
+        return x + y;
+    }, iterations));
+    printf("%-16s %7.1f ns\n", "ct -> xy", measure([&](long n) {
+        uint16_t x, y;
+        hueColorCtToXy(153 + n % 348, &x, &y);
+        return x + y;
+    }, iterations));
+    printf("%-16s %7.1f ns\n", "double xy -> rgb", measure([&](long n) {
+        double srgb[3];
+        refXyToSrgb(xs[n % points] / 10000.0, ys[n % points] / 10000.0, srgb);
+        return toByte(srgb[0], 254) + toByte(srgb[1], 254) + toByte(srgb[2], 254);
+    }, iterations));
+    return 0;
+}
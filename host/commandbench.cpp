@@ -0,0 +1,210 @@
+/*
+    Checks the fast path for the PUT bodies an Echo sends against the generic
+    parser and reply of HueCommand, then times both.
+
+      - the bodies an Echo sends have to be recognized, and give the command
+        and the reply the json tokenizer and hueSuccessJson give
+      - random edits of them (whitespace, characters inserted, removed or
+        replaced) either fall back or give the same command as the tokenizer,
+        the edits that are recognized are counted
+      - the time of parsing a body and writing its reply is measured for both
+
+    commandbench [-n iterations] [-m mutations]
+
+    g++ -O2 -std=c++11 -Ihost -I. host/commandbench.cpp HueCommand.cpp SimpleJson.cpp HueLog.cpp host/Arduino.cpp -o commandbench
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include "HueCommand.h"
+
+// the colors and settings of the Alexa app, as listed in HueBridge.cpp
+static const char * bodies[] = {
+    "{\"on\":true}",
+    "{\"on\":false}",
+    "{\"on\":true,\"bri\":1}",
+    "{\"on\":true,\"bri\":128}",
+    "{\"on\":true,\"bri\":254}",
+    "{\"on\":true,\"ct\":153}",
+    "{\"on\":true,\"ct\":383}",
+    "{\"on\":true,\"ct\":500}",
+    "{\"on\":true, \"hue\" : 0, \"sat\" : 254 }",
+    "{\"on\":true, \"hue\" : 5461, \"sat\" : 254 }",
+    "{\"on\":true ,\"hue\" : 32768, \"sat\" : 254 }",
+    "{\"on\":true, \"hue\" : 43690, \"sat\" : 254 }",
+    "{\"on\":true, \"hue\" : 63351, \"sat\" : 64 } ",
+    "{\"on\":true,\"hue\":46421,\"sat\":127}",
+};
+static const size_t bodyCount = sizeof(bodies) / sizeof(bodies[0]);
+
+static bool sameCommand(const light_command_t & a, const light_command_t & b)
+{
+    return a.on == b.on && a.hasOn == b.hasOn && a.hasBri == b.hasBri && a.hasCt == b.hasCt && a.hasHue == b.hasHue
+        && a.hasSat == b.hasSat && a.hasXy == b.hasXy && a.bri == b.bri && a.ct == b.ct && a.hue == b.hue && a.sat == b.sat
+        && a.x == b.x && a.y == b.y && a.scene == b.scene;
+}
+
+static String genericReply(int id, const light_command_t & command, const device_t & device)
+{
+    char address[32];
+    snprintf(address, sizeof(address), "/lights/%d/state", id);
+    return hueSuccessJson(address, command, device);
+}
+
+// the state the light ends up in, with the other fields random
+static device_t deviceAfter(const light_command_t & command)
+{
+    device_t device;
+    memset(&device, 0, sizeof(device));
+    device.state = command.on;
+    device.bri = command.hasBri && command.bri != 0 ? command.bri : rand() % 256;
+    device.ct = command.hasCt && command.ct != 0 ? command.ct : (short)rand();
+    device.hue = command.hue;
+    device.sat = command.sat;
+    return device;
+}
+
+// compares the commands, and the replies for a random light, false on a difference
+static bool check(const char * body, bool * recognized)
+{
+    light_command_t fast, generic;
+    *recognized = hueParseAlexaCommand(body, &fast);
+    hueParseCommand(body, &generic);
+    if (!*recognized)
+    {
+        return true;
+    }
+    if (!sameCommand(fast, generic))
+    {
+        printf("command differs for %s\n", body);
+        return false;
+    }
+
+    int id = 1 + rand() % 255;
+    device_t device = deviceAfter(fast);
+    char reply[HUE_ALEXA_REPLY_SIZE];
+    size_t length = hueAlexaSuccessJson(reply, sizeof(reply), id, fast, device);
+    String expected = genericReply(id, generic, device);
+    if (length != expected.length() || strcmp(reply, expected.c_str()) != 0)
+    {
+        printf("reply differs for %s\n  fast    %s\n  generic %s\n", body, reply, expected.c_str());
+        return false;
+    }
+    return true;
+}
+
+static std::string mutate(const char * body)
+{
+    static const char alphabet[] = " \t\n{}[]\":,.-+0123456789eEtruefalsnobrictsahxy\\";
+    std::string text = body;
+    int edits = 1 + rand() % 3;
+    for (int i = 0; i < edits; i++)
+    {
+        size_t position = rand() % (text.size() + 1);
+        char c = alphabet[rand() % (sizeof(alphabet) - 1)];
+        switch (rand() % 4)
+        {
+            case 0: text.insert(position, 1, ' '); break;
+            case 1: text.insert(position, 1, c); break;
+            case 2: if (position < text.size()) text.erase(position, 1); break;
+            default: if (position < text.size()) text[position] = c; break;
+        }
+    }
+    return text;
+}
+
+template <typename F>
+static double measure(F put, long iterations)
+{
+    unsigned long sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long n = 0; n < iterations; n++)
+    {
+        sink += put(bodies[n % bodyCount], 1 + n % 32);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    if (sink == 42)
+    {
+        printf("\n");   // keeps the loop from being optimized away
+    }
+    return iterations > 0 ? ns / iterations : 0.0;
+}
+
+int main(int argc, char ** argv)
+{
+    long iterations = 2000000;
+    long mutations = 200000;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:m:")) != -1)
+    {
+        if (opt == 'n')
+        {
+            iterations = atol(optarg);
+        }
+        else if (opt == 'm')
+        {
+            mutations = atol(optarg);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-n iterations] [-m mutations]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    srand(1);
+    int failures = 0;
+    for (size_t i = 0; i < bodyCount; i++)
+    {
+        bool recognized;
+        if (!check(bodies[i], &recognized))
+        {
+            failures++;
+        }
+        else if (!recognized)
+        {
+            printf("not recognized: %s\n", bodies[i]);
+            failures++;
+        }
+    }
+    printf("%u Alexa bodies, %d failed\n", (unsigned int)bodyCount, failures);
+
+    long recognizedCount = 0;
+    for (long n = 0; n < mutations; n++)
+    {
+        std::string body = mutate(bodies[n % bodyCount]);
+        bool recognized;
+        if (!check(body.c_str(), &recognized))
+        {
+            failures++;
+        }
+        recognizedCount += recognized;
+    }
+    printf("%ld edited bodies, %ld recognized, %ld left to the tokenizer, %d differ\n",
+        mutations, recognizedCount, mutations - recognizedCount, failures);
+    if (failures > 0)
+    {
+        return 1;
+    }
+
+    device_t device;
+    memset(&device, 0, sizeof(device));
+    device.state = true;
+    device.bri = 128;
+    device.ct = 383;
+    printf("\n%-28s %7.1f ns\n", "tokenizer + hueSuccessJson", measure([&](const char * body, int id) {
+        light_command_t command;
+        hueParseCommand(body, &command);
+        return genericReply(id, command, device).length();
+    }, iterations));
+    printf("%-28s %7.1f ns\n", "fast path", measure([&](const char * body, int id) {
+        light_command_t command;
+        char reply[HUE_ALEXA_REPLY_SIZE];
+        hueParseAlexaCommand(body, &command);
+        return hueAlexaSuccessJson(reply, sizeof(reply), id, command, device);
+    }, iterations));
+    return 0;
+}
@@ -0,0 +1,338 @@
+/*
+    Compares the three ways of reading a PUT body:
+
+      - tree: SimpleJson::parse builds a JsonValue for every value, with its
+        own String, map and vector, and the properties are read through
+        hasPropery and operator[] as handle_PutState used to
+      - flat: FlatJson::parse puts every value into one arena of 10 byte
+        nodes, read through the same hasPropery and operator[]
+      - tokenizer: hueParseCommand pulls the properties out of the text with
+        JsonTokenizer, as handle_PutState does now
+
+    The heap allocations and bytes of one parse are counted by replacing the
+    global operator new, with the most bytes held at once for each body, then
+    all three are timed over the bodies an Echo sends. The host String keeps
+    short strings inline, so on the ESP32 the tree allocates more than it
+    does here.
+
+    Then a corpus of CLIP API payloads, with escaped and \\u encoded strings,
+    floats and exponents, is checked to decode as sent, malformed bodies are
+    checked to be rejected by FlatJson, and the decoding throughput of all
+    three is measured.
+
+    jsonbench [-n iterations]
+
+    g++ -O2 -std=c++11 -Ihost -I. host/jsonbench.cpp SimpleJson.cpp HueCommand.cpp HueLog.cpp host/Arduino.cpp -o jsonbench
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <new>
+#include "SimpleJson.h"
+#include "HueCommand.h"
+
+static unsigned long allocations = 0;
+static unsigned long allocated = 0;
+static long live = 0;           // bytes held, the size is kept in front of every block
+static long livePeak = 0;
+
+void * operator new(size_t size)
+{
+    allocations++;
+    allocated += size;
+    live += size;
+    livePeak = live > livePeak ? live : livePeak;
+    size_t * p = (size_t *)malloc(size + sizeof(max_align_t));
+    if (p == NULL)
+    {
+        throw std::bad_alloc();
+    }
+    *p = size;
+    return (char *)p + sizeof(max_align_t);
+}
+
+// kept out of line, inlined gcc takes the free() for a mismatch with operator new
+__attribute__((noinline)) void operator delete(void * p) noexcept
+{
+    if (p != NULL)
+    {
+        size_t * block = (size_t *)((char *)p - sizeof(max_align_t));
+        live -= *block;
+        free(block);
+    }
+}
+
+void operator delete(void * p, size_t) noexcept
+{
+    operator delete(p);
+}
+
+// the bodies an Echo sends, as listed in HueBridge.cpp
+static const char * bodies[] = {
+    "{\"on\":true}",
+    "{\"on\":false}",
+    "{\"on\":true,\"bri\":128}",
+    "{\"on\":true,\"ct\":383}",
+    "{\"on\":true, \"hue\" : 0, \"sat\" : 254 }",
+    "{\"on\":true, \"hue\" : 43690, \"sat\" : 254 }",
+    "{\"on\":true,\"xy\":[0.6750,0.3220]}",
+};
+static const size_t bodyCount = sizeof(bodies) / sizeof(bodies[0]);
+
+// bodies and responses of the Hue CLIP API v1 as the apps and a real bridge send them
+static const char * corpus[] = {
+    "{\"devicetype\":\"hue_ios_app#iPhone de J\\u00e9r\\u00f4me\"}",
+    "{\"on\":true,\"bri\":254,\"xy\":[0.6750,0.3220],\"transitiontime\":4}",
+    "{\"xy\":[0.1532,0.0475],\"bri_inc\":-25,\"transitiontime\":0}",
+    "{\"on\":true,\"ct\":366,\"alert\":\"select\",\"effect\":\"none\"}",
+    "{\"scene\":\"12\"}",
+    "{\"name\":\"Wohnzimmer \\\"Sofa\\\"\",\"lights\":[\"1\",\"2\",\"5\"],\"type\":\"Room\",\"class\":\"Living room\"}",
+    "{\"1\":{\"state\":{\"on\":true,\"bri\":144,\"hue\":13088,\"sat\":212,\"effect\":\"none\","
+        "\"xy\":[0.5128,0.4147],\"ct\":467,\"alert\":\"none\",\"colormode\":\"xy\",\"mode\":\"homeautomation\",\"reachable\":true},"
+        "\"swupdate\":{\"state\":\"noupdates\",\"lastinstall\":\"2021-03-04T12:36:13\"},\"type\":\"Extended color light\","
+        "\"name\":\"Hue color lamp 7\",\"modelid\":\"LCT007\",\"manufacturername\":\"Signify Netherlands B.V.\","
+        "\"productname\":\"Hue color lamp\",\"capabilities\":{\"certified\":true,\"control\":{\"mindimlevel\":1000,"
+        "\"maxlumen\":800,\"colorgamuttype\":\"B\",\"colorgamut\":[[0.675,0.322],[0.409,0.518],[0.167,0.04]],"
+        "\"ct\":{\"min\":153,\"max\":500}},\"streaming\":{\"renderer\":true,\"proxy\":false}},"
+        "\"config\":{\"archetype\":\"sultanbulb\",\"function\":\"mixed\",\"direction\":\"omnidirectional\"},"
+        "\"uniqueid\":\"00:17:88:01:00:bd:c7:b9-0b\",\"swversion\":\"5.127.1.26420\"}}",
+    "{\"name\":\"Wake up\",\"description\":\"Sunrise \\ud83c\\udf05 at 6:30\",\"command\":{\"address\":\"/api/u/groups/0/action\","
+        "\"body\":{\"scene\":\"7\",\"transitiontime\":1.8e3},\"method\":\"PUT\"},\"localtime\":\"W124/T06:30:00\",\"status\":\"enabled\"}",
+};
+static const size_t corpusCount = sizeof(corpus) / sizeof(corpus[0]);
+
+static int treeParse(const char * body)
+{
+    SimpleJson json;
+    json.parse(body);
+    int sum = json["on"].getBool();
+    sum += json.hasPropery("bri") ? json["bri"].getInt() : 0;
+    sum += json.hasPropery("ct") ? json["ct"].getInt() : 0;
+    sum += json.hasPropery("hue") ? json["hue"].getInt() : 0;
+    sum += json.hasPropery("sat") ? json["sat"].getInt() : 0;
+    sum += json.hasPropery("xy") ? 'x' : json.hasPropery("ct") ? 'c' : 'h';
+    return sum;
+}
+
+static int flatParse(const char * body)
+{
+    FlatJson json;
+    json.parse(body);
+    int sum = json["on"].getBool();
+    sum += json.hasPropery("bri") ? json["bri"].getInt() : 0;
+    sum += json.hasPropery("ct") ? json["ct"].getInt() : 0;
+    sum += json.hasPropery("hue") ? json["hue"].getInt() : 0;
+    sum += json.hasPropery("sat") ? json["sat"].getInt() : 0;
+    sum += json.hasPropery("xy") ? 'x' : json.hasPropery("ct") ? 'c' : 'h';
+    return sum;
+}
+
+static int tokenizerParse(const char * body)
+{
+    light_command_t command;
+    hueParseCommand(body, &command);
+    return command.on + command.bri + command.ct + command.hue + command.sat + hueCommandMode(command);
+}
+
+// walks every token, converting the numbers, as a reader of the whole body would
+static int tokenizerWalk(const char * body)
+{
+    JsonTokenizer json(body);
+    JsonTokenizer::TokenType type;
+    int sum = 0;
+    while ((type = json.next()) != JsonTokenizer::END && type != JsonTokenizer::ERROR)
+    {
+        sum += type == JsonTokenizer::NUMBER ? (int)json.getFloat() : json.tokenLength();
+    }
+    return sum;
+}
+
+static int treeDecode(const char * body)
+{
+    SimpleJson json;
+    json.parse(body);
+    return json.hasPropery("name");
+}
+
+static int flatDecode(const char * body)
+{
+    FlatJson json;
+    json.parse(body);
+    return json.hasPropery("name");
+}
+
+// megabytes of the corpus decoded per second
+template <typename F>
+static double throughput(F decode, long iterations)
+{
+    size_t bytes = 0;
+    unsigned long sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long n = 0; n < iterations; n++)
+    {
+        const char * body = corpus[n % corpusCount];
+        sink += decode(body);
+        bytes += strlen(body);
+    }
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (sink == 42)
+    {
+        printf("\n");
+    }
+    return s > 0 ? bytes / s / 1e6 : 0.0;
+}
+
+// strings, floats and exponents of the corpus have to come out as sent
+static bool checkDecoding()
+{
+    SimpleJson user;
+    user.parse(corpus[0]);
+    SimpleJson state;
+    state.parse(corpus[1]);
+    SimpleJson group;
+    group.parse(corpus[5]);
+    SimpleJson schedule;
+    schedule.parse(corpus[7]);
+    SimpleJson overflow;
+    overflow.parse("{\"bri\":1e999,\"ct\":-1e999}");
+
+    bool ok = true;
+    ok &= user["devicetype"].getString() == String("hue_ios_app#iPhone de J\xc3\xa9r\xc3\xb4me");
+    ok &= state["xy"][0].getFloat() == 0.6750f && state["xy"][1].getFloat() == 0.3220f;
+    ok &= state["transitiontime"].getInt() == 4;
+    ok &= group["name"].getString() == String("Wohnzimmer \"Sofa\"");
+    ok &= schedule["description"].getString() == String("Sunrise \xf0\x9f\x8c\x85 at 6:30");
+    ok &= schedule["command"]["body"]["transitiontime"].getInt() == 1800;
+    ok &= overflow["bri"].getInt() == INT32_MAX && overflow["ct"].getInt() == INT32_MIN;
+
+    FlatJson flatUser;
+    flatUser.parse(corpus[0]);
+    FlatJson flatState;
+    flatState.parse(corpus[1]);
+    FlatJson flatSchedule;
+    flatSchedule.parse(corpus[7]);
+    ok &= flatUser["devicetype"].getString() == user["devicetype"].getString();
+    ok &= flatState["xy"][0].getFloat() == 0.6750f && flatState["xy"][1].getFloat() == 0.3220f;
+    ok &= flatSchedule["description"].getString() == schedule["description"].getString();
+    ok &= flatSchedule["command"]["body"]["transitiontime"].getInt() == 1800;
+    return ok;
+}
+
+// bodies FlatJson has to reject without touching memory outside its arena,
+// run under -fsanitize=address to check that
+static bool checkMalformed()
+{
+    static const char * malformed[] = {
+        "{\"a\":}", "{\"a\":", "{\"a\"}", "{\"a\":[}", "[1,", "{\"a\":{\"b\":}}", "{\"on\":true,\"bri\":}", "", "}",
+    };
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(malformed) / sizeof(malformed[0]); i++)
+    {
+        FlatJson json;
+        if (json.parse(malformed[i]))
+        {
+            printf("FlatJson accepts %s\n", malformed[i]);
+            ok = false;
+        }
+        ok &= !json.hasPropery("a") && json["on"].getInt() == 0;
+    }
+    return ok;
+}
+
+template <typename F>
+static void report(const char * name, F parse, long iterations)
+{
+    unsigned long before = allocations, bytes = allocated;
+    for (size_t i = 0; i < bodyCount; i++)
+    {
+        parse(bodies[i]);
+    }
+    double perParse = (double)(allocations - before) / bodyCount;
+    double bytesPerParse = (double)(allocated - bytes) / bodyCount;
+
+    unsigned long sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long n = 0; n < iterations; n++)
+    {
+        sink += parse(bodies[n % bodyCount]);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    if (sink == 42)
+    {
+        printf("\n");   // keeps the loop from being optimized away
+    }
+    printf("%-10s %6.1f allocations %7.1f bytes %8.1f ns per parse\n", name, perParse, bytesPerParse,
+        iterations > 0 ? ns / iterations : 0.0);
+}
+
+int main(int argc, char ** argv)
+{
+    long iterations = 1000000;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1)
+    {
+        if (opt == 'n')
+        {
+            iterations = atol(optarg);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-n iterations]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    for (size_t i = 0; i < bodyCount; i++)
+    {
+        if (treeParse(bodies[i]) != tokenizerParse(bodies[i]) || flatParse(bodies[i]) != tokenizerParse(bodies[i]))
+        {
+            printf("tree, flat and tokenizer differ for %s\n", bodies[i]);
+            return 1;
+        }
+    }
+
+    // the most heap a parse holds at once, what a command costs a bridge
+    // that is short of RAM
+    int (*parsers[3])(const char *) = { treeParse, flatParse, tokenizerParse };
+    printf("%-40s %10s %10s %10s\n", "peak bytes of one parse", "tree", "flat", "tokenizer");
+    for (size_t i = 0; i < bodyCount; i++)
+    {
+        long peaks[3];
+        for (int k = 0; k < 3; k++)
+        {
+            livePeak = live;
+            long base = live;
+            parsers[k](bodies[i]);
+            peaks[k] = livePeak - base;
+        }
+        printf("%-40s %10ld %10ld %10ld\n", bodies[i], peaks[0], peaks[1], peaks[2]);
+    }
+    printf("\n");
+
+    report("tree", treeParse, iterations);
+    report("flat", flatParse, iterations);
+    report("tokenizer", tokenizerParse, iterations);
+
+    if (!checkDecoding())
+    {
+        printf("\nthe corpus is decoded wrongly\n");
+        return 1;
+    }
+    if (!checkMalformed())
+    {
+        printf("\nmalformed bodies are not rejected\n");
+        return 1;
+    }
+    size_t corpusBytes = 0;
+    for (size_t i = 0; i < corpusCount; i++)
+    {
+        corpusBytes += strlen(corpus[i]);
+    }
+    printf("\n%u CLIP payloads, %u bytes\n", (unsigned int)corpusCount, (unsigned int)corpusBytes);
+    printf("%-10s %7.1f MB/s\n", "tree", throughput(treeDecode, iterations / 4));
+    printf("%-10s %7.1f MB/s\n", "flat", throughput(flatDecode, iterations / 4));
+    printf("%-10s %7.1f MB/s\n", "tokenizer", throughput(tokenizerWalk, iterations / 4));
+    return 0;
+}
@@ -0,0 +1,135 @@
+/*
+    Checks that a streamed light list (HueBridge::streamLightList) is byte for
+    byte the response served from lightListJson().
+
+    A bridge with 1, 8 and 63 lights of different states is started in this
+    process, GET /api/userid/lights is requested once with every list streamed
+    and once with none, and the two responses are compared, before and after
+    a light in the middle is removed. Exits with 1 on a difference.
+
+    lightlistcheck [-p port]
+
+    g++ -O2 -std=gnu++11 -pthread -Ihost -I. host/lightlistcheck.cpp host/Arduino.cpp host/WiFi.cpp *.cpp -o lightlistcheck
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include "HueBridge.h"
+
+// body of GET uri with a connection of its own, the headers are checked for Content-Length
+static std::string get(unsigned int port, const char * uri)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    timeval timeout = { 5, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    std::string request = std::string("GET ") + uri + " HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n\r\n";
+    std::string response;
+    if (connect(fd, (const sockaddr *)&addr, sizeof(addr)) == 0
+        && send(fd, request.data(), request.size(), MSG_NOSIGNAL) == (ssize_t)request.size())
+    {
+        char buffer[4096];
+        ssize_t len;
+        while ((len = recv(fd, buffer, sizeof(buffer), 0)) > 0)
+        {
+            response.append(buffer, len);
+        }
+    }
+    close(fd);
+
+    size_t headerEnd = response.find("\r\n\r\n");
+    size_t field = response.find("\r\nContent-Length: ");
+    if (headerEnd == std::string::npos || field == std::string::npos || field > headerEnd)
+    {
+        return "";
+    }
+    std::string body = response.substr(headerEnd + 4);
+    return (size_t)atol(response.c_str() + field + 18) == body.size() ? body : "";
+}
+
+// the light list as the bridge sends it with lists of minDevices lights or more streamed
+static std::string lightList(HueBridge * bridge, unsigned int port, size_t minDevices)
+{
+    bridge->setStreamMinDevices(minDevices);
+    std::atomic<bool> done(false);
+    std::string body;
+    std::thread client([&]() {
+        body = get(port, "/api/userid/lights");
+        done = true;
+    });
+    while (!done)
+    {
+        bridge->handle();
+        usleep(100);
+    }
+    client.join();
+    return body;
+}
+
+static bool compare(HueBridge * bridge, unsigned int port, int lights, const char * when)
+{
+    std::string streamed = lightList(bridge, port, 1);
+    std::string cached = lightList(bridge, port, HUE_MAX_DEVICES + 1);
+    bool same = !streamed.empty() && streamed == cached;
+    printf("%2d lights%-12s streamed %6u bytes, lightListJson %6u bytes, %s\n", lights, when,
+        (unsigned int)streamed.size(), (unsigned int)cached.size(), same ? "identical" : "DIFFERENT");
+    return same;
+}
+
+int main(int argc, char ** argv)
+{
+    unsigned int port = 8090;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:")) != -1)
+    {
+        if (opt == 'p')
+        {
+            port = atoi(optarg);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-p port]\n", argv[0]);
+            return 1;
+        }
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    static const int sizes[] = { 1, 8, 63 };
+    bool ok = true;
+    for (int lights : sizes)
+    {
+        HueBridge * bridge = new HueBridge(port);
+        char name[32];
+        for (int i = 0; i < lights; i++)
+        {
+            snprintf(name, sizeof(name), i % 3 == 0 ? "light %d" : "Wohnzimmer Decke %d", i + 1);
+            bridge->addDevice(name);
+        }
+        bridge->start();
+        for (int i = 0; i < lights; i++)
+        {
+            bridge->setState(i, i % 2 == 0, 1 + i * 4, 153 + i * 5, i * 1000, 254 - i * 4, "hcx"[i % 3], 1000 + i * 80, 1000 + i * 70);
+        }
+        ok &= compare(bridge, port, lights, "");
+        if (lights > 2)
+        {
+            bridge->removeDevice(lights / 2);
+            ok &= compare(bridge, port, lights - 1, ", one gap");
+        }
+        bridge->stop();
+        delete bridge;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,652 @@
+/*
+    Load generator that emulates a fleet of Echo devices talking to the
+    bridge. Every emulated Echo runs in its own thread and mixes the traffic
+    an Echo sends:
+
+      - M-SEARCH bursts to the SSDP port, answered by UPnP::_handleUDP
+      - GET /api/userid/lights polls
+      - PUT /api/userid/lights/{id}/state with the bodies Alexa sends for the
+        shades of white and colors documented in HueBridge::handle_PutState
+      - whole room commands, sent both ways so their latency can be compared:
+        as one PUT /lights/{id}/state per light in sequence ("room lights")
+        and as a single PUT /api/userid/groups/0/action ("room group")
+
+    Requests of each kind are scheduled at a fixed rate per Echo. Throughput,
+    latency percentiles and errors are reported per kind. With --pid the peak
+    resident memory (VmHWM) of a bridge running on the same machine is
+    reported as its heap high-water mark.
+
+    By default every request opens its own connection and asks the bridge to
+    close it, the way the WebServer library works. With --keep-alive every
+    Echo keeps one connection open and sends all its HTTP requests over it,
+    and with --pipeline n a light list poll is n GETs written at once whose
+    responses are read back in order. The number of connections opened and
+    the mean time connect() took are reported, which is the setup a poll
+    saves when the connection is reused.
+
+    --events n opens n GET /eventstream subscriptions next to the Echos, the
+    way wall panels follow the lights instead of polling, and reports the
+    events each of them received. With --pid the CPU time the bridge used
+    during the run is reported, to compare polling with subscribing.
+
+    --metrics reads /debug/metrics of the bridge before and after the run and
+    reports, for the light list polls, the time the handler took and the heap
+    it allocated (the churn, counted by the host build only) and kept.
+
+    loadtest [options]
+        --host ip         bridge address (127.0.0.1)
+        --port n          bridge HTTP port (80)
+        --ssdp-port n     bridge SSDP port (1900)
+        --echos n         number of emulated Echo devices (4)
+        --polls n         light list polls per second per Echo (2)
+        --puts n          state changes per second per Echo (1)
+        --searches n      M-SEARCH bursts per second per Echo (0.2)
+        --rooms n         whole room commands per second per Echo, each way (0)
+        --lights n        number of lights to send state changes to, and in the room (1)
+        --seconds n       length of the run (10)
+        --pid n           process id of a local bridge for the memory report
+        --keep-alive      reuse one connection per Echo
+        --pipeline n      GETs per light list poll, sent back to back (1)
+        --events n        event stream subscribers (0)
+        --metrics         report the handler time and heap per poll from /debug/metrics
+
+    loadtest --port 8080 --echos 8 --polls 5 --puts 2 --seconds 30 --pid $(pidof huebridge)
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+typedef enum {
+    SEARCH,
+    POLL,
+    PUT,
+    ROOM_LIGHTS,
+    ROOM_GROUP,
+    KINDS
+} RequestKind;
+
+static const char * kindNames[KINDS] = { "M-SEARCH", "GET lights", "PUT state", "room lights", "room group" };
+
+// bodies Alexa sends, see the tables above HueBridge::handle_PutState
+static const char * putBodies[] = {
+    "{\"on\":true}",
+    "{\"on\":false}",
+    "{\"on\":true,\"bri\":183}",
+    "{\"on\":true,\"bri\":128}",
+    "{\"on\":true,\"bri\":254}",
+    "{\"on\":true,\"ct\":383}",
+    "{\"on\":true,\"ct\":350}",
+    "{\"on\":true,\"ct\":284}",
+    "{\"on\":true,\"ct\":234}",
+    "{\"on\":true,\"ct\":199}",
+    "{\"on\":true, \"hue\" : 0, \"sat\" : 254 }",
+    "{\"on\":true, \"hue\" : 63351, \"sat\" : 231 }",
+    "{\"on\":true, \"hue\" : 3095, \"sat\" : 132 }",
+    "{\"on\":true, \"hue\" : 7100, \"sat\" : 254 }",
+    "{\"on\":true, \"hue\" : 9102, \"sat\" : 254 }",
+    "{\"on\":true, \"hue\" : 10923, \"sat\" : 254 }",
+    "{\"on\":true, \"hue\" : 21845, \"sat\" : 254 }",
+    "{\"on\":true ,\"hue\" : 31675, \"sat\" : 183 }",
+    "{\"on\":true ,\"hue\" : 32768, \"sat\" : 254 }",
+    "{\"on\":true, \"hue\" : 35862, \"sat\" : 107 }",
+    "{\"on\":true, \"hue\" : 43690, \"sat\" : 254 }",
+    "{\"on\":true, \"hue\" : 50426, \"sat\" : 219 }",
+    "{\"on\":true, \"hue\" : 54613, \"sat\" : 254 }",
+    "{\"on\":true, \"hue\" : 63351, \"sat\" : 64 }",
+    "{\"on\":true, \"hue\" : 46421, \"sat\" : 127 }",
+};
+
+static const char M_SEARCH[] =
+    "M-SEARCH * HTTP/1.1\r\n"
+    "HOST: 239.255.255.250:1900\r\n"
+    "ST: ssdp:all\r\n"
+    "MAN: \"ssdp:discover\"\r\n"
+    "MX: 1\r\n"
+    "\r\n";
+
+struct Options {
+    const char * host = "127.0.0.1";
+    int port = 80;
+    int ssdpPort = 1900;
+    int echos = 4;
+    double rates[KINDS] = { 0.2, 2, 1, 0, 0 };
+    int lights = 1;
+    int seconds = 10;
+    int pid = 0;
+    bool keepAlive = false;
+    int pipeline = 1;
+    int events = 0;
+    bool metrics = false;
+};
+
+struct Stats {
+    std::vector<double> latencies;     // microseconds
+    long errors = 0;
+};
+
+static Options options;
+static sockaddr_in httpAddr;
+static sockaddr_in ssdpAddr;
+static std::atomic<bool> running(true);
+static std::mutex statsLock;
+static Stats stats[KINDS];
+static std::atomic<long> connections(0);
+static std::atomic<long> connectUs(0);
+
+// the connection of the Echo thread with --keep-alive, -1 when there is none
+static thread_local int connection = -1;
+static thread_local std::string pending;   // bytes received past the last response
+
+static int openConnection()
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+
+    int enable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    timeval timeout = { 5, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    Clock::time_point begin = Clock::now();
+    if (connect(fd, (const sockaddr *)&httpAddr, sizeof(httpAddr)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    connectUs += (long)std::chrono::duration<double, std::micro>(Clock::now() - begin).count();
+    connections++;
+    pending.clear();
+    return fd;
+}
+
+// reads one response, its length is taken from Content-Length, returns the status
+static int readResponse(int fd, bool * closed)
+{
+    char buffer[4096];
+    size_t headerEnd;
+    while ((headerEnd = pending.find("\r\n\r\n")) == std::string::npos)
+    {
+        ssize_t len = recv(fd, buffer, sizeof(buffer), 0);
+        if (len <= 0)
+            return -1;
+        pending.append(buffer, len);
+    }
+    headerEnd += 4;
+
+    std::string headers = pending.substr(0, headerEnd);
+    for (char & c : headers)
+        c = tolower(c);
+    size_t field = headers.find("\r\ncontent-length:");
+    size_t length = headerEnd + (field != std::string::npos ? atol(headers.c_str() + field + 17) : 0);
+    *closed = headers.find("\r\nconnection: close") != std::string::npos;
+    while (pending.size() < length)
+    {
+        ssize_t len = recv(fd, buffer, sizeof(buffer), 0);
+        if (len <= 0)
+            return -1;
+        pending.append(buffer, len);
+    }
+
+    int status = headers.compare(0, 9, "http/1.1 ") == 0 ? atoi(headers.c_str() + 9) : -1;
+    pending.erase(0, length);
+    return status;
+}
+
+// sends count requests at once and returns the worst status, or -1 when one failed
+static int exchange(int fd, const std::string & request, int count, bool * closed)
+{
+    std::string data;
+    for (int i = 0; i < count; i++)
+        data += request;
+    if (send(fd, data.data(), data.size(), MSG_NOSIGNAL) != (ssize_t)data.size())
+        return -1;
+
+    int worst = 0;
+    for (int i = 0; i < count; i++)
+    {
+        int status = readResponse(fd, closed);
+        if (status < 0 || (*closed && i + 1 < count))
+            return -1;
+        worst = std::max(worst, status);
+    }
+    return worst;
+}
+
+// returns the http status code, or -1 when the request failed
+static int httpRequest(std::string request, int count = 1)
+{
+    bool closed = true;
+    if (!options.keepAlive)
+    {
+        request.insert(request.find("\r\n") + 2, "Connection: close\r\n");
+        int fd = openConnection();
+        int status = fd < 0 ? -1 : exchange(fd, request, count, &closed);
+        if (fd >= 0)
+            close(fd);
+        return status;
+    }
+
+    // a kept connection the bridge has closed meanwhile is opened again once
+    bool reused = connection >= 0;
+    if (connection < 0)
+        connection = openConnection();
+    int status = connection < 0 ? -1 : exchange(connection, request, count, &closed);
+    if (status < 0 && reused)
+    {
+        close(connection);
+        connection = openConnection();
+        status = connection < 0 ? -1 : exchange(connection, request, count, &closed);
+    }
+    if ((status < 0 || closed) && connection >= 0)
+    {
+        close(connection);
+        connection = -1;
+    }
+    return status;
+}
+
+// sends a burst of M-SEARCH packets like an Echo does, succeeds on the first reply
+static bool ssdpSearch()
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0)
+        return false;
+
+    timeval timeout = { 2, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    for (int i = 0; i < 3; i++)
+    {
+        sendto(fd, M_SEARCH, sizeof(M_SEARCH) - 1, 0, (const sockaddr *)&ssdpAddr, sizeof(ssdpAddr));
+    }
+
+    char buffer[1500];
+    ssize_t len = recv(fd, buffer, sizeof(buffer) - 1, 0);
+    close(fd);
+    return len > 0 && strncmp(buffer, "HTTP/1.1 200 OK", 15) == 0;
+}
+
+static bool putRequest(const char * path, int id, const char * body)
+{
+    char uri[64];
+    snprintf(uri, sizeof(uri), path, id);
+    char line[128];
+    snprintf(line, sizeof(line), "PUT %s HTTP/1.1\r\nContent-Length: %d\r\n", uri, (int)strlen(body));
+    int status = httpRequest(std::string(line) + "Host: " + options.host + "\r\nContent-Type: application/json\r\n\r\n" + body);
+    return status >= 200 && status < 400;
+}
+
+static bool runRequest(RequestKind kind, unsigned int seq)
+{
+    if (kind == SEARCH)
+    {
+        return ssdpSearch();
+    }
+
+    if (kind == POLL)
+    {
+        int status = httpRequest(std::string("GET /api/userid/lights HTTP/1.1\r\nHost: ") + options.host + "\r\n\r\n", options.pipeline);
+        return status >= 200 && status < 400;
+    }
+
+    const char * body = putBodies[seq % (sizeof(putBodies) / sizeof(putBodies[0]))];
+    if (kind == PUT)
+    {
+        return putRequest("/api/userid/lights/%d/state", (int)(seq % options.lights) + 1, body);
+    }
+    if (kind == ROOM_GROUP)
+    {
+        return putRequest("/api/userid/groups/%d/action", 0, body);
+    }
+
+    // the same room command as one request per light
+    for (int light = 1; light <= options.lights; light++)
+    {
+        if (!putRequest("/api/userid/lights/%d/state", light, body))
+            return false;
+    }
+    return true;
+}
+
+static void echo(int index)
+{
+    Stats local[KINDS];
+    Clock::time_point start = Clock::now();
+    Clock::time_point next[KINDS];
+    std::chrono::microseconds interval[KINDS];
+    unsigned int seq[KINDS] = { 0 };
+
+    for (int k = 0; k < KINDS; k++)
+    {
+        interval[k] = std::chrono::microseconds(options.rates[k] > 0 ? (long)(1000000 / options.rates[k]) : 0);
+        // spread the Echos over the first interval so they do not fire in lock step
+        next[k] = start + interval[k] * index / options.echos;
+    }
+
+    while (running)
+    {
+        int kind = -1;
+        for (int k = 0; k < KINDS; k++)
+        {
+            if (interval[k].count() > 0 && (kind < 0 || next[k] < next[kind]))
+                kind = k;
+        }
+        if (kind < 0)
+            break;
+
+        std::this_thread::sleep_until(next[kind]);
+        if (!running)
+            break;
+
+        Clock::time_point begin = Clock::now();
+        bool ok = runRequest((RequestKind)kind, seq[kind]++ + index);
+        double us = std::chrono::duration<double, std::micro>(Clock::now() - begin).count();
+        if (ok)
+            local[kind].latencies.push_back(us);
+        else
+            local[kind].errors++;
+
+        // fixed rate schedule, a late request does not shift the ones after it
+        next[kind] += interval[kind];
+        if (next[kind] < Clock::now())
+            next[kind] = Clock::now();
+    }
+
+    if (connection >= 0)
+    {
+        close(connection);
+        connection = -1;
+    }
+
+    std::lock_guard<std::mutex> lock(statsLock);
+    for (int k = 0; k < KINDS; k++)
+    {
+        stats[k].latencies.insert(stats[k].latencies.end(), local[k].latencies.begin(), local[k].latencies.end());
+        stats[k].errors += local[k].errors;
+    }
+}
+
+// follows GET /eventstream until the run ends, counts the events and bytes received
+static void subscriber(long * events, long * bytes)
+{
+    int fd = openConnection();
+    if (fd < 0)
+        return;
+    timeval timeout = { 0, 200000 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    std::string request = std::string("GET /eventstream HTTP/1.1\r\nHost: ") + options.host + "\r\n\r\n";
+    send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+
+    char buffer[4096];
+    std::string stream;
+    while (running)
+    {
+        ssize_t len = recv(fd, buffer, sizeof(buffer), 0);
+        if (len == 0 || (len < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+            break;
+        if (len < 0)
+            continue;
+        *bytes += len;
+        stream.append(buffer, len);
+        size_t end;
+        while ((end = stream.find("\n\n")) != std::string::npos)
+        {
+            if (stream.find("data: ") < end)
+                (*events)++;
+            stream.erase(0, end + 2);
+        }
+    }
+    close(fd);
+}
+
+// body of GET /debug/metrics on a connection of its own, empty when it failed
+static std::string fetchMetrics()
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return "";
+    timeval timeout = { 5, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    std::string request = std::string("GET /debug/metrics HTTP/1.1\r\nHost: ") + options.host + "\r\nConnection: close\r\n\r\n";
+    std::string response;
+    if (connect(fd, (const sockaddr *)&httpAddr, sizeof(httpAddr)) == 0
+        && send(fd, request.data(), request.size(), MSG_NOSIGNAL) == (ssize_t)request.size())
+    {
+        char buffer[4096];
+        ssize_t len;
+        while ((len = recv(fd, buffer, sizeof(buffer), 0)) > 0)
+            response.append(buffer, len);
+    }
+    close(fd);
+    size_t body = response.find("\r\n\r\n");
+    return body != std::string::npos ? response.substr(body + 4) : "";
+}
+
+// number after "field": in the entry of route in the metrics, 0 when it is not there
+static double routeField(const std::string & json, const char * route, const char * field)
+{
+    std::string name = std::string("\"route\":\"") + route + "\"";
+    size_t entry = json.find(name);
+    if (entry == std::string::npos)
+        return 0;
+    entry += name.size();   // the name has braces of its own
+    size_t end = json.find('}', entry);
+    size_t at = json.find(std::string("\"") + field + "\":", entry);
+    return at < end ? atof(json.c_str() + at + strlen(field) + 3) : 0;
+}
+
+// user and system time of a local process in clock ticks, from /proc/<pid>/stat
+static long cpuTicks(int pid)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    FILE * file = fopen(path, "r");
+    if (file == NULL)
+        return -1;
+    char line[1024];
+    long ticks = -1;
+    if (fgets(line, sizeof(line), file))
+    {
+        // fields 14 and 15, counted after the command name in parentheses
+        const char * p = strrchr(line, ')');
+        unsigned long utime, stime;
+        if (p != NULL && sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime) == 2)
+            ticks = utime + stime;
+    }
+    fclose(file);
+    return ticks;
+}
+
+static double percentile(const std::vector<double> & sorted, double p)
+{
+    if (sorted.empty())
+        return 0;
+    size_t index = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+// peak resident memory of a local process in kB, from /proc/<pid>/status
+static long memoryHighWater(int pid)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/status", pid);
+    FILE * file = fopen(path, "r");
+    if (file == NULL)
+        return -1;
+
+    char line[256];
+    long kb = -1;
+    while (fgets(line, sizeof(line), file))
+    {
+        if (strncmp(line, "VmHWM:", 6) == 0)
+            kb = atol(line + 6);
+    }
+    fclose(file);
+    return kb;
+}
+
+static void usage(const char * name)
+{
+    fprintf(stderr, "usage: %s [--host ip] [--port n] [--ssdp-port n] [--echos n] [--polls n] [--puts n]\n"
+                    "          [--searches n] [--rooms n] [--lights n] [--seconds n] [--pid n] [--keep-alive] [--pipeline n] [--events n]\n"
+                    "          [--metrics]\n", name);
+}
+
+int main(int argc, char ** argv)
+{
+    static const struct option longOptions[] = {
+        { "host",      required_argument, NULL, 'h' },
+        { "port",      required_argument, NULL, 'p' },
+        { "ssdp-port", required_argument, NULL, 'u' },
+        { "echos",     required_argument, NULL, 'e' },
+        { "polls",     required_argument, NULL, 'g' },
+        { "puts",      required_argument, NULL, 's' },
+        { "searches",  required_argument, NULL, 'm' },
+        { "rooms",     required_argument, NULL, 'r' },
+        { "lights",    required_argument, NULL, 'l' },
+        { "seconds",   required_argument, NULL, 't' },
+        { "pid",       required_argument, NULL, 'P' },
+        { "keep-alive", no_argument,      NULL, 'k' },
+        { "pipeline",  required_argument, NULL, 'n' },
+        { "events",    required_argument, NULL, 'E' },
+        { "metrics",   no_argument,       NULL, 'M' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", longOptions, NULL)) != -1)
+    {
+        switch (opt)
+        {
+            case 'h': options.host = optarg; break;
+            case 'p': options.port = atoi(optarg); break;
+            case 'u': options.ssdpPort = atoi(optarg); break;
+            case 'e': options.echos = std::max(1, atoi(optarg)); break;
+            case 'g': options.rates[POLL] = atof(optarg); break;
+            case 's': options.rates[PUT] = atof(optarg); break;
+            case 'm': options.rates[SEARCH] = atof(optarg); break;
+            case 'r': options.rates[ROOM_LIGHTS] = options.rates[ROOM_GROUP] = atof(optarg); break;
+            case 'l': options.lights = std::max(1, atoi(optarg)); break;
+            case 't': options.seconds = std::max(1, atoi(optarg)); break;
+            case 'P': options.pid = atoi(optarg); break;
+            case 'k': options.keepAlive = true; break;
+            case 'n': options.pipeline = std::max(1, atoi(optarg)); break;
+            case 'E': options.events = std::max(0, atoi(optarg)); break;
+            case 'M': options.metrics = true; break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+
+    memset(&httpAddr, 0, sizeof(httpAddr));
+    httpAddr.sin_family = AF_INET;
+    httpAddr.sin_port = htons(options.port);
+    if (inet_pton(AF_INET, options.host, &httpAddr.sin_addr) != 1)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+    ssdpAddr = httpAddr;
+    ssdpAddr.sin_port = htons(options.ssdpPort);
+
+    std::vector<long> eventCounts(options.events), eventBytes(options.events);
+    std::vector<std::thread> subscribers;
+    for (int i = 0; i < options.events; i++)
+    {
+        subscribers.push_back(std::thread(subscriber, &eventCounts[i], &eventBytes[i]));
+    }
+    // the streams are open before the first change
+    std::this_thread::sleep_for(std::chrono::milliseconds(options.events > 0 ? 300 : 0));
+
+    std::string metricsBefore = options.metrics ? fetchMetrics() : "";
+    long ticks = options.pid > 0 ? cpuTicks(options.pid) : -1;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < options.echos; i++)
+    {
+        threads.push_back(std::thread(echo, i));
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(options.seconds));
+    running = false;
+    for (auto & t : threads)
+    {
+        t.join();
+    }
+    if (ticks >= 0)
+    {
+        ticks = cpuTicks(options.pid) - ticks;
+    }
+    for (auto & t : subscribers)
+    {
+        t.join();
+    }
+
+    printf("%d Echos for %d s against %s:%d\n\n", options.echos, options.seconds, options.host, options.port);
+    printf("%-12s %9s %8s %7s %9s %9s %9s %9s\n", "request", "count", "req/s", "errors", "p50 us", "p90 us", "p99 us", "max us");
+    for (int k = 0; k < KINDS; k++)
+    {
+        std::vector<double> & l = stats[k].latencies;
+        std::sort(l.begin(), l.end());
+        long total = l.size() + stats[k].errors;
+        printf("%-12s %9ld %8.1f %6.2f%% %9.0f %9.0f %9.0f %9.0f\n", kindNames[k], total, total / (double)options.seconds,
+            total > 0 ? 100.0 * stats[k].errors / total : 0.0,
+            percentile(l, 50), percentile(l, 90), percentile(l, 99), l.empty() ? 0 : l.back());
+    }
+
+    long http = 0;
+    for (int k = POLL; k < KINDS; k++)
+    {
+        http += stats[k].latencies.size() + stats[k].errors;
+    }
+    http += (long)(stats[POLL].latencies.size() + stats[POLL].errors) * (options.pipeline - 1);
+    printf("\n%ld connections for %ld HTTP requests (%.1f per connection), connect %.0f us on average\n",
+        connections.load(), http, connections > 0 ? (double)http / connections : 0.0, connections > 0 ? (double)connectUs / connections : 0.0);
+
+    if (options.events > 0)
+    {
+        long least = *std::min_element(eventCounts.begin(), eventCounts.end());
+        long most = *std::max_element(eventCounts.begin(), eventCounts.end());
+        long bytes = 0;
+        for (long b : eventBytes)
+            bytes += b;
+        printf("%d event streams received %ld to %ld events, %ld bytes in all\n", options.events, least, most, bytes);
+    }
+
+    if (options.metrics)
+    {
+        // the handler time and heap of the polls as the bridge measured them
+        static const char * route = "GET /api/{}/lights";
+        std::string after = fetchMetrics();
+        double before = routeField(metricsBefore, route, "count");
+        double polls = routeField(after, route, "count") - before;
+        double us = routeField(after, route, "avg_us") * (polls + before) - routeField(metricsBefore, route, "avg_us") * before;
+        double allocated = routeField(after, route, "allocated") - routeField(metricsBefore, route, "allocated");
+        double growth = routeField(after, route, "heap_delta") - routeField(metricsBefore, route, "heap_delta");
+        if (after.empty() || polls <= 0)
+            printf("\nno light list polls in the bridge metrics\n");
+        else
+            printf("\nbridge, per poll: handler %.0f us, %.0f bytes allocated, heap growth %.0f bytes\n",
+                us / polls, allocated / polls, growth / polls);
+    }
+
+    if (options.pid > 0)
+    {
+        printf("\nbridge memory high-water mark: %ld kB\n", memoryHighWater(options.pid));
+        printf("bridge CPU time: %.2f s\n", ticks / (double)sysconf(_SC_CLK_TCK));
+    }
+    return 0;
+}
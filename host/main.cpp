@@ -0,0 +1,167 @@
+/*
+    Linux daemon running the same HueBridge and UPnP code as the ESP32 sketch.
+
+    huebridge [-p port] [-a] [-t] [-r] [-j journal] [-k ms] [-b baud] [light name]...
+
+    huebridge -p 8080 "nuclear reactor" "desk lamp"
+
+    With -a state changes are printed by the batched callback on its worker
+    thread (onStateChanges) instead of from the request handler (onSetState),
+    together with the RGB value of the color (hueColorRgb).
+
+    With -t the bridge is served from its own thread (startTask) and the main
+    thread only waits. Adding -r makes the main thread ramp the brightness of
+    every light and read it back meanwhile, like sketch code on the other core
+    would, which is the load to run under ThreadSanitizer.
+
+    With -j the lights and their state are kept in the journal file and
+    restored when the daemon is started again (persistState).
+
+    -k sets how many ms an idle HTTP connection is kept open, 0 closes every
+    connection after its response.
+
+    -b paces everything written to the serial port to that baud rate, so that
+    logging costs the handlers what it costs them on the UART of the ESP32.
+
+    Alexa only talks to bridges on port 80, use the default port (or a port
+    redirect) when the daemon should be discovered by an Echo. The MAC and IP
+    address that are announced can be set with the HUE_MAC and HUE_IP
+    environment variables.
+*/
+#include <signal.h>
+#include <unistd.h>
+#include "HueBridge.h"
+
+static volatile sig_atomic_t running = 1;
+
+static void onSignal(int)
+{
+    running = 0;
+}
+
+int main(int argc, char ** argv)
+{
+    unsigned int port = UPnP_TCP_PORT;
+    bool batched = false;
+    bool threaded = false;
+    bool ramp = false;
+    const char * journal = NULL;
+    long keepAlive = -1;
+    unsigned long baud = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:atrj:k:b:")) != -1)
+    {
+        if (opt == 'p')
+        {
+            port = atoi(optarg);
+        }
+        else if (opt == 'a')
+        {
+            batched = true;
+        }
+        else if (opt == 't')
+        {
+            threaded = true;
+        }
+        else if (opt == 'r')
+        {
+            ramp = true;
+        }
+        else if (opt == 'j')
+        {
+            journal = optarg;
+        }
+        else if (opt == 'k')
+        {
+            keepAlive = atol(optarg);
+        }
+        else if (opt == 'b')
+        {
+            baud = strtoul(optarg, NULL, 10);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-p port] [-a] [-t] [-r] [-j journal] [-k ms] [-b baud] [light name]...\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (baud > 0)
+    {
+        Serial.begin(baud);
+    }
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    signal(SIGPIPE, SIG_IGN);
+
+    HueBridge * hueBridge = new HueBridge(port);
+    if (keepAlive >= 0)
+    {
+        hueBridge->setKeepAlive(keepAlive);
+    }
+    if (journal != NULL)
+    {
+        hueBridge->persistState(journal);
+    }
+    if (optind == argc)
+    {
+        hueBridge->addDevice("nuclear reactor");
+    }
+    for (int i = optind; i < argc; i++)
+    {
+        hueBridge->addDevice(argv[i]);
+    }
+
+    if (batched)
+    {
+        hueBridge->onStateChanges([](const device_change_t * changes, size_t count) {
+            for (size_t i = 0; i < count; i++)
+            {
+                const device_t & device = changes[i].device;
+                hue_rgbw_t rgb;
+                hueColorRgb(device, &rgb);
+                Serial.printf("handle_StateChanges %d/%d id: %d, state: %s, bri: %d, ct: %d, hue: %d, sat: %d, xy: %d,%d, mode: %c, rgb: %d,%d,%d\n",
+                    (int)i + 1, (int)count, changes[i].id, device.state ? "true" : "false", device.bri, device.ct, device.hue, device.sat,
+                    device.x, device.y, device.mode, rgb.r, rgb.g, rgb.b);
+            }
+        });
+    }
+    else
+    {
+        hueBridge->onSetState([](unsigned char id, bool state, unsigned char bri, short ct, unsigned int hue, unsigned char sat, char mode) {
+            Serial.printf("handle_SetState id: %d, state: %s, bri: %d, ct: %d, hue: %d, sat: %d, mode: %c\n",
+                id, state ? "true" : "false", bri, ct, hue, sat, mode);
+        });
+    }
+    if (threaded)
+    {
+        hueBridge->startTask();
+    }
+    else
+    {
+        hueBridge->start();
+    }
+    Serial.printf("Hue bridge listening on %s:%u\n", WiFi.localIP().toString().c_str(), port);
+
+    unsigned int step = 0;
+    while (running)
+    {
+        if (!threaded)
+        {
+            hueBridge->handle();
+        }
+        else if (ramp)
+        {
+            unsigned char id = step % (argc - optind > 0 ? argc - optind : 1);
+            hueBridge->setState(id, true, 1 + step % 254, 0, 0, 0, 'h');
+            device_t device;
+            hueBridge->getState(id, &device);
+            step++;
+        }
+        usleep(1000);
+    }
+
+    hueBridge->stop();
+    delete hueBridge;
+    return 0;
+}
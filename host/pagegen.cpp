@@ -0,0 +1,180 @@
+/*
+    Compresses the web pages in resouces/ into HuePages.h, the flash arrays
+    the bridge serves with Content-Encoding: gzip. Run it again whenever a
+    page changes, the Arduino IDE only sees the generated header.
+
+    pagegen resouces/index.html resouces/clip.html > HuePages.h
+
+    A page is named after its file, index.html becomes INDEX_PAGE, with its
+    length before compression in INDEX_PAGE_SIZE and a strong ETag, the
+    CRC-32 of the compressed bytes, in INDEX_PAGE_ETAG. The gzip header has
+    no time stamp or name, so the same page always gives the same bytes.
+
+    g++ -O2 -std=c++11 host/pagegen.cpp -lz -o pagegen
+
+    Built with -DPAGE_CHECK it checks HuePages.h against the sources instead:
+    every page is inflated and compared with its file, its ETag recomputed,
+    and the file compressed again to see that the header is up to date.
+
+    g++ -O2 -std=c++11 -DPAGE_CHECK -Ihost -I. host/pagegen.cpp -lz -o pagecheck
+    ./pagecheck resouces
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+static bool readFile(const char * path, std::string * content)
+{
+    FILE * file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return false;
+    }
+    char buffer[4096];
+    size_t length;
+    while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        content->append(buffer, length);
+    }
+    fclose(file);
+    return true;
+}
+
+// gzip with the best compression and a header without time stamp
+static std::vector<unsigned char> compress(const std::string & content)
+{
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY);
+    std::vector<unsigned char> out(deflateBound(&stream, content.size()) + 32);
+    stream.next_in = (Bytef *)content.data();
+    stream.avail_in = content.size();
+    stream.next_out = out.data();
+    stream.avail_out = out.size();
+    deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    return out;
+}
+
+static unsigned long etag(const unsigned char * data, size_t length)
+{
+    return crc32(crc32(0, NULL, 0), data, length);
+}
+
+#ifdef PAGE_CHECK
+
+#include <Arduino.h>
+#include "HuePages.h"
+
+static std::string inflate(const unsigned char * data, size_t length)
+{
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    inflateInit2(&stream, 15 + 16);
+    std::string out;
+    unsigned char buffer[4096];
+    stream.next_in = (Bytef *)data;
+    stream.avail_in = length;
+    int result;
+    do
+    {
+        stream.next_out = buffer;
+        stream.avail_out = sizeof(buffer);
+        result = ::inflate(&stream, Z_NO_FLUSH);
+        out.append((const char *)buffer, sizeof(buffer) - stream.avail_out);
+    }
+    while (result == Z_OK);
+    inflateEnd(&stream);
+    return result == Z_STREAM_END ? out : std::string();
+}
+
+static bool check(const char * directory, const char * file, const unsigned char * data, size_t length, size_t size, const char * tag)
+{
+    std::string path = std::string(directory) + "/" + file;
+    std::string source;
+    if (!readFile(path.c_str(), &source))
+    {
+        printf("%-12s cannot read %s\n", file, path.c_str());
+        return false;
+    }
+
+    char expected[16];
+    snprintf(expected, sizeof(expected), "\"%08lx\"", etag(data, length));
+    bool inflated = inflate(data, length) == source;
+    bool tagged = strcmp(tag, expected) == 0 && size == source.size();
+    bool current = compress(source) == std::vector<unsigned char>(data, data + length);
+    printf("%-12s %5u -> %5u bytes (%3u%%)  inflated %s  etag %s  header %s\n", file, (unsigned int)source.size(), (unsigned int)length,
+        (unsigned int)(length * 100 / (source.size() > 0 ? source.size() : 1)),
+        inflated ? "ok" : "DIFFERS", tagged ? "ok" : "WRONG", current ? "ok" : "OUTDATED");
+    return inflated && tagged && current;
+}
+
+int main(int argc, char ** argv)
+{
+    const char * directory = argc > 1 ? argv[1] : "resouces";
+    bool ok = true;
+#define CHECK_PAGE(name, file) ok = check(directory, file, name, sizeof(name), name ## _SIZE, name ## _ETAG) && ok;
+    HUE_PAGES(CHECK_PAGE)
+    return ok ? 0 : 1;
+}
+
+#else
+
+int main(int argc, char ** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s page... > HuePages.h\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<std::string> names, files;
+    printf("#pragma once\n\n");
+    printf("// Generated by host/pagegen.cpp from resouces/, do not edit\n\n");
+    for (int i = 1; i < argc; i++)
+    {
+        std::string content;
+        if (!readFile(argv[i], &content))
+        {
+            fprintf(stderr, "cannot read %s\n", argv[i]);
+            return 1;
+        }
+
+        // index.html -> INDEX_PAGE
+        const char * file = strrchr(argv[i], '/') != NULL ? strrchr(argv[i], '/') + 1 : argv[i];
+        std::string name;
+        for (const char * p = file; *p != 0 && *p != '.'; p++)
+        {
+            name += isalnum((unsigned char)*p) ? (char)toupper((unsigned char)*p) : '_';
+        }
+        name += "_PAGE";
+        names.push_back(name);
+        files.push_back(file);
+
+        std::vector<unsigned char> gz = compress(content);
+        printf("#define %s_SIZE %u\n", name.c_str(), (unsigned int)content.size());
+        printf("PROGMEM const char %s_ETAG[] = \"\\\"%08lx\\\"\";\n", name.c_str(), etag(gz.data(), gz.size()));
+        printf("PROGMEM const unsigned char %s[] = {", name.c_str());
+        for (size_t n = 0; n < gz.size(); n++)
+        {
+            printf("%s0x%02x%s", n % 16 == 0 ? "\n    " : "", gz[n], n + 1 < gz.size() ? (n % 16 == 15 ? "," : ", ") : "\n");
+        }
+        printf("};\n\n");
+    }
+
+    // X(name, file) for every page
+    printf("#define HUE_PAGES(X)");
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        printf(" \\\n    X(%s, \"%s\")", names[i].c_str(), files[i].c_str());
+    }
+    printf("\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,149 @@
+/*
+    Compares the cost of finding the handler of a request and the light id in
+    its path, for the Hue API paths an Echo and the apps request:
+
+      - pattern scan: the way the routes used to be registered with the web
+        server, every {} pattern is matched in turn and the handler then takes
+        the uri apart with indexOf, substring and toInt
+      - hueRoute: the path is split once and dispatched with a switch
+
+    routebench [-n iterations]
+
+    g++ -O2 -std=c++11 -Ihost -I. host/routebench.cpp HueRouter.cpp -o routebench
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <chrono>
+#include "WString.h"
+#include "HueRouter.h"
+
+typedef struct {
+    HTTPMethod method;
+    const char * uri;
+} request_t;
+
+static const request_t requests[] = {
+    { HTTP_GET, "/api/userid/lights" },
+    { HTTP_GET, "/api/userid/lights/1" },
+    { HTTP_PUT, "/api/userid/lights/1/state" },
+    { HTTP_GET, "/api/userid/lights" },
+    { HTTP_POST, "/api" },
+    { HTTP_GET, "/api/userid/config" },
+    { HTTP_GET, "/favicon.ico" },
+};
+
+// the route table as it was registered in HueBridge::start
+static const request_t patterns[] = {
+    { HTTP_GET, "/description.xml" },
+    { HTTP_POST, "/api" },
+    { HTTP_GET, "/api/{}/lights" },
+    { HTTP_GET, "/api/{}/lights/{}" },
+    { HTTP_PUT, "/api/{}/lights/{}/state" },
+    { HTTP_GET, "/" },
+    { HTTP_GET, "/debug/clip.html" },
+};
+
+// HueHttpServer::uriMatches
+static bool uriMatches(const char * pattern, const char * uri)
+{
+    while (*pattern && *uri)
+    {
+        if (pattern[0] == '{' && pattern[1] == '}')
+        {
+            if (*uri == '/')
+            {
+                return false;
+            }
+            while (*uri && *uri != '/')
+            {
+                uri++;
+            }
+            pattern += 2;
+        }
+        else if (*pattern++ != *uri++)
+        {
+            return false;
+        }
+    }
+    return *pattern == 0 && *uri == 0;
+}
+
+static int scanRoute(const request_t & request, int * id)
+{
+    String uri = request.uri;
+    for (size_t i = 0; i < sizeof(patterns) / sizeof(patterns[0]); i++)
+    {
+        if (patterns[i].method == request.method && uriMatches(patterns[i].uri, uri.c_str()))
+        {
+            *id = 0;
+            int pos = uri.indexOf("lights");
+            if (pos >= 0)
+            {
+                *id = uri.substring(pos + 7).toInt();
+            }
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+static int tableRoute(const request_t & request, int * id)
+{
+    hue_path_t path;
+    int route = hueRoute(request.method, request.uri, &path);
+    *id = path.id;
+    return route;
+}
+
+template <typename F>
+static double measure(F route, long iterations)
+{
+    const size_t count = sizeof(requests) / sizeof(requests[0]);
+    unsigned long sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long n = 0; n < iterations; n++)
+    {
+        int id;
+        sink += route(requests[n % count], &id) + id;
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    if (sink == 42)
+    {
+        printf("\n");   // keeps the loop from being optimized away
+    }
+    return iterations > 0 ? ns / iterations : 0.0;
+}
+
+int main(int argc, char ** argv)
+{
+    long iterations = 2000000;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1)
+    {
+        if (opt == 'n')
+        {
+            iterations = atol(optarg);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-n iterations]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    for (size_t i = 0; i < sizeof(requests) / sizeof(requests[0]); i++)
+    {
+        int scanId, tableId;
+        int scan = scanRoute(requests[i], &scanId);
+        int table = tableRoute(requests[i], &tableId);
+        printf("%-8s %-28s pattern %d id %d   hueRoute %d id %d\n",
+            requests[i].method == HTTP_GET ? "GET" : requests[i].method == HTTP_PUT ? "PUT" : "POST",
+            requests[i].uri, scan, scanId, table, tableId);
+    }
+
+    double scan = measure(scanRoute, iterations);
+    double table = measure(tableRoute, iterations);
+    printf("\npattern scan %.1f ns, hueRoute %.1f ns per request (%ld requests)\n", scan, table, iterations);
+    return 0;
+}
@@ -0,0 +1,249 @@
+/*
+    Runs SsdpRequest over a corpus of SSDP packets. Every packet is parsed
+    once and its method, MAN, MX, ST and the target the bridge matched are
+    printed, then the whole corpus is parsed in a loop and the time per packet
+    is reported. Before that the replies each search target gets are checked,
+    ssdp:all has to get all three (rootdevice, uuid and basic:1), and it
+    exits with 1 when they are wrong.
+
+    Without arguments a built-in corpus is used: the searches an Echo sends,
+    searches for other devices, NOTIFY packets and malformed input. Packet
+    files (one raw datagram per file) can be given on the command line.
+
+    ssdpbench [-n iterations] [packet file]...
+
+    With -l it listens on the SSDP multicast group instead and prints every
+    packet it receives, which shows the NOTIFY announcements of the bridge:
+
+    ssdpbench -l [interface ip]
+
+    g++ -O2 -std=c++11 -I. host/ssdpbench.cpp SsdpRequest.cpp -o ssdpbench
+
+    Built with -DSSDP_FUZZ the file is a libFuzzer target instead:
+
+    clang++ -g -O1 -fsanitize=fuzzer,address -DSSDP_FUZZ -I. host/ssdpbench.cpp SsdpRequest.cpp -o ssdpfuzz
+    ./ssdpfuzz corpus/
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "SsdpRequest.h"
+
+static const char * bridgeId = "f008d1d2cb4c";
+
+#ifdef SSDP_FUZZ
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t * data, size_t size)
+{
+    // copied so that reads past the end of the datagram are caught
+    std::vector<char> packet(data, data + size);
+    SsdpRequest request;
+    if (request.parse(packet.data(), packet.size()))
+    {
+        request.target(bridgeId);
+    }
+    return 0;
+}
+
+#else
+
+static const char * corpus[] = {
+    // Echo
+    "M-SEARCH * HTTP/1.1\r\nHOST: 239.255.255.250:1900\r\nST: ssdp:all\r\nMAN: \"ssdp:discover\"\r\nMX: 3\r\n\r\n",
+    "M-SEARCH * HTTP/1.1\r\nHOST: 239.255.255.250:1900\r\nMAN: \"ssdp:discover\"\r\nMX: 15\r\nST: urn:schemas-upnp-org:device:basic:1\r\n\r\n",
+    "M-SEARCH * HTTP/1.1\r\nHOST: 239.255.255.250:1900\r\nMAN: \"ssdp:discover\"\r\nMX: 2\r\nST: upnp:rootdevice\r\n\r\n",
+    // unicast search for the bridge itself, no MX
+    "M-SEARCH * HTTP/1.1\r\nHOST: 192.168.1.20:1900\r\nMAN: \"ssdp:discover\"\r\nST: uuid:2f402f80-da50-11e1-9b23-F008D1D2CB4C\r\n\r\n",
+    // header names and method in other cases, LF line ends
+    "m-search * HTTP/1.1\nhost: 239.255.255.250:1900\nst:ssdp:all\nman:\"ssdp:discover\"\nmx:1\n\n",
+    // searches for devices the bridge is not
+    "M-SEARCH * HTTP/1.1\r\nHOST: 239.255.255.250:1900\r\nMAN: \"ssdp:discover\"\r\nMX: 1\r\nST: urn:dial-multiscreen-org:service:dial:1\r\n\r\n",
+    "M-SEARCH * HTTP/1.1\r\nHOST: 239.255.255.250:1900\r\nMAN: \"ssdp:discover\"\r\nMX: 1\r\nST: urn:Belkin:device:**\r\n\r\n",
+    "M-SEARCH * HTTP/1.1\r\nHOST: 239.255.255.250:1900\r\nMAN: \"ssdp:discover\"\r\nMX: 1\r\nST: uuid:2f402f80-da50-11e1-9b23-000000000000\r\n\r\n",
+    // no MAN
+    "M-SEARCH * HTTP/1.1\r\nHOST: 239.255.255.250:1900\r\nST: ssdp:all\r\nMX: 3\r\n\r\n",
+    // announcement of another device
+    "NOTIFY * HTTP/1.1\r\nHOST: 239.255.255.250:1900\r\nCACHE-CONTROL: max-age=1800\r\nLOCATION: http://192.168.1.2:49152/desc.xml\r\nNT: upnp:rootdevice\r\nNTS: ssdp:alive\r\nUSN: uuid:1234::upnp:rootdevice\r\n\r\n",
+    // malformed
+    "M-SEARCH HTTP/1.1\r\nST: ssdp:all\r\n\r\n",
+    "HTTP/1.1 200 OK\r\nST: ssdp:all\r\n\r\n",
+    "M-SEARCH * HTTP/1.1\r\nMAN: \"ssdp:discover\"\r\nMX: 3x\r\nST: ssdp:all",
+    "",
+};
+
+static const char * methodNames[] = { "unknown", "M-SEARCH", "NOTIFY" };
+static const char * targetNames[] = { "-", "ssdp:all", "upnp:rootdevice", "device:basic:1", "uuid" };
+
+// the replies UPnP sends for each target, false when one is wrong
+static bool checkReplies()
+{
+    static const struct {
+        const char * st;
+        uint8_t replies;
+    } cases[] = {
+        { "ssdp:all", SSDP_REPLY_ROOT_DEVICE | SSDP_REPLY_UUID | SSDP_REPLY_BASIC_DEVICE },
+        { "upnp:rootdevice", SSDP_REPLY_ROOT_DEVICE },
+        { "uuid:2f402f80-da50-11e1-9b23-f008d1d2cb4c", SSDP_REPLY_UUID },
+        { "urn:schemas-upnp-org:device:basic:1", SSDP_REPLY_BASIC_DEVICE },
+        { "urn:Belkin:device:**", 0 },
+    };
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        char packet[256];
+        int length = snprintf(packet, sizeof(packet),
+            "M-SEARCH * HTTP/1.1\r\nHOST: 239.255.255.250:1900\r\nMAN: \"ssdp:discover\"\r\nMX: 3\r\nST: %s\r\n\r\n", cases[i].st);
+        SsdpRequest request;
+        request.parse(packet, length);
+        uint8_t replies = SsdpRequest::replies(request.target(bridgeId));
+        printf("%-42s replies%s%s%s%s\n", cases[i].st,
+            replies & SSDP_REPLY_ROOT_DEVICE ? " rootdevice" : "", replies & SSDP_REPLY_UUID ? " uuid" : "",
+            replies & SSDP_REPLY_BASIC_DEVICE ? " basic:1" : "", replies != cases[i].replies ? "  WRONG" : "");
+        ok &= replies == cases[i].replies;
+    }
+    printf("\n");
+    return ok;
+}
+
+static int listen(const char * interfaceIP)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    int enable = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(1900);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        perror("bind");
+        return 1;
+    }
+
+    struct ip_mreq group;
+    group.imr_multiaddr.s_addr = inet_addr("239.255.255.250");
+    group.imr_interface.s_addr = interfaceIP ? inet_addr(interfaceIP) : htonl(INADDR_ANY);
+    if (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &group, sizeof(group)) < 0)
+    {
+        perror("IP_ADD_MEMBERSHIP");
+        return 1;
+    }
+
+    char packet[1500];
+    while (true)
+    {
+        socklen_t len = sizeof(addr);
+        int received = recvfrom(fd, packet, sizeof(packet), 0, (struct sockaddr *)&addr, &len);
+        if (received < 0)
+        {
+            perror("recvfrom");
+            return 1;
+        }
+        SsdpRequest request;
+        request.parse(packet, received);
+        printf("-- %s from %s:%d\n%.*s", methodNames[request.method()], inet_ntoa(addr.sin_addr), ntohs(addr.sin_port), received, packet);
+        fflush(stdout);
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    long iterations = 1000000;
+    bool listening = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:l")) != -1)
+    {
+        if (opt == 'n')
+        {
+            iterations = atol(optarg);
+        }
+        else if (opt == 'l')
+        {
+            listening = true;
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-n iterations] [packet file]...\n       %s -l [interface ip]\n", argv[0], argv[0]);
+            return 1;
+        }
+    }
+    if (listening)
+    {
+        return listen(optind < argc ? argv[optind] : NULL);
+    }
+
+    std::vector<std::string> packets;
+    for (int i = optind; i < argc; i++)
+    {
+        FILE * file = fopen(argv[i], "rb");
+        if (file == NULL)
+        {
+            perror(argv[i]);
+            return 1;
+        }
+        std::string packet;
+        char buffer[1500];
+        size_t len;
+        while ((len = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        {
+            packet.append(buffer, len);
+        }
+        fclose(file);
+        packets.push_back(packet);
+    }
+    if (packets.empty())
+    {
+        for (size_t i = 0; i < sizeof(corpus) / sizeof(corpus[0]); i++)
+        {
+            packets.push_back(corpus[i]);
+        }
+    }
+
+    if (!checkReplies())
+    {
+        return 1;
+    }
+
+    int answered = 0;
+    for (size_t i = 0; i < packets.size(); i++)
+    {
+        SsdpRequest request;
+        bool valid = request.parse(packets[i].data(), packets[i].size());
+        SsdpRequest::Target target = request.target(bridgeId);
+        bool answer = valid && request.isSearch() && target != SsdpRequest::TARGET_NONE;
+        answered += answer;
+        printf("%2d %-6s %-8s discover %-3s mx %3d  st %-40.*s %-16s %s\n",
+            (int)i, valid ? "valid" : "bad", methodNames[request.method()], request.isSearch() ? "yes" : "no",
+            request.mx(), (int)request.stLength(), request.st() ? request.st() : "",
+            targetNames[target], answer ? "answer" : "ignore");
+    }
+
+    unsigned long sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long n = 0; n < iterations; n++)
+    {
+        const std::string & packet = packets[n % packets.size()];
+        SsdpRequest request;
+        if (request.parse(packet.data(), packet.size()))
+        {
+            sink += request.target(bridgeId) + request.mx();
+        }
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    printf("\n%d of %d packets answered, %ld parses, %.1f ns per packet (%lu)\n",
+        answered, (int)packets.size(), iterations, iterations > 0 ? ns / iterations : 0.0, sink);
+    return 0;
+}
+
+#endif